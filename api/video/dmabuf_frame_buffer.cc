@@ -0,0 +1,72 @@
+/*
+ * dmabuf_frame_buffer.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "dmabuf_frame_buffer.h"
+
+#include <memory>
+#include <utility>
+
+#include "base/checks.h"
+
+namespace ave {
+
+// static
+std::shared_ptr<DmaBufFrameBuffer> DmaBufFrameBuffer::Create(
+    std::vector<Plane> planes,
+    std::shared_ptr<VideoFrameBuffer> mapped_buffer) {
+  return std::make_shared<DmaBufFrameBuffer>(std::move(planes),
+                                             std::move(mapped_buffer));
+}
+
+DmaBufFrameBuffer::DmaBufFrameBuffer(
+    std::vector<Plane> planes,
+    std::shared_ptr<VideoFrameBuffer> mapped_buffer,
+    protect_parameter)
+    : planes_(std::move(planes)), mapped_buffer_(std::move(mapped_buffer)) {
+  AVE_DCHECK(!planes_.empty());
+  AVE_DCHECK(mapped_buffer_ != nullptr);
+}
+
+DmaBufFrameBuffer::~DmaBufFrameBuffer() = default;
+
+VideoFrameBuffer::Type DmaBufFrameBuffer::type() const {
+  return Type::kDmaBuf;
+}
+
+VideoFrameBuffer::PixelFormat DmaBufFrameBuffer::pixel_format() const {
+  return mapped_buffer_->pixel_format();
+}
+
+size_t DmaBufFrameBuffer::width() const {
+  return mapped_buffer_->width();
+}
+
+size_t DmaBufFrameBuffer::height() const {
+  return mapped_buffer_->height();
+}
+
+std::shared_ptr<I420BufferInterface> DmaBufFrameBuffer::ToI420() {
+  return mapped_buffer_->ToI420();
+}
+
+const I420BufferInterface* DmaBufFrameBuffer::GetI420() const {
+  return mapped_buffer_->GetI420();
+}
+
+std::shared_ptr<VideoFrameBuffer> DmaBufFrameBuffer::CropAndScale(
+    size_t offset_x,
+    size_t offset_y,
+    size_t crop_width,
+    size_t crop_height,
+    size_t scaled_width,
+    size_t scaled_height) {
+  return mapped_buffer_->CropAndScale(offset_x, offset_y, crop_width,
+                                      crop_height, scaled_width,
+                                      scaled_height);
+}
+
+}  // namespace ave
@@ -0,0 +1,77 @@
+/*
+ * dmabuf_frame_buffer.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef DMABUF_FRAME_BUFFER_H
+#define DMABUF_FRAME_BUFFER_H
+
+#include <memory>
+#include <vector>
+
+#include "api/video/video_frame_buffer.h"
+
+namespace ave {
+
+// A frame backed by dma-bufs, one per memory plane, e.g. a v4l2 capture
+// buffer exported with VIDIOC_EXPBUF. Consumers able to import dma-bufs use
+// fd() directly, all others go through the cpu mapping in mapped_buffer().
+//
+// The fds are owned by the producer and stay valid while this buffer is
+// alive, dup() them to keep them longer.
+class DmaBufFrameBuffer : public VideoFrameBuffer {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  struct Plane {
+    int fd;
+    size_t size;
+  };
+
+  static std::shared_ptr<DmaBufFrameBuffer> Create(
+      std::vector<Plane> planes,
+      std::shared_ptr<VideoFrameBuffer> mapped_buffer);
+
+  DmaBufFrameBuffer(std::vector<Plane> planes,
+                    std::shared_ptr<VideoFrameBuffer> mapped_buffer,
+                    protect_parameter = protect_parameter());
+  ~DmaBufFrameBuffer() override;
+
+  Type type() const override;
+  PixelFormat pixel_format() const override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+  const I420BufferInterface* GetI420() const override;
+
+  std::shared_ptr<VideoFrameBuffer> CropAndScale(size_t offset_x,
+                                                 size_t offset_y,
+                                                 size_t crop_width,
+                                                 size_t crop_height,
+                                                 size_t scaled_width,
+                                                 size_t scaled_height) override;
+
+  size_t num_planes() const { return planes_.size(); }
+  int fd(size_t plane = 0) const { return planes_[plane].fd; }
+  size_t size(size_t plane = 0) const { return planes_[plane].size; }
+
+  const std::shared_ptr<VideoFrameBuffer>& mapped_buffer() const {
+    return mapped_buffer_;
+  }
+
+ private:
+  const std::vector<Plane> planes_;
+  const std::shared_ptr<VideoFrameBuffer> mapped_buffer_;
+};
+
+}  // namespace ave
+
+#endif /* !DMABUF_FRAME_BUFFER_H */
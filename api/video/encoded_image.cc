@@ -47,6 +47,14 @@ size_t EncodedImageBuffer::Size() const {
   return size_;
 }
 
+void EncodedImageBuffer::Realloc(size_t size) {
+  uint8_t* buffer = static_cast<uint8_t*>(realloc(buffer_, size));
+  // realloc() to size 0 may free the buffer and return nullptr
+  AVE_CHECK(buffer != nullptr || size == 0);
+  buffer_ = buffer;
+  size_ = size;
+}
+
 EncodedImage::EncodedImage() = default;
 EncodedImage::EncodedImage(EncodedImage&& rhs) = default;
 EncodedImage::EncodedImage(const EncodedImage& rhs) = default;
@@ -8,10 +8,12 @@
 #ifndef ENCODED_IMAGE_H
 #define ENCODED_IMAGE_H
 
+#include <memory>
 #include <optional>
 
 #include <stdint.h>
 
+#include "api/video/frame_metadata.h"
 #include "api/video/video_frame_type.h"
 #include "base/checks.h"
 #include "base/types.h"
@@ -51,6 +53,9 @@ class EncodedImageBuffer : public EncodedImageBufferInterface {
   uint8_t* Data() override;
   size_t Size() const override;
 
+  // resizes the buffer, the contents are kept up to the smaller size
+  void Realloc(size_t size);
+
  protected:
   size_t size_;
   uint8_t* buffer_;
@@ -71,6 +76,12 @@ class EncodedImage {
 
   void SetEncodeTime(int64_t encode_start_ms, int64_t encode_finish_ms);
 
+  // metadata of the frame this image was encoded from
+  void SetMetadata(std::shared_ptr<FrameMetadata> metadata) {
+    metadata_ = std::move(metadata);
+  }
+  const std::shared_ptr<FrameMetadata>& Metadata() const { return metadata_; }
+
   size_t Size() const { return size_; }
 
   void SetSize(size_t new_size) {
@@ -109,6 +120,7 @@ class EncodedImage {
   std::shared_ptr<EncodedImageBuffer> encoded_data_;
   size_t size_ = 0;  // Size of encoded frame data.
   uint64_t timestamp_us_ = 0;
+  std::shared_ptr<FrameMetadata> metadata_;
 };
 
 }  // namespace ave
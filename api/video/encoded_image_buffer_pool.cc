@@ -0,0 +1,75 @@
+/*
+ * encoded_image_buffer_pool.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "encoded_image_buffer_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace ave {
+
+namespace {
+// Only the pool copies its shared pointers, so a use count of one means no
+// EncodedImage holds the buffer any more. The fence orders the last user's
+// accesses, released with the count, before the pool writes the buffer.
+bool IsFree(const std::shared_ptr<EncodedImageBuffer>& buffer) {
+  if (buffer.use_count() != 1) {
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return true;
+}
+}  // namespace
+
+EncodedImageBufferPool::EncodedImageBufferPool(size_t max_buffers)
+    : max_buffers_(max_buffers) {}
+
+EncodedImageBufferPool::~EncodedImageBufferPool() = default;
+
+std::shared_ptr<EncodedImageBuffer> EncodedImageBufferPool::Acquire(
+    size_t size) {
+  lock_guard l(&lock_);
+  stats_.high_water_mark = std::max(stats_.high_water_mark, size);
+
+  std::shared_ptr<EncodedImageBuffer>* free_buffer = nullptr;
+  for (auto& buffer : buffers_) {
+    if (!IsFree(buffer)) {
+      continue;
+    }
+    if (buffer->Size() >= size) {
+      stats_.hits++;
+      return buffer;
+    }
+    free_buffer = &buffer;
+  }
+
+  stats_.allocations++;
+  if (free_buffer != nullptr) {
+    // too small for this frame, grow it once for all the ones to come
+    (*free_buffer)->Realloc(stats_.high_water_mark);
+    return *free_buffer;
+  }
+  if (buffers_.size() < max_buffers_) {
+    buffers_.push_back(EncodedImageBuffer::Create(stats_.high_water_mark));
+    stats_.buffers = buffers_.size();
+    return buffers_.back();
+  }
+  return EncodedImageBuffer::Create(size);
+}
+
+void EncodedImageBufferPool::Release() {
+  lock_guard l(&lock_);
+  buffers_.clear();
+  stats_.buffers = 0;
+}
+
+EncodedImageBufferPool::Stats EncodedImageBufferPool::stats() const {
+  lock_guard l(&lock_);
+  return stats_;
+}
+
+}  // namespace ave
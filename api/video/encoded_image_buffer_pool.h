@@ -0,0 +1,64 @@
+/*
+ * encoded_image_buffer_pool.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef ENCODED_IMAGE_BUFFER_POOL_H
+#define ENCODED_IMAGE_BUFFER_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "api/video/encoded_image.h"
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
+
+namespace ave {
+
+// Recycles the output buffers of an encoder. A buffer is free again once
+// the last EncodedImage sharing it is gone, e.g. after the rtsp server sent
+// it. Buffers grow to the largest frame seen so far, so once the first key
+// frames went through, a steady stream encodes without allocating.
+// At most `max_buffers` buffers are pooled, when all of them are still held
+// downstream an unpooled buffer is handed out.
+// Thread safe.
+class EncodedImageBufferPool {
+ public:
+  struct Stats {
+    // buffers handed out without allocating
+    uint64_t hits = 0;
+    // buffers allocated or grown
+    uint64_t allocations = 0;
+    // pooled buffers, free or in use
+    size_t buffers = 0;
+    // largest size asked for, every pooled buffer grows to it
+    size_t high_water_mark = 0;
+  };
+
+  static constexpr size_t kDefaultMaxBuffers = 8;
+
+  explicit EncodedImageBufferPool(size_t max_buffers = kDefaultMaxBuffers);
+  ~EncodedImageBufferPool();
+
+  // a buffer of at least `size` bytes, its Size() is its capacity
+  std::shared_ptr<EncodedImageBuffer> Acquire(size_t size);
+
+  // drops the pooled buffers, the ones in use are freed by their last user
+  void Release();
+
+  Stats stats() const;
+
+ private:
+  const size_t max_buffers_;
+
+  mutable Mutex lock_;
+  std::vector<std::shared_ptr<EncodedImageBuffer>> buffers_ GUARDED_BY(lock_);
+  Stats stats_ GUARDED_BY(lock_);
+};
+
+}  // namespace ave
+
+#endif /* !ENCODED_IMAGE_BUFFER_POOL_H */
@@ -0,0 +1,107 @@
+/*
+ * frame_metadata.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "frame_metadata.h"
+
+#include <utility>
+
+namespace ave {
+
+// static
+std::shared_ptr<FrameMetadata> FrameMetadata::Create() {
+  return std::make_shared<FrameMetadata>();
+}
+
+FrameMetadata::FrameMetadata(protect_parameter p) {}
+
+FrameMetadata::~FrameMetadata() = default;
+
+std::shared_ptr<FrameMetadata> FrameMetadata::Fork() const {
+  auto fork = Create();
+  lock_guard l(&lock_);
+  lock_guard fork_lock(&fork->lock_);
+  for (Stage stage : {Stage::kCapture, Stage::kDequeue}) {
+    fork->stage_times_[static_cast<size_t>(stage)] =
+        stage_times_[static_cast<size_t>(stage)];
+  }
+  fork->source_sequence_ = source_sequence_;
+  if (values_) {
+    fork->values_ = std::make_unique<std::map<std::string, Value>>(*values_);
+  }
+  return fork;
+}
+
+void FrameMetadata::SetStageTime(Stage stage, int64_t time_us) {
+  lock_guard l(&lock_);
+  stage_times_[static_cast<size_t>(stage)] = time_us;
+}
+
+std::optional<int64_t> FrameMetadata::StageTime(Stage stage) const {
+  lock_guard l(&lock_);
+  return stage_times_[static_cast<size_t>(stage)];
+}
+
+std::optional<int64_t> FrameMetadata::StageDelta(Stage from, Stage to) const {
+  lock_guard l(&lock_);
+  const auto& from_us = stage_times_[static_cast<size_t>(from)];
+  const auto& to_us = stage_times_[static_cast<size_t>(to)];
+  if (!from_us || !to_us) {
+    return std::nullopt;
+  }
+  return *to_us - *from_us;
+}
+
+void FrameMetadata::SetSourceSequence(int64_t sequence) {
+  lock_guard l(&lock_);
+  source_sequence_ = sequence;
+}
+
+std::optional<int64_t> FrameMetadata::SourceSequence() const {
+  lock_guard l(&lock_);
+  return source_sequence_;
+}
+
+void FrameMetadata::Set(const std::string& key, Value value) {
+  lock_guard l(&lock_);
+  if (!values_) {
+    values_ = std::make_unique<std::map<std::string, Value>>();
+  }
+  (*values_)[key] = std::move(value);
+}
+
+bool FrameMetadata::Has(const std::string& key) const {
+  lock_guard l(&lock_);
+  return values_ && values_->count(key) > 0;
+}
+
+void FrameMetadata::Remove(const std::string& key) {
+  lock_guard l(&lock_);
+  if (values_) {
+    values_->erase(key);
+  }
+}
+
+// static
+const char* FrameMetadata::StageToString(Stage stage) {
+  switch (stage) {
+    case Stage::kCapture:
+      return "capture";
+    case Stage::kDequeue:
+      return "dequeue";
+    case Stage::kDeliver:
+      return "deliver";
+    case Stage::kEncodeStart:
+      return "encode_start";
+    case Stage::kEncodeFinish:
+      return "encode_finish";
+    case Stage::kSend:
+      return "send";
+  }
+  return "unknown";
+}
+
+}  // namespace ave
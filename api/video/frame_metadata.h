@@ -0,0 +1,112 @@
+/*
+ * frame_metadata.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef FRAME_METADATA_H
+#define FRAME_METADATA_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
+
+namespace ave {
+
+// Side channel of a captured frame. VideoFrame and EncodedImage hold it by
+// shared_ptr, so copies of the frame and their encoded images see the same
+// metadata instead of copying it along. Copies going down a stream of their
+// own, the scaled and digitally zoomed ones, get a Fork() instead, so each
+// stream stamps its own deliver, encode and send stages.
+// Thread safe, sinks of a fan-out may write concurrently, the last write of
+// a key or stage wins. What every captured frame carries, the stage times and
+// the source sequence, is stored inline, the key/value map is only allocated
+// once a custom key is set.
+class FrameMetadata {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  // pipeline stages, in the order a frame passes them
+  enum class Stage {
+    // exposure time reported by the driver
+    kCapture = 0,
+    // dequeued from the driver
+    kDequeue,
+    // handed from the capturer to its sinks
+    kDeliver,
+    kEncodeStart,
+    kEncodeFinish,
+    // pushed to the transport
+    kSend,
+  };
+  static constexpr size_t kStageCount = static_cast<size_t>(Stage::kSend) + 1;
+
+  using Value = std::variant<int64_t, double, std::string>;
+
+  static std::shared_ptr<FrameMetadata> Create();
+
+  explicit FrameMetadata(protect_parameter p = protect_parameter());
+  ~FrameMetadata();
+
+  FrameMetadata(const FrameMetadata&) = delete;
+  FrameMetadata& operator=(const FrameMetadata&) = delete;
+
+  // A new metadata with the capture side of this one, the kCapture and
+  // kDequeue stages, the source sequence and the custom keys. The later
+  // stages are left unset for the new stream to stamp.
+  std::shared_ptr<FrameMetadata> Fork() const;
+
+  // stage timestamps, system monotonic clock in microseconds like
+  // VideoFrame::timestamp_us()
+  void SetStageTime(Stage stage, int64_t time_us);
+  std::optional<int64_t> StageTime(Stage stage) const;
+  // time from `from` to `to`, nullopt unless both were stamped
+  std::optional<int64_t> StageDelta(Stage from, Stage to) const;
+
+  // frame counter of the source, gaps are frames it lost
+  void SetSourceSequence(int64_t sequence);
+  std::optional<int64_t> SourceSequence() const;
+
+  void Set(const std::string& key, Value value);
+  // nullopt if `key` is unset or holds another type
+  template <typename T>
+  std::optional<T> Get(const std::string& key) const {
+    lock_guard l(&lock_);
+    if (!values_) {
+      return std::nullopt;
+    }
+    auto it = values_->find(key);
+    if (it == values_->end() || !std::holds_alternative<T>(it->second)) {
+      return std::nullopt;
+    }
+    return std::get<T>(it->second);
+  }
+  bool Has(const std::string& key) const;
+  void Remove(const std::string& key);
+
+  static const char* StageToString(Stage stage);
+
+ private:
+  mutable Mutex lock_;
+  std::array<std::optional<int64_t>, kStageCount> stage_times_
+      GUARDED_BY(lock_);
+  std::optional<int64_t> source_sequence_ GUARDED_BY(lock_);
+  // created by the first Set()
+  std::unique_ptr<std::map<std::string, Value>> values_ GUARDED_BY(lock_);
+};
+
+}  // namespace ave
+
+#endif /* !FRAME_METADATA_H */
@@ -8,8 +8,11 @@
 #include "i420_buffer.h"
 
 #include <memory>
+#include <utility>
 
+#include "api/video/yuyv_scale.h"
 #include "base/checks.h"
+#include "base/memory/aligned_memory.h"
 #include "third_party/libyuv/include/libyuv.h"
 
 namespace ave {
@@ -41,8 +44,9 @@ I420Buffer::I420Buffer(size_t width,
       stride_u_(stride_u),
       stride_v_(stride_v),
       data_(static_cast<uint8_t*>(base::AlignedMalloc(
-          I420DataSize(height, stride_y, stride_u, stride_v),
-          kBufferAlignment))) {
+                I420DataSize(height, stride_y, stride_u, stride_v),
+                kBufferAlignment)),
+            base::AlignedFreeDeleter()) {
   AVE_DCHECK_GT(width, 0);
   AVE_DCHECK_GT(height, 0);
   AVE_DCHECK_GE(stride_y, width);
@@ -50,11 +54,32 @@ I420Buffer::I420Buffer(size_t width,
   AVE_DCHECK_GE(stride_v, (width + 1) / 2);
 }
 
+I420Buffer::I420Buffer(size_t width,
+                       size_t height,
+                       size_t stride_y,
+                       size_t stride_u,
+                       size_t stride_v,
+                       FrameBufferMemory data,
+                       protect_parameter)
+    : width_(width),
+      height_(height),
+      stride_y_(stride_y),
+      stride_u_(stride_u),
+      stride_v_(stride_v),
+      data_(std::move(data)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride_y, width);
+  AVE_DCHECK_GE(stride_u, (width + 1) / 2);
+  AVE_DCHECK_GE(stride_v, (width + 1) / 2);
+  AVE_DCHECK(data_ != nullptr);
+}
+
 I420Buffer::~I420Buffer() {}
 
 // static
 std::shared_ptr<I420Buffer> I420Buffer::Create(size_t width, size_t height) {
-  return std::make_shared<I420Buffer>(width, height);
+  return Create(width, height, width, (width + 1) / 2, (width + 1) / 2);
 }
 
 // static
@@ -63,8 +88,8 @@ std::shared_ptr<I420Buffer> I420Buffer::Create(size_t width,
                                                size_t stride_y,
                                                size_t stride_u,
                                                size_t stride_v) {
-  return std::make_shared<I420Buffer>(width, height, stride_y, stride_u,
-                                      stride_v);
+  return VideoFrameBufferPool::Default()->CreateI420Buffer(
+      width, height, stride_y, stride_u, stride_v);
 }
 
 std::shared_ptr<I420Buffer> I420Buffer::Copy(
@@ -177,6 +202,44 @@ void I420Buffer::CropAndScaleFrom(const I420BufferInterface& src,
   AVE_CHECK_EQ(res, 0);
 }
 
+void I420Buffer::CropAndScaleFrom(const YUYVBufferInterface& src,
+                                  size_t offset_x,
+                                  size_t offset_y,
+                                  size_t crop_width,
+                                  size_t crop_height) {
+  AVE_CHECK_LE(crop_width, src.width());
+  AVE_CHECK_LE(crop_height, src.height());
+  AVE_CHECK_LE(crop_width + offset_x, src.width());
+  AVE_CHECK_LE(crop_height + offset_y, src.height());
+
+  // a pixel pair shares its chroma, start the crop on a pair
+  offset_x = offset_x / 2 * 2;
+
+  const uint8_t* data = src.Data() + src.Stride() * offset_y + offset_x * 2;
+  ScaleYUYVToI420(data, src.Stride(), crop_width, crop_height, MutableDataY(),
+                  StrideY(), MutableDataU(), StrideU(), MutableDataV(),
+                  StrideV(), width(), height());
+}
+
+void I420Buffer::CropAndScaleFrom(const UYVYBufferInterface& src,
+                                  size_t offset_x,
+                                  size_t offset_y,
+                                  size_t crop_width,
+                                  size_t crop_height) {
+  AVE_CHECK_LE(crop_width, src.width());
+  AVE_CHECK_LE(crop_height, src.height());
+  AVE_CHECK_LE(crop_width + offset_x, src.width());
+  AVE_CHECK_LE(crop_height + offset_y, src.height());
+
+  // a pixel pair shares its chroma, start the crop on a pair
+  offset_x = offset_x / 2 * 2;
+
+  const uint8_t* data = src.Data() + src.Stride() * offset_y + offset_x * 2;
+  ScaleUYVYToI420(data, src.Stride(), crop_width, crop_height, MutableDataY(),
+                  StrideY(), MutableDataU(), StrideU(), MutableDataV(),
+                  StrideV(), width(), height());
+}
+
 void I420Buffer::CropAndScaleFrom(const I420BufferInterface& src) {
   const int crop_width =
       height() > 0 ? std::min(src.width(), width() * src.height() / height())
@@ -9,11 +9,12 @@
 #define I420_BUFFER_H
 
 #include "api/video/video_frame_buffer.h"
-#include "base/memory/aligned_memory.h"
+#include "api/video/video_frame_buffer_pool.h"
 
 namespace ave {
 
-// Plain I420 buffer in standard memory.
+// Plain I420 buffer in standard memory, Create() allocates it from
+// VideoFrameBufferPool::Default().
 class I420Buffer : public I420BufferInterface {
  protected:
   // for private construct
@@ -50,6 +51,14 @@ class I420Buffer : public I420BufferInterface {
              size_t stride_u,
              size_t stride_v,
              protect_parameter = protect_parameter());
+  // takes `data`, e.g. recycled by a VideoFrameBufferPool
+  I420Buffer(size_t width,
+             size_t height,
+             size_t stride_y,
+             size_t stride_u,
+             size_t stride_v,
+             FrameBufferMemory data,
+             protect_parameter = protect_parameter());
 
   ~I420Buffer() override;
 
@@ -77,6 +86,20 @@ class I420Buffer : public I420BufferInterface {
                         size_t crop_width,
                         size_t crop_height);
 
+  // Same from packed YUYV, converts and scales in a single pass.
+  void CropAndScaleFrom(const YUYVBufferInterface& src,
+                        size_t offset_x,
+                        size_t offset_y,
+                        size_t crop_width,
+                        size_t crop_height);
+
+  // Same from packed UYVY.
+  void CropAndScaleFrom(const UYVYBufferInterface& src,
+                        size_t offset_x,
+                        size_t offset_y,
+                        size_t crop_width,
+                        size_t crop_height);
+
   // The common case of a center crop, when needed to adjust the
   // aspect ratio without distorting the image.
   void CropAndScaleFrom(const I420BufferInterface& src);
@@ -90,7 +113,7 @@ class I420Buffer : public I420BufferInterface {
   const size_t stride_y_;
   const size_t stride_u_;
   const size_t stride_v_;
-  const std::unique_ptr<uint8_t, base::AlignedFreeDeleter> data_;
+  const FrameBufferMemory data_;
 };
 
 }  // namespace ave
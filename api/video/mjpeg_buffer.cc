@@ -0,0 +1,96 @@
+/*
+ * mjpeg_buffer.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "mjpeg_buffer.h"
+
+#include <memory>
+#include <utility>
+
+#include "base/checks.h"
+#include "base/logging.h"
+#include "third_party/libyuv/include/libyuv.h"
+
+namespace ave {
+
+// static
+std::shared_ptr<MJPEGBuffer> MJPEGBuffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* data,
+    size_t size,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<MJPEGBuffer>(width, height, data, size,
+                                       std::move(no_longer_used));
+}
+
+MJPEGBuffer::MJPEGBuffer(size_t width,
+                         size_t height,
+                         const uint8_t* data,
+                         size_t size,
+                         std::function<void()> no_longer_used,
+                         protect_parameter)
+    : width_(width),
+      height_(height),
+      data_(data),
+      size_(size),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+}
+
+MJPEGBuffer::~MJPEGBuffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type MJPEGBuffer::type() const {
+  return Type::kHardware;
+}
+
+VideoFrameBuffer::PixelFormat MJPEGBuffer::pixel_format() const {
+  return PixelFormat::kMJPEG;
+}
+
+size_t MJPEGBuffer::width() const {
+  return width_;
+}
+
+size_t MJPEGBuffer::height() const {
+  return height_;
+}
+
+std::shared_ptr<I420BufferInterface> MJPEGBuffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> decoded = I420Buffer::Create(width_, height_);
+    // mjpeg -> i420
+    if (libyuv::MJPGToI420(data_, size_, decoded->MutableDataY(),
+                           decoded->StrideY(), decoded->MutableDataU(),
+                           decoded->StrideU(), decoded->MutableDataV(),
+                           decoded->StrideV(), width_, height_, width_,
+                           height_) != 0) {
+      AVE_LOG(LS_WARNING) << "failed to decode " << size_
+                          << " bytes mjpeg frame";
+      I420Buffer::SetBlack(decoded.get());
+    }
+    return decoded;
+  });
+}
+
+void MJPEGBuffer::Decode() {
+  ToI420();
+}
+
+const uint8_t* MJPEGBuffer::Data() const {
+  return data_;
+}
+
+size_t MJPEGBuffer::size() const {
+  return size_;
+}
+
+}  // namespace ave
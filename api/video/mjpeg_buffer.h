@@ -0,0 +1,72 @@
+/*
+ * mjpeg_buffer.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef MJPEG_BUFFER_H
+#define MJPEG_BUFFER_H
+
+#include <functional>
+#include <memory>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame_buffer.h"
+
+namespace ave {
+
+// A compressed motion-jpeg frame, e.g. borrowed from a mmap'd v4l2 capture
+// buffer. The payload is decoded at most once, on the first ToI420() or by an
+// earlier Decode() issued from a worker thread, whichever comes first; later
+// calls share the decoded picture.
+class MJPEGBuffer : public VideoFrameBuffer {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<MJPEGBuffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* data,
+      size_t size,
+      std::function<void()> no_longer_used);
+
+  MJPEGBuffer(size_t width,
+              size_t height,
+              const uint8_t* data,
+              size_t size,
+              std::function<void()> no_longer_used,
+              protect_parameter = protect_parameter());
+  ~MJPEGBuffer() override;
+
+  Type type() const override;
+  PixelFormat pixel_format() const override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  // Returns the decoded picture, a black one if the payload is corrupt.
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  // Decodes ahead of ToI420(), safe to call from any thread.
+  void Decode();
+
+  // compressed payload
+  const uint8_t* Data() const;
+  size_t size() const;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const data_;
+  const size_t size_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+}  // namespace ave
+
+#endif /* !MJPEG_BUFFER_H */
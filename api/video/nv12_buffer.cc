@@ -8,10 +8,13 @@
 #include "nv12_buffer.h"
 
 #include <memory>
+#include <utility>
 
 #include "api/video/i420_buffer.h"
 #include "api/video/video_frame_buffer.h"
+#include "api/video/yuyv_scale.h"
 #include "base/checks.h"
+#include "base/memory/aligned_memory.h"
 #include "third_party/libyuv/include/libyuv.h"
 #include "third_party/libyuv/include/libyuv/planar_functions.h"
 
@@ -40,19 +43,38 @@ NV12Buffer::NV12Buffer(size_t width,
       stride_y_(stride_y),
       stride_uv_(stride_uv),
       data_(static_cast<uint8_t*>(
-          base::AlignedMalloc(NV12DataSize(height_, stride_y_, stride_uv),
-                              kBufferAlignment))) {
+                base::AlignedMalloc(NV12DataSize(height_, stride_y_, stride_uv),
+                                    kBufferAlignment)),
+            base::AlignedFreeDeleter()) {
   AVE_DCHECK_GT(width, 0);
   AVE_DCHECK_GT(height, 0);
   AVE_DCHECK_GE(stride_y, width);
   AVE_DCHECK_GE(stride_uv, (width + width % 2));
 }
 
+NV12Buffer::NV12Buffer(size_t width,
+                       size_t height,
+                       size_t stride_y,
+                       size_t stride_uv,
+                       FrameBufferMemory data,
+                       protect_parameter)
+    : width_(width),
+      height_(height),
+      stride_y_(stride_y),
+      stride_uv_(stride_uv),
+      data_(std::move(data)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride_y, width);
+  AVE_DCHECK_GE(stride_uv, (width + width % 2));
+  AVE_DCHECK(data_ != nullptr);
+}
+
 NV12Buffer::~NV12Buffer() = default;
 
 // static
 std::shared_ptr<NV12Buffer> NV12Buffer::Create(size_t width, size_t height) {
-  return std::make_shared<NV12Buffer>(width, height);
+  return Create(width, height, width, width + width % 2);
 }
 
 // static
@@ -60,7 +82,8 @@ std::shared_ptr<NV12Buffer> NV12Buffer::Create(size_t width,
                                                size_t height,
                                                size_t stride_y,
                                                size_t stride_uv) {
-  return std::make_shared<NV12Buffer>(width, height, stride_y, stride_uv);
+  return VideoFrameBufferPool::Default()->CreateNV12Buffer(width, height,
+                                                           stride_y, stride_uv);
 }
 
 // static
@@ -92,13 +115,15 @@ std::shared_ptr<NV12Buffer> NV12Buffer::Copy(const uint8_t* data_y,
 }
 
 std::shared_ptr<I420BufferInterface> NV12Buffer::ToI420() {
-  std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
-  // nv12 -> i420
-  libyuv::NV12ToI420(
-      DataY(), StrideY(), DataUV(), StrideUV(), buffer->MutableDataY(),
-      buffer->StrideY(), buffer->MutableDataU(), buffer->StrideU(),
-      buffer->MutableDataV(), buffer->StrideV(), width_, height_);
-  return buffer;
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // nv12 -> i420
+    libyuv::NV12ToI420(
+        DataY(), StrideY(), DataUV(), StrideUV(), buffer->MutableDataY(),
+        buffer->StrideY(), buffer->MutableDataU(), buffer->StrideU(),
+        buffer->MutableDataV(), buffer->StrideV(), width_, height_);
+    return buffer;
+  });
 }
 
 size_t NV12Buffer::width() const {
@@ -126,10 +151,12 @@ const uint8_t* NV12Buffer::DataUV() const {
 }
 
 uint8_t* NV12Buffer::MutableDataY() {
+  ResetCachedI420();
   return data_.get();
 }
 
 uint8_t* NV12Buffer::MutableDataUV() {
+  ResetCachedI420();
   return data_.get() + stride_y_ * height_;
 }
 
@@ -163,4 +190,52 @@ void NV12Buffer::CropAndScaleFrom(const NV12BufferInterface& src,
   AVE_DCHECK_EQ(res, 0);
 }
 
+void NV12Buffer::CropAndScaleFrom(const NV21BufferInterface& src,
+                                  size_t offset_x,
+                                  size_t offset_y,
+                                  size_t crop_width,
+                                  size_t crop_height) {
+  AVE_CHECK_LE(crop_width, src.width());
+  AVE_CHECK_LE(crop_height, src.height());
+  AVE_CHECK_LE(crop_width + offset_x, src.width());
+  AVE_CHECK_LE(crop_height + offset_y, src.height());
+
+  // Make sure offset is even so that u/v plane becomes aligned.
+  const int uv_offset_x = offset_x / 2;
+  const int uv_offset_y = offset_y / 2;
+  offset_x = uv_offset_x * 2;
+  offset_y = uv_offset_y * 2;
+
+  const uint8_t* y_plane = src.DataY() + src.StrideY() * offset_y + offset_x;
+  const uint8_t* vu_plane =
+      src.DataUV() + src.StrideUV() * uv_offset_y + uv_offset_x * 2;
+
+  // the scaler doesn't care about the chroma order
+  int res = libyuv::NV12Scale(y_plane, src.StrideY(), vu_plane, src.StrideUV(),
+                              crop_width, crop_height, MutableDataY(),
+                              StrideY(), MutableDataUV(), StrideUV(), width(),
+                              height(), libyuv::kFilterBox);
+  AVE_DCHECK_EQ(res, 0);
+  libyuv::SwapUVPlane(DataUV(), StrideUV(), MutableDataUV(), StrideUV(),
+                      ChromaWidth(), ChromaHeight());
+}
+
+void NV12Buffer::CropAndScaleFrom(const YUYVBufferInterface& src,
+                                  size_t offset_x,
+                                  size_t offset_y,
+                                  size_t crop_width,
+                                  size_t crop_height) {
+  AVE_CHECK_LE(crop_width, src.width());
+  AVE_CHECK_LE(crop_height, src.height());
+  AVE_CHECK_LE(crop_width + offset_x, src.width());
+  AVE_CHECK_LE(crop_height + offset_y, src.height());
+
+  // a pixel pair shares its chroma, start the crop on a pair
+  offset_x = offset_x / 2 * 2;
+
+  const uint8_t* data = src.Data() + src.Stride() * offset_y + offset_x * 2;
+  ScaleYUYVToNV12(data, src.Stride(), crop_width, crop_height, MutableDataY(),
+                  StrideY(), MutableDataUV(), StrideUV(), width(), height());
+}
+
 }  // namespace ave
@@ -9,7 +9,7 @@
 #define NV12_BUFFER_H
 
 #include "api/video/video_frame_buffer.h"
-#include "base/memory/aligned_memory.h"
+#include "api/video/video_frame_buffer_pool.h"
 
 namespace ave {
 
@@ -49,6 +49,13 @@ class NV12Buffer : public NV12BufferInterface {
              size_t stride_y,
              size_t stride_uv,
              protect_parameter = protect_parameter());
+  // takes `data`, e.g. recycled by a VideoFrameBufferPool
+  NV12Buffer(size_t width,
+             size_t height,
+             size_t stride_y,
+             size_t stride_uv,
+             FrameBufferMemory data,
+             protect_parameter = protect_parameter());
 
   ~NV12Buffer() override;
 
@@ -74,12 +81,26 @@ class NV12Buffer : public NV12BufferInterface {
                         size_t crop_width,
                         size_t crop_height);
 
+  // Same from NV21, the chroma is swapped to UV on the scaled picture.
+  void CropAndScaleFrom(const NV21BufferInterface& src,
+                        size_t offset_x,
+                        size_t offset_y,
+                        size_t crop_width,
+                        size_t crop_height);
+
+  // Same from packed YUYV, converts and scales in a single pass.
+  void CropAndScaleFrom(const YUYVBufferInterface& src,
+                        size_t offset_x,
+                        size_t offset_y,
+                        size_t crop_width,
+                        size_t crop_height);
+
  private:
   const size_t width_;
   const size_t height_;
   const size_t stride_y_;
   const size_t stride_uv_;
-  const std::unique_ptr<uint8_t, base::AlignedFreeDeleter> data_;
+  const FrameBufferMemory data_;
 };
 
 }  // namespace ave
@@ -0,0 +1,153 @@
+/*
+ * pixel_ops.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "pixel_ops.h"
+
+#include <cstring>
+
+#include "api/video/pixel_ops_internal.h"
+
+namespace ave {
+namespace pixel_ops {
+
+namespace {
+
+bool ScalarEqualRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  return EqualTail(a, b, width);
+}
+
+uint64_t ScalarSumRow(const uint8_t* data, size_t width) {
+  return SumTail(data, width);
+}
+
+uint64_t ScalarSadRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  return SadTail(a, b, width);
+}
+
+const Kernels& Selected() {
+  // the first supported one is the best
+  static const Kernels* kernels = SupportedKernels().front();
+  return *kernels;
+}
+
+}  // namespace
+
+const Kernels* ScalarKernels() {
+  static const Kernels kernels = {"scalar", ScalarEqualRow, ScalarSumRow,
+                                  ScalarSadRow};
+  return &kernels;
+}
+
+std::vector<const Kernels*> SupportedKernels() {
+  std::vector<const Kernels*> kernels;
+#if defined(OC_PIXEL_OPS_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    kernels.push_back(AVX2Kernels());
+  }
+#endif
+#if defined(OC_PIXEL_OPS_SSE2)
+  if (__builtin_cpu_supports("sse2")) {
+    kernels.push_back(SSE2Kernels());
+  }
+#endif
+#if defined(OC_PIXEL_OPS_NEON)
+  // built only where neon is part of the baseline
+  kernels.push_back(NeonKernels());
+#endif
+  kernels.push_back(ScalarKernels());
+  return kernels;
+}
+
+bool PlaneEqual(const uint8_t* a,
+                size_t stride_a,
+                const uint8_t* b,
+                size_t stride_b,
+                size_t width,
+                size_t height) {
+  const Kernels& kernels = Selected();
+  for (size_t row = 0; row < height; row++) {
+    if (!kernels.equal_row(a + row * stride_a, b + row * stride_b, width)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t PlaneSum(const uint8_t* data,
+                  size_t stride,
+                  size_t width,
+                  size_t height) {
+  const Kernels& kernels = Selected();
+  uint64_t sum = 0;
+  for (size_t row = 0; row < height; row++) {
+    sum += kernels.sum_row(data + row * stride, width);
+  }
+  return sum;
+}
+
+void PlaneHistogram(const uint8_t* data,
+                    size_t stride,
+                    size_t width,
+                    size_t height,
+                    uint32_t histogram[256]) {
+  // a scatter doesn't vectorize, four partial histograms break the store to
+  // load dependency of runs of equal samples instead
+  uint32_t partial[4][256];
+  memset(partial, 0, sizeof(partial));
+  for (size_t row = 0; row < height; row++) {
+    const uint8_t* line = data + row * stride;
+    size_t col = 0;
+    for (; col + 4 <= width; col += 4) {
+      partial[0][line[col]]++;
+      partial[1][line[col + 1]]++;
+      partial[2][line[col + 2]]++;
+      partial[3][line[col + 3]]++;
+    }
+    for (; col < width; col++) {
+      partial[0][line[col]]++;
+    }
+  }
+  for (size_t i = 0; i < 256; i++) {
+    histogram[i] =
+        partial[0][i] + partial[1][i] + partial[2][i] + partial[3][i];
+  }
+}
+
+uint64_t BlockSad(const uint8_t* a,
+                  size_t stride_a,
+                  const uint8_t* b,
+                  size_t stride_b,
+                  size_t width,
+                  size_t height) {
+  const Kernels& kernels = Selected();
+  uint64_t sad = 0;
+  for (size_t row = 0; row < height; row++) {
+    sad += kernels.sad_row(a + row * stride_a, b + row * stride_b, width);
+  }
+  return sad;
+}
+
+double MeanAbsoluteDifference(const uint8_t* a,
+                              size_t stride_a,
+                              const uint8_t* b,
+                              size_t stride_b,
+                              size_t width,
+                              size_t height) {
+  if (width == 0 || height == 0) {
+    return 0;
+  }
+  return static_cast<double>(
+             BlockSad(a, stride_a, b, stride_b, width, height)) /
+         static_cast<double>(width * height);
+}
+
+const char* ImplementationName() {
+  return Selected().name;
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
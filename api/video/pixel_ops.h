@@ -0,0 +1,65 @@
+/*
+ * pixel_ops.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef PIXEL_OPS_H
+#define PIXEL_OPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ave {
+namespace pixel_ops {
+
+// Plane statistics libyuv doesn't offer, e.g. for motion detection, exposure
+// hints or scene change key frames. The SSE2/AVX2/NEON kernel best for the
+// cpu is picked on first use, scalar code covers everything else.
+
+// Whether both planes hold the same bytes.
+bool PlaneEqual(const uint8_t* a,
+                size_t stride_a,
+                const uint8_t* b,
+                size_t stride_b,
+                size_t width,
+                size_t height);
+
+// Sum of all samples, e.g. divide by width * height for the mean luma.
+uint64_t PlaneSum(const uint8_t* data,
+                  size_t stride,
+                  size_t width,
+                  size_t height);
+
+// Overwrites `histogram` with the count of every sample value.
+void PlaneHistogram(const uint8_t* data,
+                    size_t stride,
+                    size_t width,
+                    size_t height,
+                    uint32_t histogram[256]);
+
+// Sum of absolute differences, e.g. of a 16x16 block against the previous
+// frame.
+uint64_t BlockSad(const uint8_t* a,
+                  size_t stride_a,
+                  const uint8_t* b,
+                  size_t stride_b,
+                  size_t width,
+                  size_t height);
+
+// BlockSad() over the whole plane divided by its size.
+double MeanAbsoluteDifference(const uint8_t* a,
+                              size_t stride_a,
+                              const uint8_t* b,
+                              size_t stride_b,
+                              size_t width,
+                              size_t height);
+
+// The kernels in use, "avx2", "sse2", "neon" or "scalar".
+const char* ImplementationName();
+
+}  // namespace pixel_ops
+}  // namespace ave
+
+#endif /* !PIXEL_OPS_H */
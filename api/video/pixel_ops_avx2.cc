@@ -0,0 +1,77 @@
+/*
+ * pixel_ops_avx2.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <immintrin.h>
+
+#include "api/video/pixel_ops_internal.h"
+
+namespace ave {
+namespace pixel_ops {
+
+namespace {
+
+// only these functions are built for avx2, everything else in the file, the
+// inline functions of the headers included, keeps the baseline target
+#define OC_TARGET_AVX2 __attribute__((target("avx2")))
+
+constexpr size_t kLanes = 32;
+
+// through memory, _mm_cvtsi128_si64() does not exist on 32-bit x86
+OC_TARGET_AVX2 uint64_t Reduce(__m256i sums) {
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+OC_TARGET_AVX2 bool EqualRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != -1) {
+      return false;
+    }
+  }
+  return EqualTail(a + i, b + i, width - i);
+}
+
+OC_TARGET_AVX2 uint64_t SumRow(const uint8_t* data, size_t width) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sums = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v, zero));
+  }
+  return Reduce(sums) + SumTail(data + i, width - i);
+}
+
+OC_TARGET_AVX2 uint64_t SadRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  __m256i sums = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    sums = _mm256_add_epi64(sums, _mm256_sad_epu8(va, vb));
+  }
+  return Reduce(sums) + SadTail(a + i, b + i, width - i);
+}
+
+}  // namespace
+
+const Kernels* AVX2Kernels() {
+  static const Kernels kernels = {"avx2", EqualRow, SumRow, SadRow};
+  return &kernels;
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
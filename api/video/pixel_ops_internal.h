@@ -0,0 +1,72 @@
+/*
+ * pixel_ops_internal.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef PIXEL_OPS_INTERNAL_H
+#define PIXEL_OPS_INTERNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace ave {
+namespace pixel_ops {
+
+// One implementation of the row kernels behind pixel_ops.h.
+struct Kernels {
+  const char* name;
+  // whether `a` and `b` hold the same `width` bytes
+  bool (*equal_row)(const uint8_t* a, const uint8_t* b, size_t width);
+  // sum of `width` samples
+  uint64_t (*sum_row)(const uint8_t* data, size_t width);
+  // sum of absolute differences of `width` samples
+  uint64_t (*sad_row)(const uint8_t* a, const uint8_t* b, size_t width);
+};
+
+const Kernels* ScalarKernels();
+#if defined(OC_PIXEL_OPS_SSE2)
+const Kernels* SSE2Kernels();
+#endif
+#if defined(OC_PIXEL_OPS_AVX2)
+const Kernels* AVX2Kernels();
+#endif
+#if defined(OC_PIXEL_OPS_NEON)
+const Kernels* NeonKernels();
+#endif
+
+// Every implementation the cpu runs, best first, scalar last.
+std::vector<const Kernels*> SupportedKernels();
+
+// Scalar tails of the simd kernels. Static, so every kernel file gets its
+// own copy built for its own target and the linker can't pick one built for
+// a newer cpu than the scalar path runs on.
+
+static inline bool EqualTail(const uint8_t* a, const uint8_t* b, size_t width) {
+  return width == 0 || memcmp(a, b, width) == 0;
+}
+
+static inline uint64_t SumTail(const uint8_t* data, size_t width) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < width; i++) {
+    sum += data[i];
+  }
+  return sum;
+}
+
+static inline uint64_t SadTail(const uint8_t* a, const uint8_t* b, size_t width) {
+  uint64_t sad = 0;
+  for (size_t i = 0; i < width; i++) {
+    sad += std::abs(a[i] - b[i]);
+  }
+  return sad;
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
+
+#endif /* !PIXEL_OPS_INTERNAL_H */
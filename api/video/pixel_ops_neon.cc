@@ -0,0 +1,74 @@
+/*
+ * pixel_ops_neon.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <arm_neon.h>
+
+#include "api/video/pixel_ops_internal.h"
+
+namespace ave {
+namespace pixel_ops {
+
+namespace {
+
+constexpr size_t kLanes = 16;
+// 16 bit lanes take 128 pairwise added bytes before they may overflow
+constexpr size_t kFlushInterval = 128;
+
+uint64_t Reduce(uint32x4_t sums) {
+  const uint64x2_t pairs = vpaddlq_u32(sums);
+  return vgetq_lane_u64(pairs, 0) + vgetq_lane_u64(pairs, 1);
+}
+
+bool EqualRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const uint64x2_t diff =
+        vreinterpretq_u64_u8(veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    if ((vgetq_lane_u64(diff, 0) | vgetq_lane_u64(diff, 1)) != 0) {
+      return false;
+    }
+  }
+  return EqualTail(a + i, b + i, width - i);
+}
+
+uint64_t SumRow(const uint8_t* data, size_t width) {
+  uint32x4_t sums = vdupq_n_u32(0);
+  size_t i = 0;
+  while (i + kLanes <= width) {
+    uint16x8_t partial = vdupq_n_u16(0);
+    for (size_t n = 0; n < kFlushInterval && i + kLanes <= width;
+         n++, i += kLanes) {
+      partial = vpadalq_u8(partial, vld1q_u8(data + i));
+    }
+    sums = vpadalq_u16(sums, partial);
+  }
+  return Reduce(sums) + SumTail(data + i, width - i);
+}
+
+uint64_t SadRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  uint32x4_t sums = vdupq_n_u32(0);
+  size_t i = 0;
+  while (i + kLanes <= width) {
+    uint16x8_t partial = vdupq_n_u16(0);
+    for (size_t n = 0; n < kFlushInterval && i + kLanes <= width;
+         n++, i += kLanes) {
+      partial = vpadalq_u8(partial, vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+    sums = vpadalq_u16(sums, partial);
+  }
+  return Reduce(sums) + SadTail(a + i, b + i, width - i);
+}
+
+}  // namespace
+
+const Kernels* NeonKernels() {
+  static const Kernels kernels = {"neon", EqualRow, SumRow, SadRow};
+  return &kernels;
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
@@ -0,0 +1,73 @@
+/*
+ * pixel_ops_sse2.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <emmintrin.h>
+
+#include "api/video/pixel_ops_internal.h"
+
+namespace ave {
+namespace pixel_ops {
+
+namespace {
+
+// the kernels are built for sse2 alone, the rest of the binary keeps the
+// baseline target, sse2 is not part of it on 32-bit x86
+#define OC_TARGET_SSE2 __attribute__((target("sse2")))
+
+constexpr size_t kLanes = 16;
+
+// through memory, _mm_cvtsi128_si64() does not exist on 32-bit x86
+OC_TARGET_SSE2 uint64_t Reduce(__m128i sums) {
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+  return lanes[0] + lanes[1];
+}
+
+OC_TARGET_SSE2 bool EqualRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff) {
+      return false;
+    }
+  }
+  return EqualTail(a + i, b + i, width - i);
+}
+
+OC_TARGET_SSE2 uint64_t SumRow(const uint8_t* data, size_t width) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sums = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(v, zero));
+  }
+  return Reduce(sums) + SumTail(data + i, width - i);
+}
+
+OC_TARGET_SSE2 uint64_t SadRow(const uint8_t* a, const uint8_t* b, size_t width) {
+  __m128i sums = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + kLanes <= width; i += kLanes) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(va, vb));
+  }
+  return Reduce(sums) + SadTail(a + i, b + i, width - i);
+}
+
+}  // namespace
+
+const Kernels* SSE2Kernels() {
+  static const Kernels kernels = {"sse2", EqualRow, SumRow, SadRow};
+  return &kernels;
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
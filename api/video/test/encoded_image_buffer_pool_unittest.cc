@@ -0,0 +1,81 @@
+/*
+ * encoded_image_buffer_pool_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <memory>
+
+#include "api/video/encoded_image.h"
+#include "api/video/encoded_image_buffer_pool.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+TEST(EncodedImageBufferPoolTest, ReusesReleasedBuffer) {
+  EncodedImageBufferPool pool;
+  auto buffer = pool.Acquire(1000);
+  const uint8_t* data = buffer->Data();
+  EXPECT_GE(buffer->Size(), (size_t)1000);
+  EXPECT_EQ((uint64_t)1, pool.stats().allocations);
+
+  buffer.reset();
+  buffer = pool.Acquire(800);
+  EXPECT_EQ(data, buffer->Data());
+  EXPECT_EQ((uint64_t)1, pool.stats().hits);
+  EXPECT_EQ((uint64_t)1, pool.stats().allocations);
+}
+
+TEST(EncodedImageBufferPoolTest, HeldBufferIsNotReused) {
+  EncodedImageBufferPool pool;
+  EncodedImage image;
+  image.SetEncodedData(pool.Acquire(100));
+
+  auto buffer = pool.Acquire(100);
+  EXPECT_NE(image.Data(), buffer->Data());
+  EXPECT_EQ((size_t)2, pool.stats().buffers);
+
+  // a copy of the image keeps the buffer taken too
+  EncodedImage copy = image;
+  image.ClearEncodedData();
+  buffer.reset();
+  EXPECT_NE(copy.Data(), pool.Acquire(100)->Data());
+}
+
+TEST(EncodedImageBufferPoolTest, GrowsToHighWaterMark) {
+  EncodedImageBufferPool pool;
+  pool.Acquire(100);
+  // a key frame grows the free buffer
+  auto buffer = pool.Acquire(5000);
+  EXPECT_GE(buffer->Size(), (size_t)5000);
+  EXPECT_EQ((size_t)1, pool.stats().buffers);
+  EXPECT_EQ((size_t)5000, pool.stats().high_water_mark);
+
+  // a second buffer starts at the high water mark, so it never grows again
+  auto second = pool.Acquire(100);
+  EXPECT_GE(second->Size(), (size_t)5000);
+  buffer.reset();
+  second.reset();
+
+  const uint64_t allocations = pool.stats().allocations;
+  for (int i = 0; i < 30; i++) {
+    auto frame = pool.Acquire(i % 10 == 0 ? 5000 : 300);
+    EncodedImage image;
+    image.SetEncodedData(frame);
+  }
+  EXPECT_EQ(allocations, pool.stats().allocations);
+}
+
+TEST(EncodedImageBufferPoolTest, FallsBackWhenAllBuffersAreHeld) {
+  EncodedImageBufferPool pool(1);
+  auto held = pool.Acquire(100);
+  auto extra = pool.Acquire(100);
+  ASSERT_TRUE(extra != nullptr);
+  EXPECT_NE(held->Data(), extra->Data());
+  EXPECT_EQ((size_t)1, pool.stats().buffers);
+  EXPECT_EQ((uint64_t)2, pool.stats().allocations);
+}
+
+}  // namespace ave
@@ -0,0 +1,104 @@
+/*
+ * frame_metadata_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <memory>
+#include <string>
+
+#include "api/video/frame_metadata.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+TEST(FrameMetadataTest, StageTimes) {
+  auto metadata = FrameMetadata::Create();
+  EXPECT_FALSE(metadata->StageTime(FrameMetadata::Stage::kCapture));
+  EXPECT_FALSE(metadata->StageDelta(FrameMetadata::Stage::kCapture,
+                                    FrameMetadata::Stage::kSend));
+
+  metadata->SetStageTime(FrameMetadata::Stage::kCapture, 1000);
+  metadata->SetStageTime(FrameMetadata::Stage::kSend, 1500);
+  EXPECT_EQ(1000, *metadata->StageTime(FrameMetadata::Stage::kCapture));
+  EXPECT_EQ(500, *metadata->StageDelta(FrameMetadata::Stage::kCapture,
+                                       FrameMetadata::Stage::kSend));
+}
+
+TEST(FrameMetadataTest, TypedValues) {
+  auto metadata = FrameMetadata::Create();
+  // nothing set yet
+  EXPECT_FALSE(metadata->Has("motion"));
+  EXPECT_FALSE(metadata->Get<double>("motion"));
+  metadata->Remove("motion");
+
+  metadata->Set("motion", 0.5);
+  metadata->Set("frames", (int64_t)7);
+  metadata->Set("sensor", std::string("imx219"));
+
+  EXPECT_EQ(0.5, *metadata->Get<double>("motion"));
+  EXPECT_EQ(7, *metadata->Get<int64_t>("frames"));
+  EXPECT_EQ("imx219", *metadata->Get<std::string>("sensor"));
+  // wrong type or missing key
+  EXPECT_FALSE(metadata->Get<int64_t>("motion"));
+  EXPECT_FALSE(metadata->Get<double>("exposure"));
+
+  metadata->Remove("motion");
+  EXPECT_FALSE(metadata->Has("motion"));
+}
+
+TEST(FrameMetadataTest, SourceSequence) {
+  auto metadata = FrameMetadata::Create();
+  EXPECT_FALSE(metadata->SourceSequence());
+  metadata->SetSourceSequence(7);
+  EXPECT_EQ(7, *metadata->SourceSequence());
+  // not one of the keys
+  EXPECT_FALSE(metadata->Has("source_sequence"));
+}
+
+TEST(FrameMetadataTest, SharedByFrameCopies) {
+  VideoFrame frame(0, I420Buffer::Create(16, 16), 0, std::nullopt);
+  ASSERT_TRUE(frame.metadata() != nullptr);
+
+  VideoFrame copy(frame);
+  copy.set_video_frame_buffer(I420Buffer::Create(8, 8));
+  copy.metadata()->SetStageTime(FrameMetadata::Stage::kEncodeStart, 42);
+  EXPECT_EQ(frame.metadata(), copy.metadata());
+  EXPECT_EQ(42, *frame.metadata()->StageTime(
+                    FrameMetadata::Stage::kEncodeStart));
+
+  // a new frame starts with its own
+  VideoFrame other(1, I420Buffer::Create(16, 16), 0, std::nullopt);
+  EXPECT_NE(frame.metadata(), other.metadata());
+}
+
+TEST(FrameMetadataTest, ForkKeepsCaptureSide) {
+  auto metadata = FrameMetadata::Create();
+  metadata->SetStageTime(FrameMetadata::Stage::kCapture, 1000);
+  metadata->SetStageTime(FrameMetadata::Stage::kDequeue, 1100);
+  metadata->SetStageTime(FrameMetadata::Stage::kDeliver, 1200);
+  metadata->SetStageTime(FrameMetadata::Stage::kEncodeStart, 1300);
+  metadata->SetSourceSequence(7);
+  metadata->Set("motion", 0.5);
+
+  auto fork = metadata->Fork();
+  EXPECT_NE(metadata, fork);
+  EXPECT_EQ(1000, *fork->StageTime(FrameMetadata::Stage::kCapture));
+  EXPECT_EQ(1100, *fork->StageTime(FrameMetadata::Stage::kDequeue));
+  EXPECT_FALSE(fork->StageTime(FrameMetadata::Stage::kDeliver));
+  EXPECT_FALSE(fork->StageTime(FrameMetadata::Stage::kEncodeStart));
+  EXPECT_EQ(7, *fork->SourceSequence());
+  EXPECT_EQ(0.5, *fork->Get<double>("motion"));
+
+  // the two go separate ways
+  fork->SetStageTime(FrameMetadata::Stage::kEncodeStart, 2000);
+  fork->Set("motion", 1.0);
+  EXPECT_EQ(1300, *metadata->StageTime(FrameMetadata::Stage::kEncodeStart));
+  EXPECT_EQ(0.5, *metadata->Get<double>("motion"));
+}
+
+}  // namespace ave
@@ -0,0 +1,104 @@
+/*
+ * pixel_ops_benchmark.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+// Reports the throughput of every pixel_ops kernel the cpu supports on 720p
+// and 1080p luma planes.
+//
+//   pixel_ops_benchmark [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "api/video/pixel_ops.h"
+#include "api/video/pixel_ops_internal.h"
+#include "base/logging.h"
+
+using namespace ave;
+using namespace ave::pixel_ops;
+
+namespace {
+
+constexpr int kDefaultIterations = 200;
+
+struct PlaneSize {
+  size_t width;
+  size_t height;
+};
+constexpr PlaneSize kPlaneSizes[] = {{1280, 720}, {1920, 1080}};
+
+// bytes read per second, in GB/s
+double Measure(int iterations, size_t bytes, const std::function<void()>& op) {
+  op();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    op();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(bytes) * iterations / elapsed.count() / 1e9;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ave::base::LogMessage::LogToDebug(LS_INFO);
+
+  const int iterations =
+      argc > 1 ? std::max(1, atoi(argv[1])) : kDefaultIterations;
+  AVE_LOG(LS_INFO) << "selected: " << ImplementationName();
+
+  // results are summed up so the compiler can't drop the work
+  volatile uint64_t sink = 0;
+  for (const auto& size : kPlaneSizes) {
+    const size_t bytes = size.width * size.height;
+    std::vector<uint8_t> a(bytes);
+    std::vector<uint8_t> b(bytes);
+    for (size_t i = 0; i < bytes; i++) {
+      a[i] = static_cast<uint8_t>(i * 7);
+      b[i] = a[i];
+    }
+
+    for (const Kernels* kernels : SupportedKernels()) {
+      const double equal = Measure(iterations, bytes * 2, [&]() {
+        for (size_t row = 0; row < size.height; row++) {
+          sink = sink + kernels->equal_row(a.data() + row * size.width,
+                                           b.data() + row * size.width,
+                                           size.width);
+        }
+      });
+      const double sum = Measure(iterations, bytes, [&]() {
+        for (size_t row = 0; row < size.height; row++) {
+          sink = sink + kernels->sum_row(a.data() + row * size.width,
+                                         size.width);
+        }
+      });
+      const double sad = Measure(iterations, bytes * 2, [&]() {
+        for (size_t row = 0; row < size.height; row++) {
+          sink = sink + kernels->sad_row(a.data() + row * size.width,
+                                         b.data() + row * size.width,
+                                         size.width);
+        }
+      });
+      AVE_LOG(LS_INFO) << size.width << "x" << size.height << " "
+                       << kernels->name << " GB/s equal: " << equal
+                       << ", sum: " << sum << ", sad: " << sad;
+    }
+
+    uint32_t histogram[256];
+    const double histogram_rate = Measure(iterations, bytes, [&]() {
+      PlaneHistogram(a.data(), size.width, size.width, size.height, histogram);
+      sink = sink + histogram[0];
+    });
+    AVE_LOG(LS_INFO) << size.width << "x" << size.height
+                     << " histogram GB/s: " << histogram_rate;
+  }
+
+  return 0;
+}
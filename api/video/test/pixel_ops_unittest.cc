@@ -0,0 +1,104 @@
+/*
+ * pixel_ops_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <cstdlib>
+#include <vector>
+
+#include "api/video/pixel_ops.h"
+#include "api/video/pixel_ops_internal.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+namespace pixel_ops {
+
+namespace {
+// around every simd width and its tails
+constexpr size_t kWidths[] = {0, 1, 15, 16, 17, 31, 32, 33, 64, 100, 1283};
+
+std::vector<uint8_t> RandomRow(size_t width) {
+  std::vector<uint8_t> row(width);
+  for (auto& sample : row) {
+    sample = static_cast<uint8_t>(rand());
+  }
+  return row;
+}
+
+}  // namespace
+
+TEST(PixelOpsTest, KernelsMatchScalar) {
+  const Kernels* scalar = ScalarKernels();
+  srand(1);
+  for (const Kernels* kernels : SupportedKernels()) {
+    for (size_t width : kWidths) {
+      std::vector<uint8_t> a = RandomRow(width);
+      std::vector<uint8_t> b = RandomRow(width);
+      EXPECT_EQ(scalar->sum_row(a.data(), width),
+                kernels->sum_row(a.data(), width))
+          << kernels->name << " width " << width;
+      EXPECT_EQ(scalar->sad_row(a.data(), b.data(), width),
+                kernels->sad_row(a.data(), b.data(), width))
+          << kernels->name << " width " << width;
+      EXPECT_TRUE(kernels->equal_row(a.data(), a.data(), width));
+      if (width > 0) {
+        std::vector<uint8_t> c = a;
+        c.back() ^= 1;
+        EXPECT_FALSE(kernels->equal_row(a.data(), c.data(), width))
+            << kernels->name << " width " << width;
+      }
+    }
+  }
+}
+
+TEST(PixelOpsTest, KernelsDoNotOverflow) {
+  // a 4k row of white against black
+  std::vector<uint8_t> white(4096, 255);
+  std::vector<uint8_t> black(4096, 0);
+  for (const Kernels* kernels : SupportedKernels()) {
+    EXPECT_EQ((uint64_t)4096 * 255, kernels->sum_row(white.data(), 4096))
+        << kernels->name;
+    EXPECT_EQ((uint64_t)4096 * 255,
+              kernels->sad_row(white.data(), black.data(), 4096))
+        << kernels->name;
+  }
+}
+
+TEST(PixelOpsTest, PlaneStatistics) {
+  constexpr size_t kWidth = 40;
+  constexpr size_t kHeight = 6;
+  constexpr size_t kStride = 48;
+  std::vector<uint8_t> a(kStride * kHeight, 0);
+  std::vector<uint8_t> b(kStride * kHeight, 0);
+  for (size_t row = 0; row < kHeight; row++) {
+    for (size_t col = 0; col < kWidth; col++) {
+      a[row * kStride + col] = static_cast<uint8_t>(col);
+      b[row * kStride + col] = static_cast<uint8_t>(col + 2);
+    }
+    // padding is ignored
+    a[row * kStride + kWidth] = 1;
+  }
+
+  EXPECT_TRUE(PlaneEqual(a.data(), kStride, a.data(), kStride, kWidth,
+                         kHeight));
+  EXPECT_FALSE(PlaneEqual(a.data(), kStride, b.data(), kStride, kWidth,
+                          kHeight));
+  EXPECT_EQ((uint64_t)(39 * 40 / 2 * kHeight),
+            PlaneSum(a.data(), kStride, kWidth, kHeight));
+  EXPECT_EQ((uint64_t)(2 * kWidth * kHeight),
+            BlockSad(a.data(), kStride, b.data(), kStride, kWidth, kHeight));
+  EXPECT_DOUBLE_EQ(2.0, MeanAbsoluteDifference(a.data(), kStride, b.data(),
+                                               kStride, kWidth, kHeight));
+
+  uint32_t histogram[256];
+  PlaneHistogram(a.data(), kStride, kWidth, kHeight, histogram);
+  for (size_t value = 0; value < 256; value++) {
+    EXPECT_EQ(value < kWidth ? kHeight : 0u, histogram[value]);
+  }
+}
+
+}  // namespace pixel_ops
+}  // namespace ave
@@ -0,0 +1,89 @@
+/*
+ * video_frame_buffer_pool_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <memory>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/video_frame_buffer_pool.h"
+#include "api/video/yuyv_buffer.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+TEST(VideoFrameBufferPoolTest, ReusesReleasedBuffer) {
+  VideoFrameBufferPool pool;
+  auto buffer = pool.CreateI420Buffer(16, 16, 16, 8, 8);
+  const uint8_t* data = buffer->DataY();
+  EXPECT_EQ((uint64_t)1, pool.stats().misses);
+  EXPECT_EQ((size_t)1, pool.stats().outstanding);
+
+  buffer.reset();
+  EXPECT_EQ((size_t)0, pool.stats().outstanding);
+  EXPECT_EQ((size_t)1, pool.stats().pooled);
+
+  buffer = pool.CreateI420Buffer(16, 16, 16, 8, 8);
+  EXPECT_EQ(data, buffer->DataY());
+  EXPECT_EQ((uint64_t)1, pool.stats().hits);
+  EXPECT_EQ((size_t)0, pool.stats().pooled);
+}
+
+TEST(VideoFrameBufferPoolTest, KeyedByFormatAndSize) {
+  VideoFrameBufferPool pool;
+  pool.CreateI420Buffer(16, 16, 16, 8, 8);
+  // same bytes, other format or strides, is not reused
+  pool.CreateNV12Buffer(16, 16, 16, 16);
+  pool.CreateI420Buffer(16, 16, 32, 16, 16);
+  pool.CreateYUYVBuffer(16, 16, 32);
+  EXPECT_EQ((uint64_t)0, pool.stats().hits);
+  EXPECT_EQ((uint64_t)4, pool.stats().misses);
+  EXPECT_EQ((size_t)4, pool.stats().pooled);
+
+  auto nv12 = pool.CreateNV12Buffer(16, 16, 16, 16);
+  auto yuyv = pool.CreateYUYVBuffer(16, 16, 32);
+  EXPECT_EQ((uint64_t)2, pool.stats().hits);
+  EXPECT_EQ((size_t)2, pool.stats().outstanding);
+}
+
+TEST(VideoFrameBufferPoolTest, KeepsAtMostMaxPooledBuffers) {
+  VideoFrameBufferPool pool(2);
+  {
+    auto a = pool.CreateI420Buffer(16, 16, 16, 8, 8);
+    auto b = pool.CreateI420Buffer(16, 16, 16, 8, 8);
+    auto c = pool.CreateI420Buffer(16, 16, 16, 8, 8);
+    EXPECT_EQ((size_t)3, pool.stats().outstanding);
+  }
+  EXPECT_EQ((size_t)2, pool.stats().pooled);
+
+  pool.SetMaxPooledBuffers(1);
+  EXPECT_EQ((size_t)1, pool.stats().pooled);
+
+  pool.Release();
+  EXPECT_EQ((size_t)0, pool.stats().pooled);
+}
+
+TEST(VideoFrameBufferPoolTest, BufferOutlivesPool) {
+  std::shared_ptr<NV12Buffer> buffer;
+  {
+    VideoFrameBufferPool pool;
+    buffer = pool.CreateNV12Buffer(16, 16, 16, 16);
+  }
+  buffer->MutableDataY()[0] = 1;
+  EXPECT_EQ(1, buffer->DataY()[0]);
+}
+
+TEST(VideoFrameBufferPoolTest, CreateAllocatesFromDefaultPool) {
+  auto* pool = VideoFrameBufferPool::Default();
+  auto before = pool->stats();
+  auto buffer = I420Buffer::Create(18, 18);
+  auto after = pool->stats();
+  EXPECT_EQ(before.hits + before.misses + 1, after.hits + after.misses);
+  EXPECT_EQ(before.outstanding + 1, after.outstanding);
+}
+
+}  // namespace ave
@@ -0,0 +1,135 @@
+/*
+ * video_frame_buffer_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/video_frame_buffer.h"
+#include "api/video/video_frame_buffer_pool.h"
+#include "api/video/yuyv_buffer.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+namespace {
+constexpr size_t kWidth = 64;
+constexpr size_t kHeight = 48;
+constexpr int kConsumers = 8;
+
+// counts how often it converts to I420
+class CountingBuffer : public VideoFrameBuffer {
+ public:
+  Type type() const override { return Type::kNormal; }
+  PixelFormat pixel_format() const override { return PixelFormat::kNV12; }
+  size_t width() const override { return kWidth; }
+  size_t height() const override { return kHeight; }
+
+  std::shared_ptr<I420BufferInterface> ToI420() override {
+    return CachedI420([this]() {
+      conversions_++;
+      // give concurrent consumers the chance to race
+      std::this_thread::yield();
+      return I420Buffer::Create(kWidth, kHeight);
+    });
+  }
+
+  int conversions() const { return conversions_; }
+
+ private:
+  std::atomic<int> conversions_{0};
+};
+
+std::vector<std::shared_ptr<I420BufferInterface>> ConvertConcurrently(
+    const std::shared_ptr<VideoFrameBuffer>& buffer) {
+  std::vector<std::shared_ptr<I420BufferInterface>> results(kConsumers);
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < kConsumers; i++) {
+    consumers.emplace_back(
+        [&results, &buffer, i]() { results[i] = buffer->ToI420(); });
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  return results;
+}
+
+}  // namespace
+
+TEST(VideoFrameBufferTest, ConsumersShareOneConversion) {
+  auto buffer = std::make_shared<CountingBuffer>();
+  EXPECT_EQ(nullptr, buffer->GetI420());
+
+  auto results = ConvertConcurrently(buffer);
+  EXPECT_EQ(1, buffer->conversions());
+  for (const auto& result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+  EXPECT_EQ(results[0].get(), buffer->GetI420());
+
+  buffer->ToI420();
+  EXPECT_EQ(1, buffer->conversions());
+}
+
+TEST(VideoFrameBufferTest, NV12ConvertsOnce) {
+  auto buffer = NV12Buffer::Create(kWidth, kHeight);
+  EXPECT_EQ(nullptr, buffer->GetI420());
+
+  auto before = VideoFrameBufferPool::Default()->stats();
+  auto results = ConvertConcurrently(buffer);
+  auto after = VideoFrameBufferPool::Default()->stats();
+  // a single I420 buffer was allocated for all consumers
+  EXPECT_EQ(before.hits + before.misses + 1, after.hits + after.misses);
+  for (const auto& result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+  EXPECT_EQ(results[0].get(), buffer->GetI420());
+}
+
+TEST(VideoFrameBufferTest, YUYVConvertsOnce) {
+  auto buffer = YUYVBuffer::Create(kWidth, kHeight);
+  EXPECT_EQ(nullptr, buffer->GetI420());
+
+  auto results = ConvertConcurrently(buffer);
+  for (const auto& result : results) {
+    EXPECT_EQ(results[0], result);
+  }
+  EXPECT_EQ(results[0].get(), buffer->GetI420());
+}
+
+TEST(VideoFrameBufferTest, NV12WriteDropsConversion) {
+  auto buffer = NV12Buffer::Create(kWidth, kHeight);
+  memset(buffer->MutableDataY(), 10, buffer->StrideY() * kHeight);
+  EXPECT_EQ(10, buffer->ToI420()->DataY()[0]);
+
+  memset(buffer->MutableDataY(), 20, buffer->StrideY() * kHeight);
+  EXPECT_EQ(nullptr, buffer->GetI420());
+  EXPECT_EQ(20, buffer->ToI420()->DataY()[0]);
+}
+
+TEST(VideoFrameBufferTest, YUYVWriteDropsConversion) {
+  auto buffer = YUYVBuffer::Create(kWidth, kHeight);
+  memset(buffer->MutableData(), 10, buffer->Stride() * kHeight);
+  EXPECT_EQ(10, buffer->ToI420()->DataY()[0]);
+
+  memset(buffer->MutableData(), 20, buffer->Stride() * kHeight);
+  EXPECT_EQ(nullptr, buffer->GetI420());
+  EXPECT_EQ(20, buffer->ToI420()->DataY()[0]);
+}
+
+TEST(VideoFrameBufferTest, I420IsItsOwnView) {
+  auto buffer = I420Buffer::Create(kWidth, kHeight);
+  EXPECT_EQ(buffer.get(), buffer->GetI420());
+  EXPECT_EQ(buffer, buffer->ToI420());
+}
+
+}  // namespace ave
@@ -0,0 +1,36 @@
+/*
+ * video_frame_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <optional>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+TEST(VideoFrameTest, AlignedRectWithoutCrop) {
+  // an odd sized frame is kept whole
+  VideoFrame frame(0, I420Buffer::Create(33, 17), 0, std::nullopt);
+  EXPECT_TRUE(VideoFrame::Rect({0, 0, 33, 17}) == frame.aligned_rect());
+}
+
+TEST(VideoFrameTest, AlignedRectRoundsToEven) {
+  VideoFrame frame(0, I420Buffer::Create(64, 48), 0, std::nullopt);
+  std::optional<VideoFrame::Rect> rect = VideoFrame::Rect{3, 5, 31, 21};
+  frame.set_rect(rect);
+  const VideoFrame::Rect aligned = frame.aligned_rect();
+  EXPECT_TRUE(VideoFrame::Rect({2, 4, 30, 20}) == aligned);
+
+  // still inside the frame at the far corner
+  rect = VideoFrame::Rect{33, 27, 31, 21};
+  frame.set_rect(rect);
+  EXPECT_TRUE(VideoFrame::Rect({32, 26, 30, 20}) == frame.aligned_rect());
+}
+
+}  // namespace ave
@@ -0,0 +1,144 @@
+/*
+ * video_scale_benchmark.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+// Compares the ways a camera frame gets cropped and scaled for a substream:
+// the old route through a full size I420 against the native YUYV/NV12
+// kernels and the single pass YUYV -> scaled I420/NV12 converters. The
+// single pass is also checked for quality, by its PSNR against the old route.
+//
+//   video_scale_benchmark [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/yuyv_buffer.h"
+#include "base/logging.h"
+#include "third_party/libyuv/include/libyuv.h"
+
+using namespace ave;
+
+namespace {
+
+constexpr int kDefaultIterations = 100;
+constexpr size_t kWidth = 1920;
+constexpr size_t kHeight = 1080;
+
+struct ScaledSize {
+  size_t width;
+  size_t height;
+};
+constexpr ScaledSize kScaledSizes[] = {{1280, 720}, {640, 360}};
+
+int64_t MeasureUs(int iterations, const std::function<void()>& scale) {
+  // warm up caches and the buffer pool
+  scale();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    scale();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+             .count() /
+         iterations;
+}
+
+void Report(const char* name, const ScaledSize& size, int64_t us) {
+  AVE_LOG(LS_INFO) << "  " << name << " -> " << size.width << "x"
+                   << size.height << ": " << us << " us/frame";
+}
+
+// PSNR of the single pass against the full size I420 route, in dB
+double SinglePassPsnr(const std::shared_ptr<YUYVBuffer>& yuyv,
+                      const ScaledSize& size) {
+  auto expected = I420Buffer::Create(size.width, size.height);
+  expected->ScaleFrom(*yuyv->ToI420());
+  auto scaled = I420Buffer::Create(size.width, size.height);
+  scaled->CropAndScaleFrom(*yuyv, 0, 0, yuyv->width(), yuyv->height());
+  return libyuv::I420Psnr(
+      expected->DataY(), expected->StrideY(), expected->DataU(),
+      expected->StrideU(), expected->DataV(), expected->StrideV(),
+      scaled->DataY(), scaled->StrideY(), scaled->DataU(), scaled->StrideU(),
+      scaled->DataV(), scaled->StrideV(), size.width, size.height);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ave::base::LogMessage::LogToDebug(LS_INFO);
+
+  const int iterations =
+      argc > 1 ? std::max(1, atoi(argv[1])) : kDefaultIterations;
+
+  auto yuyv = YUYVBuffer::Create(kWidth, kHeight);
+  auto nv12 = NV12Buffer::Create(kWidth, kHeight);
+  // noise, the worst case for aliasing in the psnr check
+  uint32_t seed = 1;
+  for (size_t i = 0; i < yuyv->Stride() * kHeight; i++) {
+    seed = seed * 1103515245 + 12345;
+    yuyv->MutableData()[i] = static_cast<uint8_t>(seed >> 24);
+  }
+  for (size_t i = 0; i < nv12->StrideY() * kHeight; i++) {
+    nv12->MutableDataY()[i] = static_cast<uint8_t>(i * 7);
+  }
+  for (size_t i = 0; i < nv12->StrideUV() * nv12->ChromaHeight(); i++) {
+    nv12->MutableDataUV()[i] = static_cast<uint8_t>(i * 3);
+  }
+
+  AVE_LOG(LS_INFO) << "yuyv " << kWidth << "x" << kHeight << ", "
+                   << iterations << " iterations";
+  for (const auto& size : kScaledSizes) {
+    Report("full i420 + i420 scale", size, MeasureUs(iterations, [&]() {
+             auto full = I420Buffer::Create(kWidth, kHeight);
+             libyuv::YUY2ToI420(yuyv->Data(), yuyv->Stride(),
+                                full->MutableDataY(), full->StrideY(),
+                                full->MutableDataU(), full->StrideU(),
+                                full->MutableDataV(), full->StrideV(), kWidth,
+                                kHeight);
+             I420Buffer::Create(size.width, size.height)->ScaleFrom(*full);
+           }));
+    Report("yuyv scale", size, MeasureUs(iterations, [&]() {
+             YUYVBuffer::Create(size.width, size.height)
+                 ->CropAndScaleFrom(*yuyv, 0, 0, kWidth, kHeight);
+           }));
+    Report("single pass i420", size, MeasureUs(iterations, [&]() {
+             I420Buffer::Create(size.width, size.height)
+                 ->CropAndScaleFrom(*yuyv, 0, 0, kWidth, kHeight);
+           }));
+    Report("single pass nv12", size, MeasureUs(iterations, [&]() {
+             NV12Buffer::Create(size.width, size.height)
+                 ->CropAndScaleFrom(*yuyv, 0, 0, kWidth, kHeight);
+           }));
+    AVE_LOG(LS_INFO) << "  single pass i420 psnr -> " << size.width << "x"
+                     << size.height << ": " << SinglePassPsnr(yuyv, size)
+                     << " dB";
+  }
+
+  AVE_LOG(LS_INFO) << "nv12 " << kWidth << "x" << kHeight;
+  for (const auto& size : kScaledSizes) {
+    Report("full i420 + i420 scale", size, MeasureUs(iterations, [&]() {
+             auto full = I420Buffer::Create(kWidth, kHeight);
+             libyuv::NV12ToI420(nv12->DataY(), nv12->StrideY(),
+                                nv12->DataUV(), nv12->StrideUV(),
+                                full->MutableDataY(), full->StrideY(),
+                                full->MutableDataU(), full->StrideU(),
+                                full->MutableDataV(), full->StrideV(), kWidth,
+                                kHeight);
+             I420Buffer::Create(size.width, size.height)->ScaleFrom(*full);
+           }));
+    Report("nv12 scale", size, MeasureUs(iterations, [&]() {
+             NV12Buffer::Create(size.width, size.height)
+                 ->CropAndScaleFrom(*nv12, 0, 0, kWidth, kHeight);
+           }));
+  }
+
+  return 0;
+}
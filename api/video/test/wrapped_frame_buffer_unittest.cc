@@ -0,0 +1,123 @@
+/*
+ * wrapped_frame_buffer_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/wrapped_frame_buffer.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+namespace {
+constexpr size_t kWidth = 32;
+constexpr size_t kHeight = 16;
+constexpr uint8_t kY = 80;
+constexpr uint8_t kU = 100;
+constexpr uint8_t kV = 150;
+// color conversions round
+constexpr int kTolerance = 2;
+
+void ExpectPlane(const uint8_t* data,
+                 size_t stride,
+                 size_t width,
+                 size_t height,
+                 int value) {
+  for (size_t row = 0; row < height; row++) {
+    for (size_t col = 0; col < width; col++) {
+      EXPECT_LE(std::abs(data[row * stride + col] - value), kTolerance);
+    }
+  }
+}
+
+void ExpectI420(const std::shared_ptr<I420BufferInterface>& buffer,
+                int y,
+                int u,
+                int v) {
+  ExpectPlane(buffer->DataY(), buffer->StrideY(), buffer->width(),
+              buffer->height(), y);
+  ExpectPlane(buffer->DataU(), buffer->StrideU(), buffer->ChromaWidth(),
+              buffer->ChromaHeight(), u);
+  ExpectPlane(buffer->DataV(), buffer->StrideV(), buffer->ChromaWidth(),
+              buffer->ChromaHeight(), v);
+}
+
+// packed memory repeating `pattern` over every row
+std::vector<uint8_t> Fill(const std::vector<uint8_t>& pattern, size_t stride) {
+  std::vector<uint8_t> data(stride * kHeight);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = pattern[i % pattern.size()];
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(WrappedFrameBufferTest, NV21ToI420) {
+  std::vector<uint8_t> data = Fill({kY}, kWidth);
+  std::vector<uint8_t> vu = Fill({kV, kU}, kWidth);
+  bool released = false;
+  auto buffer =
+      WrappedNV21Buffer::Create(kWidth, kHeight, data.data(), kWidth,
+                                vu.data(), kWidth, [&]() { released = true; });
+  EXPECT_EQ(VideoFrameBuffer::PixelFormat::kNV21, buffer->pixel_format());
+  ExpectI420(buffer->ToI420(), kY, kU, kV);
+
+  buffer.reset();
+  EXPECT_TRUE(released);
+}
+
+TEST(WrappedFrameBufferTest, NV21ScalesToNV12) {
+  std::vector<uint8_t> data = Fill({kY}, kWidth);
+  std::vector<uint8_t> vu = Fill({kV, kU}, kWidth);
+  auto buffer = WrappedNV21Buffer::Create(kWidth, kHeight, data.data(), kWidth,
+                                          vu.data(), kWidth, nullptr);
+
+  auto scaled = buffer->CropAndScale(0, 0, kWidth, kHeight, 16, 8);
+  ASSERT_EQ(VideoFrameBuffer::PixelFormat::kNV12, scaled->pixel_format());
+  ExpectI420(scaled->ToI420(), kY, kU, kV);
+}
+
+TEST(WrappedFrameBufferTest, UYVYToI420) {
+  std::vector<uint8_t> data = Fill({kU, kY, kV, kY}, kWidth * 2);
+  auto buffer = WrappedUYVYBuffer::Create(kWidth, kHeight, data.data(),
+                                          kWidth * 2, nullptr);
+  EXPECT_EQ(VideoFrameBuffer::PixelFormat::kUYVY, buffer->pixel_format());
+  ExpectI420(buffer->ToI420(), kY, kU, kV);
+
+  // single pass from 4x fewer pixels down, libyuv above
+  ExpectI420(buffer->CropAndScale(0, 0, kWidth, kHeight, 16, 8)->ToI420(), kY,
+             kU, kV);
+  ExpectI420(buffer->CropAndScale(0, 0, kWidth, kHeight, 24, 12)->ToI420(),
+             kY, kU, kV);
+}
+
+TEST(WrappedFrameBufferTest, RGB24AndBGRAConvertAlike) {
+  // the same orange in both byte orders
+  std::vector<uint8_t> rgb = Fill({240, 140, 20}, kWidth * 3);
+  std::vector<uint8_t> bgra = Fill({20, 140, 240, 255}, kWidth * 4);
+  auto rgb24 = WrappedRGB24Buffer::Create(kWidth, kHeight, rgb.data(),
+                                          kWidth * 3, nullptr);
+  auto bgra32 = WrappedBGRABuffer::Create(kWidth, kHeight, bgra.data(),
+                                          kWidth * 4, nullptr);
+  EXPECT_EQ(VideoFrameBuffer::PixelFormat::kRGB24, rgb24->pixel_format());
+  EXPECT_EQ(VideoFrameBuffer::PixelFormat::kBGRA, bgra32->pixel_format());
+
+  auto i420 = bgra32->ToI420();
+  // orange: bright luma, blue difference below and red difference above grey
+  EXPECT_GT(i420->DataY()[0], 128);
+  EXPECT_LT(i420->DataU()[0], 128);
+  EXPECT_GT(i420->DataV()[0], 128);
+  ExpectI420(rgb24->ToI420(), i420->DataY()[0], i420->DataU()[0],
+             i420->DataV()[0]);
+}
+
+}  // namespace ave
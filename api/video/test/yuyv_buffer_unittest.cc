@@ -0,0 +1,149 @@
+/*
+ * yuyv_buffer_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <cstdlib>
+#include <memory>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/yuyv_buffer.h"
+#include "gtest/gtest.h"
+#include "test/gtest.h"
+
+namespace ave {
+
+namespace {
+constexpr size_t kWidth = 64;
+constexpr size_t kHeight = 48;
+constexpr uint8_t kU = 90;
+// the two step route filters chroma twice, allow for rounding
+constexpr int kTolerance = 2;
+
+// luma ramps to the right, V ramps down, U is flat
+std::shared_ptr<YUYVBuffer> CreateGradient() {
+  auto buffer = YUYVBuffer::Create(kWidth, kHeight);
+  for (size_t row = 0; row < kHeight; row++) {
+    uint8_t* line = buffer->MutableData() + row * buffer->Stride();
+    for (size_t col = 0; col < kWidth; col += 2) {
+      line[col * 2] = static_cast<uint8_t>(col * 2);
+      line[col * 2 + 1] = kU;
+      line[col * 2 + 2] = static_cast<uint8_t>(col * 2 + 2);
+      line[col * 2 + 3] = static_cast<uint8_t>(row * 3);
+    }
+  }
+  return buffer;
+}
+
+bool PlanesNear(const uint8_t* a,
+                size_t stride_a,
+                const uint8_t* b,
+                size_t stride_b,
+                size_t width,
+                size_t height) {
+  for (size_t row = 0; row < height; row++) {
+    for (size_t col = 0; col < width; col++) {
+      if (std::abs(a[row * stride_a + col] - b[row * stride_b + col]) >
+          kTolerance) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(YUYVBufferTest, CropAndScaleFromKeepsFlatColor) {
+  auto src = YUYVBuffer::Create(kWidth, kHeight);
+  for (size_t i = 0; i < kWidth * kHeight * 2; i += 4) {
+    src->MutableData()[i] = 16;
+    src->MutableData()[i + 1] = 32;
+    src->MutableData()[i + 2] = 16;
+    src->MutableData()[i + 3] = 64;
+  }
+
+  auto dst = YUYVBuffer::Create(20, 14);
+  dst->CropAndScaleFrom(*src, 3, 5, 40, 30);
+  for (size_t row = 0; row < dst->height(); row++) {
+    const uint8_t* line = dst->Data() + row * dst->Stride();
+    for (size_t col = 0; col < dst->width(); col += 2) {
+      EXPECT_EQ(16, line[col * 2]);
+      EXPECT_EQ(32, line[col * 2 + 1]);
+      EXPECT_EQ(16, line[col * 2 + 2]);
+      EXPECT_EQ(64, line[col * 2 + 3]);
+    }
+  }
+}
+
+TEST(YUYVBufferTest, CropAndScaleReturnsScaledI420) {
+  auto src = CreateGradient();
+  auto scaled = src->CropAndScale(0, 0, kWidth, kHeight, 32, 24);
+  EXPECT_EQ(VideoFrameBuffer::PixelFormat::kI420, scaled->pixel_format());
+  EXPECT_EQ((size_t)32, scaled->width());
+  EXPECT_EQ((size_t)24, scaled->height());
+}
+
+TEST(YUYVBufferTest, SinglePassMatchesTwoStepI420) {
+  auto src = CreateGradient();
+
+  auto expected = I420Buffer::Create(32, 24);
+  expected->ScaleFrom(*src->ToI420());
+  auto scaled = I420Buffer::Create(32, 24);
+  scaled->CropAndScaleFrom(*src, 0, 0, kWidth, kHeight);
+
+  EXPECT_TRUE(PlanesNear(expected->DataY(), expected->StrideY(),
+                         scaled->DataY(), scaled->StrideY(), 32, 24));
+  EXPECT_TRUE(PlanesNear(expected->DataU(), expected->StrideU(),
+                         scaled->DataU(), scaled->StrideU(), 16, 12));
+  EXPECT_TRUE(PlanesNear(expected->DataV(), expected->StrideV(),
+                         scaled->DataV(), scaled->StrideV(), 16, 12));
+}
+
+TEST(YUYVBufferTest, SinglePassAveragesLargeDownscale) {
+  // a luma checkerboard, 2 taps would pick single pixels of it at 3x
+  constexpr size_t kSrcWidth = 96;
+  constexpr size_t kSrcHeight = 72;
+  auto src = YUYVBuffer::Create(kSrcWidth, kSrcHeight);
+  for (size_t row = 0; row < kSrcHeight; row++) {
+    uint8_t* line = src->MutableData() + row * src->Stride();
+    for (size_t col = 0; col < kSrcWidth; col++) {
+      line[col * 2] = (row + col) % 2 ? 255 : 0;
+      line[col * 2 + 1] = 128;
+    }
+  }
+
+  auto expected = I420Buffer::Create(32, 24);
+  expected->ScaleFrom(*src->ToI420());
+  auto scaled = I420Buffer::Create(32, 24);
+  scaled->CropAndScaleFrom(*src, 0, 0, kSrcWidth, kSrcHeight);
+
+  EXPECT_TRUE(PlanesNear(expected->DataY(), expected->StrideY(),
+                         scaled->DataY(), scaled->StrideY(), 32, 24));
+  EXPECT_TRUE(PlanesNear(expected->DataU(), expected->StrideU(),
+                         scaled->DataU(), scaled->StrideU(), 16, 12));
+}
+
+TEST(YUYVBufferTest, SinglePassNV12MatchesI420) {
+  auto src = CreateGradient();
+
+  auto i420 = I420Buffer::Create(32, 24);
+  i420->CropAndScaleFrom(*src, 0, 0, kWidth, kHeight);
+  auto nv12 = NV12Buffer::Create(32, 24);
+  nv12->CropAndScaleFrom(*src, 0, 0, kWidth, kHeight);
+
+  EXPECT_TRUE(PlanesNear(i420->DataY(), i420->StrideY(), nv12->DataY(),
+                         nv12->StrideY(), 32, 24));
+  for (size_t row = 0; row < 12; row++) {
+    const uint8_t* uv = nv12->DataUV() + row * nv12->StrideUV();
+    for (size_t col = 0; col < 16; col++) {
+      EXPECT_EQ(i420->DataU()[row * i420->StrideU() + col], uv[col * 2]);
+      EXPECT_EQ(i420->DataV()[row * i420->StrideV() + col], uv[col * 2 + 1]);
+    }
+  }
+}
+
+}  // namespace ave
@@ -15,7 +15,8 @@ VideoFrame::VideoFrame(uint64_t id,
     : id_(id),
       video_frame_buffer_(video_frame_buffer),
       timestamp_us_(timestamp_us),
-      rect_(rect) {}
+      rect_(rect),
+      metadata_(FrameMetadata::Create()) {}
 
 VideoFrame::~VideoFrame() = default;
 
@@ -32,6 +33,21 @@ size_t VideoFrame::height() const {
   return video_frame_buffer_ ? video_frame_buffer_->height() : 0;
 }
 
+VideoFrame::Rect VideoFrame::aligned_rect() const {
+  const Rect rect = *this->rect();
+  if (rect == Rect{0, 0, width(), height()}) {
+    return rect;
+  }
+  // rounding the offsets down keeps the rect inside the frame
+  Rect aligned{rect.offset_x & ~static_cast<size_t>(1),
+               rect.offset_y & ~static_cast<size_t>(1),
+               rect.width & ~static_cast<size_t>(1),
+               rect.height & ~static_cast<size_t>(1)};
+  AVE_DCHECK_GT(aligned.width, 0);
+  AVE_DCHECK_GT(aligned.height, 0);
+  return aligned;
+}
+
 size_t VideoFrame::size() const {
   return width() * height();
 }
@@ -45,4 +61,9 @@ void VideoFrame::set_video_frame_buffer(
   video_frame_buffer_ = std::move(video_frame_buffer);
 }
 
+void VideoFrame::set_metadata(std::shared_ptr<FrameMetadata> metadata) {
+  AVE_DCHECK(metadata);
+  metadata_ = std::move(metadata);
+}
+
 }  // namespace ave
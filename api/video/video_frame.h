@@ -14,6 +14,7 @@
 #include "base/checks.h"
 #include "base/types.h"
 
+#include "api/video/frame_metadata.h"
 #include "api/video/video_frame_buffer.h"
 
 namespace ave {
@@ -79,12 +80,20 @@ class VideoFrame {
 
     rect_ = rect;
   }
+  // crop rect with even offsets and size, the part of the buffer a 4:2:0
+  // consumer can address in place by offsetting plane pointers
+  Rect aligned_rect() const;
+
+  // shared by every copy of this frame, never null
+  const std::shared_ptr<FrameMetadata>& metadata() const { return metadata_; }
+  void set_metadata(std::shared_ptr<FrameMetadata> metadata);
 
  private:
   uint64_t id_;
   std::shared_ptr<VideoFrameBuffer> video_frame_buffer_;
   uint64_t timestamp_us_;
   std::optional<Rect> rect_;
+  std::shared_ptr<FrameMetadata> metadata_;
 };
 }  // namespace ave
 
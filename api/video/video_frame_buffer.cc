@@ -18,7 +18,22 @@ namespace ave {
 /** VideoFrameBuffer **/
 
 const I420BufferInterface* VideoFrameBuffer::GetI420() const {
-  return nullptr;
+  lock_guard l(&i420_lock_);
+  return i420_.get();
+}
+
+std::shared_ptr<I420BufferInterface> VideoFrameBuffer::CachedI420(
+    const std::function<std::shared_ptr<I420BufferInterface>()>& convert) {
+  lock_guard l(&i420_lock_);
+  if (i420_ == nullptr) {
+    i420_ = convert();
+  }
+  return i420_;
+}
+
+void VideoFrameBuffer::ResetCachedI420() {
+  lock_guard l(&i420_lock_);
+  i420_.reset();
 }
 
 std::shared_ptr<VideoFrameBuffer> VideoFrameBuffer::CropAndScale(
@@ -28,6 +43,12 @@ std::shared_ptr<VideoFrameBuffer> VideoFrameBuffer::CropAndScale(
     size_t crop_height,
     size_t scaled_width,
     size_t scaled_height) {
+  // nothing to crop or scale, the shared I420 picture will do
+  if (offset_x == 0 && offset_y == 0 && crop_width == width() &&
+      crop_height == height() && scaled_width == width() &&
+      scaled_height == height()) {
+    return ToI420();
+  }
   auto result = I420Buffer::Create(scaled_width, scaled_height);
   result->CropAndScaleFrom(*this->ToI420(), offset_x, offset_y, crop_width,
                            crop_height);
@@ -90,25 +111,73 @@ std::shared_ptr<VideoFrameBuffer> NV12BufferInterface::CropAndScale(
   return result;
 }
 
-/** YUYVBufferInterface **/
-VideoFrameBuffer::Type YUYVBufferInterface::type() const {
+/** NV21BufferInterface **/
+
+VideoFrameBuffer::Type NV21BufferInterface::type() const {
   return Type::kNormal;
 }
 
-VideoFrameBuffer::PixelFormat YUYVBufferInterface::pixel_format() const {
-  return PixelFormat::kYUY2;
+VideoFrameBuffer::PixelFormat NV21BufferInterface::pixel_format() const {
+  return PixelFormat::kNV21;
+}
+
+size_t NV21BufferInterface::ChromaWidth() const {
+  return (width() + 1) / 2;
+}
+
+size_t NV21BufferInterface::ChromaHeight() const {
+  return (height() + 1) / 2;
 }
 
-std::shared_ptr<VideoFrameBuffer> YUYVBufferInterface::CropAndScale(
+std::shared_ptr<VideoFrameBuffer> NV21BufferInterface::CropAndScale(
     size_t offset_x,
     size_t offset_y,
     size_t crop_width,
     size_t crop_height,
     size_t scaled_width,
     size_t scaled_height) {
-  auto result = YUYVBuffer::Create(scaled_width, scaled_height);
+  auto result = NV12Buffer::Create(scaled_width, scaled_height);
   result->CropAndScaleFrom(*this, offset_x, offset_y, crop_width, crop_height);
   return result;
 }
 
+/** YUYVBufferInterface **/
+VideoFrameBuffer::Type YUYVBufferInterface::type() const {
+  return Type::kNormal;
+}
+
+VideoFrameBuffer::PixelFormat YUYVBufferInterface::pixel_format() const {
+  return PixelFormat::kYUY2;
+}
+
+/** UYVYBufferInterface **/
+
+VideoFrameBuffer::Type UYVYBufferInterface::type() const {
+  return Type::kNormal;
+}
+
+VideoFrameBuffer::PixelFormat UYVYBufferInterface::pixel_format() const {
+  return PixelFormat::kUYVY;
+}
+
+/** RGB24BufferInterface **/
+
+VideoFrameBuffer::Type RGB24BufferInterface::type() const {
+  return Type::kNormal;
+}
+
+VideoFrameBuffer::PixelFormat RGB24BufferInterface::pixel_format() const {
+  return PixelFormat::kRGB24;
+}
+
+/** BGRABufferInterface **/
+
+VideoFrameBuffer::Type BGRABufferInterface::type() const {
+  return Type::kNormal;
+}
+
+VideoFrameBuffer::PixelFormat BGRABufferInterface::pixel_format() const {
+  return PixelFormat::kBGRA;
+}
+
 }  // namespace ave
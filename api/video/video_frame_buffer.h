@@ -8,8 +8,12 @@
 #ifndef VIDEO_FRAME_BUFFER_H
 #define VIDEO_FRAME_BUFFER_H
 
+#include <functional>
 #include <iostream>
 #include <memory>
+
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
 #include "base/types.h"
 
 namespace ave {
@@ -24,6 +28,7 @@ class VideoFrameBuffer {
     kTexture,
     kHardware,
     kPrivate,
+    kDmaBuf,
   };
 
   static std::string TypeToString(Type type) {
@@ -36,6 +41,8 @@ class VideoFrameBuffer {
         return "Hardware";
       case Type::kPrivate:
         return "Private";
+      case Type::kDmaBuf:
+        return "DmaBuf";
       default:
         return "Unknown";
     }
@@ -74,7 +81,11 @@ class VideoFrameBuffer {
   virtual size_t width() const = 0;
   virtual size_t height() const = 0;
 
+  // The I420 picture of the buffer. Non-I420 buffers convert at most once,
+  // every consumer of the buffer shares the result.
   virtual std::shared_ptr<I420BufferInterface> ToI420() = 0;
+  // The I420 picture if the buffer is I420 or ToI420() already converted it,
+  // nullptr otherwise. Never allocates.
   virtual const I420BufferInterface* GetI420() const;
 
   virtual std::shared_ptr<VideoFrameBuffer> CropAndScale(size_t offset_x,
@@ -86,6 +97,19 @@ class VideoFrameBuffer {
 
  protected:
   virtual ~VideoFrameBuffer() = default;
+
+  // Runs `convert` on the first call only, concurrent and later callers wait
+  // for and share its result. The pixel data must not change once converted.
+  std::shared_ptr<I420BufferInterface> CachedI420(
+      const std::function<std::shared_ptr<I420BufferInterface>()>& convert);
+
+  // Drops the converted picture, the mutable accessors call this before
+  // handing out writable pixels so the next ToI420() converts again.
+  void ResetCachedI420();
+
+ private:
+  mutable Mutex i420_lock_;
+  std::shared_ptr<I420BufferInterface> i420_ GUARDED_BY(i420_lock_);
 };
 
 // This interface represents planar formats.
@@ -180,6 +204,28 @@ class NV12BufferInterface : public BiplanarYuv8Buffer {
   ~NV12BufferInterface() override {}
 };
 
+// Represents PixelFormat::kNV21, NV12 with the chroma interleaved as VU.
+// DataUV() points at the VU plane.
+class NV21BufferInterface : public BiplanarYuv8Buffer {
+ public:
+  Type type() const override;
+  PixelFormat pixel_format() const final override;
+
+  size_t ChromaWidth() const final;
+  size_t ChromaHeight() const final;
+
+  // scales to NV12, which the encoder takes as is
+  std::shared_ptr<VideoFrameBuffer> CropAndScale(size_t offset_x,
+                                                 size_t offset_y,
+                                                 size_t crop_width,
+                                                 size_t crop_height,
+                                                 size_t scaled_width,
+                                                 size_t scaled_height) override;
+
+ protected:
+  ~NV21BufferInterface() override {}
+};
+
 class Packed8Buffer : public VideoFrameBuffer {
  public:
   virtual const uint8_t* Data() const = 0;
@@ -194,17 +240,42 @@ class YUYVBufferInterface : public Packed8Buffer {
   Type type() const override;
   PixelFormat pixel_format() const final override;
 
-  std::shared_ptr<VideoFrameBuffer> CropAndScale(size_t offset_x,
-                                                 size_t offset_y,
-                                                 size_t crop_width,
-                                                 size_t crop_height,
-                                                 size_t scaled_width,
-                                                 size_t scaled_height) override;
-
  protected:
   ~YUYVBufferInterface() override {}
 };
 
+// Represents PixelFormat::kUYVY, packed 4:2:2 as U0 Y0 V0 Y1.
+class UYVYBufferInterface : public Packed8Buffer {
+ public:
+  Type type() const override;
+  PixelFormat pixel_format() const final override;
+
+ protected:
+  ~UYVYBufferInterface() override {}
+};
+
+// Represents PixelFormat::kRGB24, bytes R G B in memory as V4L2_PIX_FMT_RGB24
+// (libyuv calls this RAW).
+class RGB24BufferInterface : public Packed8Buffer {
+ public:
+  Type type() const override;
+  PixelFormat pixel_format() const final override;
+
+ protected:
+  ~RGB24BufferInterface() override {}
+};
+
+// Represents PixelFormat::kBGRA, bytes B G R A in memory as
+// V4L2_PIX_FMT_ABGR32 (libyuv calls this ARGB).
+class BGRABufferInterface : public Packed8Buffer {
+ public:
+  Type type() const override;
+  PixelFormat pixel_format() const final override;
+
+ protected:
+  ~BGRABufferInterface() override {}
+};
+
 }  // namespace ave
 
 #endif /* !VIDEO_FRAME_BUFFER_H */
@@ -0,0 +1,152 @@
+/*
+ * video_frame_buffer_pool.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "video_frame_buffer_pool.h"
+
+#include <list>
+#include <memory>
+#include <utility>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/nv12_buffer.h"
+#include "api/video/yuyv_buffer.h"
+#include "base/checks.h"
+#include "base/memory/aligned_memory.h"
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
+
+namespace ave {
+
+namespace {
+// Aligning pointer to 64 bytes for improved performance, e.g. use SIMD.
+constexpr size_t kBufferAlignment = 64;
+
+using AlignedMemory = std::unique_ptr<uint8_t, base::AlignedFreeDeleter>;
+}  // namespace
+
+struct VideoFrameBufferPool::State {
+  explicit State(size_t max_pooled) : max_pooled_buffers(max_pooled) {}
+
+  void TrimLocked() REQUIRES(lock) {
+    while (idle.size() > max_pooled_buffers) {
+      idle.pop_back();
+    }
+  }
+
+  Mutex lock;
+  size_t max_pooled_buffers GUARDED_BY(lock);
+  // most recently returned first
+  std::list<std::pair<Key, AlignedMemory>> idle GUARDED_BY(lock);
+  Stats stats GUARDED_BY(lock);
+};
+
+// static
+VideoFrameBufferPool* VideoFrameBufferPool::Default() {
+  // never destroyed, buffers may be released during static destruction
+  static VideoFrameBufferPool* pool = new VideoFrameBufferPool();
+  return pool;
+}
+
+VideoFrameBufferPool::VideoFrameBufferPool(size_t max_pooled_buffers)
+    : state_(std::make_shared<State>(max_pooled_buffers)) {}
+
+VideoFrameBufferPool::~VideoFrameBufferPool() = default;
+
+FrameBufferMemory VideoFrameBufferPool::Acquire(const Key& key, size_t size) {
+  AlignedMemory memory;
+  {
+    lock_guard l(&state_->lock);
+    for (auto it = state_->idle.begin(); it != state_->idle.end(); ++it) {
+      if (it->first == key) {
+        memory = std::move(it->second);
+        state_->idle.erase(it);
+        break;
+      }
+    }
+    if (memory != nullptr) {
+      state_->stats.hits++;
+    } else {
+      state_->stats.misses++;
+    }
+    state_->stats.outstanding++;
+  }
+
+  if (memory == nullptr) {
+    memory.reset(
+        static_cast<uint8_t*>(base::AlignedMalloc(size, kBufferAlignment)));
+  }
+
+  std::weak_ptr<State> weak_state = state_;
+  return FrameBufferMemory(memory.release(), [weak_state, key](uint8_t* data) {
+    AlignedMemory returned(data);
+    auto state = weak_state.lock();
+    if (state == nullptr) {
+      return;
+    }
+    lock_guard l(&state->lock);
+    state->stats.outstanding--;
+    state->idle.emplace_front(key, std::move(returned));
+    state->TrimLocked();
+  });
+}
+
+std::shared_ptr<I420Buffer> VideoFrameBufferPool::CreateI420Buffer(
+    size_t width,
+    size_t height,
+    size_t stride_y,
+    size_t stride_u,
+    size_t stride_v) {
+  const size_t size =
+      stride_y * height + (stride_u + stride_v) * ((height + 1) / 2);
+  Key key(VideoFrameBuffer::PixelFormat::kI420, width, height, stride_y,
+          stride_u, stride_v);
+  return std::make_shared<I420Buffer>(width, height, stride_y, stride_u,
+                                      stride_v, Acquire(key, size));
+}
+
+std::shared_ptr<NV12Buffer> VideoFrameBufferPool::CreateNV12Buffer(
+    size_t width,
+    size_t height,
+    size_t stride_y,
+    size_t stride_uv) {
+  const size_t size = stride_y * height + stride_uv * ((height + 1) / 2);
+  Key key(VideoFrameBuffer::PixelFormat::kNV12, width, height, stride_y,
+          stride_uv, 0);
+  return std::make_shared<NV12Buffer>(width, height, stride_y, stride_uv,
+                                      Acquire(key, size));
+}
+
+std::shared_ptr<YUYVBuffer> VideoFrameBufferPool::CreateYUYVBuffer(
+    size_t width,
+    size_t height,
+    size_t stride_yuyv) {
+  const size_t size = stride_yuyv * height;
+  Key key(VideoFrameBuffer::PixelFormat::kYUY2, width, height, stride_yuyv, 0,
+          0);
+  return std::make_shared<YUYVBuffer>(width, height, stride_yuyv,
+                                      Acquire(key, size));
+}
+
+void VideoFrameBufferPool::SetMaxPooledBuffers(size_t max_pooled_buffers) {
+  lock_guard l(&state_->lock);
+  state_->max_pooled_buffers = max_pooled_buffers;
+  state_->TrimLocked();
+}
+
+void VideoFrameBufferPool::Release() {
+  lock_guard l(&state_->lock);
+  state_->idle.clear();
+}
+
+VideoFrameBufferPool::Stats VideoFrameBufferPool::stats() const {
+  lock_guard l(&state_->lock);
+  Stats stats = state_->stats;
+  stats.pooled = state_->idle.size();
+  return stats;
+}
+
+}  // namespace ave
@@ -0,0 +1,94 @@
+/*
+ * video_frame_buffer_pool.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef VIDEO_FRAME_BUFFER_POOL_H
+#define VIDEO_FRAME_BUFFER_POOL_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <tuple>
+
+#include "api/video/video_frame_buffer.h"
+
+namespace ave {
+
+class I420Buffer;
+class NV12Buffer;
+class YUYVBuffer;
+
+// Pixel memory of a frame buffer, memory from a VideoFrameBufferPool goes
+// back to the pool when the buffer owning it is destroyed.
+using FrameBufferMemory =
+    std::unique_ptr<uint8_t, std::function<void(uint8_t*)>>;
+
+// Recycles the pixel memory of I420Buffer, NV12Buffer and YUYVBuffer, so a
+// steady stream of same sized frames stops hitting the allocator. Memory is
+// keyed by (format, width, height, strides) and comes back to the pool when
+// the last reference to its buffer drops. At most `max_pooled_buffers` idle
+// blocks are kept, the least recently returned one is freed first.
+// Thread safe, buffers may outlive the pool.
+class VideoFrameBufferPool {
+ public:
+  struct Stats {
+    // allocations served from idle memory
+    uint64_t hits = 0;
+    // allocations which needed fresh memory
+    uint64_t misses = 0;
+    // blocks handed out and not returned yet
+    size_t outstanding = 0;
+    // idle blocks held by the pool
+    size_t pooled = 0;
+  };
+
+  static constexpr size_t kDefaultMaxPooledBuffers = 8;
+
+  // The pool I420Buffer::Create(), NV12Buffer::Create() and
+  // YUYVBuffer::Create() allocate from.
+  static VideoFrameBufferPool* Default();
+
+  explicit VideoFrameBufferPool(
+      size_t max_pooled_buffers = kDefaultMaxPooledBuffers);
+  ~VideoFrameBufferPool();
+
+  std::shared_ptr<I420Buffer> CreateI420Buffer(size_t width,
+                                               size_t height,
+                                               size_t stride_y,
+                                               size_t stride_u,
+                                               size_t stride_v);
+  std::shared_ptr<NV12Buffer> CreateNV12Buffer(size_t width,
+                                               size_t height,
+                                               size_t stride_y,
+                                               size_t stride_uv);
+  std::shared_ptr<YUYVBuffer> CreateYUYVBuffer(size_t width,
+                                               size_t height,
+                                               size_t stride_yuyv);
+
+  // frees idle blocks beyond the new cap
+  void SetMaxPooledBuffers(size_t max_pooled_buffers);
+  // frees every idle block
+  void Release();
+
+  Stats stats() const;
+
+ private:
+  using Key = std::tuple<VideoFrameBuffer::PixelFormat,
+                         size_t,
+                         size_t,
+                         size_t,
+                         size_t,
+                         size_t>;
+  struct State;
+
+  FrameBufferMemory Acquire(const Key& key, size_t size);
+
+  const std::shared_ptr<State> state_;
+};
+
+}  // namespace ave
+
+#endif /* !VIDEO_FRAME_BUFFER_POOL_H */
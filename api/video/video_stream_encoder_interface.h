@@ -24,6 +24,19 @@ class VideoStreamEncoderInterface
   // configuration changes.
   class EncoderSink : public EncodedImageCallback {};
 
+  struct Stats {
+    uint64_t frames_received = 0;
+    uint64_t frames_encoded = 0;
+    // stale frames replaced by newer ones before the encoder got to them
+    uint64_t frames_dropped = 0;
+    // frames waiting for the encoder now, and the most seen
+    size_t queue_depth = 0;
+    size_t max_queue_depth = 0;
+    int64_t last_encode_time_us = 0;
+    int64_t avg_encode_time_us = 0;
+    int64_t max_encode_time_us = 0;
+  };
+
   virtual void SetSource(
       VideoSourceInterface<std::shared_ptr<VideoFrame>>* source) = 0;
 
@@ -31,6 +44,11 @@ class VideoStreamEncoderInterface
 
   virtual void SetStartBitrate(int start_bitrate_bps) = 0;
 
+  // changes the rates of the running encoder, they are kept across encoder
+  // reconfigurations
+  virtual void SetRates(
+      const VideoEncoder::RateControlParameters& parameters) = 0;
+
   // Request a key frame. Used for signalling from the remote receiver.
   virtual void SendKeyFrame() = 0;
 
@@ -40,6 +58,9 @@ class VideoStreamEncoderInterface
   virtual void ConfigureEncoder(VideoEncoderConfig config,
                                 size_t max_data_payload_length) = 0;
 
+  // Counters of the frames queued, encoded and dropped so far.
+  virtual Stats GetStats() const = 0;
+
   // Permanently stop encoding. After this method has returned, it is
   // guaranteed that no encoded frames will be delivered to the sink.
   virtual void Stop() = 0;
@@ -0,0 +1,539 @@
+/*
+ * wrapped_frame_buffer.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "wrapped_frame_buffer.h"
+
+#include <memory>
+#include <utility>
+
+#include "api/video/i420_buffer.h"
+#include "base/checks.h"
+#include "third_party/libyuv/include/libyuv.h"
+
+namespace ave {
+
+/** WrappedI420Buffer **/
+
+// static
+std::shared_ptr<WrappedI420Buffer> WrappedI420Buffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* y_plane,
+    size_t y_stride,
+    const uint8_t* u_plane,
+    size_t u_stride,
+    const uint8_t* v_plane,
+    size_t v_stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedI420Buffer>(
+      width, height, y_plane, y_stride, u_plane, u_stride, v_plane, v_stride,
+      std::move(no_longer_used));
+}
+
+WrappedI420Buffer::WrappedI420Buffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* y_plane,
+                                     size_t y_stride,
+                                     const uint8_t* u_plane,
+                                     size_t u_stride,
+                                     const uint8_t* v_plane,
+                                     size_t v_stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      y_plane_(y_plane),
+      u_plane_(u_plane),
+      v_plane_(v_plane),
+      y_stride_(y_stride),
+      u_stride_(u_stride),
+      v_stride_(v_stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(y_stride, width);
+  AVE_DCHECK_GE(u_stride, (width + 1) / 2);
+  AVE_DCHECK_GE(v_stride, (width + 1) / 2);
+}
+
+WrappedI420Buffer::~WrappedI420Buffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedI420Buffer::type() const {
+  return Type::kHardware;
+}
+
+size_t WrappedI420Buffer::width() const {
+  return width_;
+}
+
+size_t WrappedI420Buffer::height() const {
+  return height_;
+}
+
+const uint8_t* WrappedI420Buffer::DataY() const {
+  return y_plane_;
+}
+
+const uint8_t* WrappedI420Buffer::DataU() const {
+  return u_plane_;
+}
+
+const uint8_t* WrappedI420Buffer::DataV() const {
+  return v_plane_;
+}
+
+size_t WrappedI420Buffer::StrideY() const {
+  return y_stride_;
+}
+
+size_t WrappedI420Buffer::StrideU() const {
+  return u_stride_;
+}
+
+size_t WrappedI420Buffer::StrideV() const {
+  return v_stride_;
+}
+
+/** WrappedNV12Buffer **/
+
+// static
+std::shared_ptr<WrappedNV12Buffer> WrappedNV12Buffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* y_plane,
+    size_t y_stride,
+    const uint8_t* uv_plane,
+    size_t uv_stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedNV12Buffer>(width, height, y_plane, y_stride,
+                                             uv_plane, uv_stride,
+                                             std::move(no_longer_used));
+}
+
+WrappedNV12Buffer::WrappedNV12Buffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* y_plane,
+                                     size_t y_stride,
+                                     const uint8_t* uv_plane,
+                                     size_t uv_stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      y_plane_(y_plane),
+      uv_plane_(uv_plane),
+      y_stride_(y_stride),
+      uv_stride_(uv_stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(y_stride, width);
+  AVE_DCHECK_GE(uv_stride, (width + width % 2));
+}
+
+WrappedNV12Buffer::~WrappedNV12Buffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedNV12Buffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedNV12Buffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // nv12 -> i420
+    libyuv::NV12ToI420(
+        DataY(), StrideY(), DataUV(), StrideUV(), buffer->MutableDataY(),
+        buffer->StrideY(), buffer->MutableDataU(), buffer->StrideU(),
+        buffer->MutableDataV(), buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedNV12Buffer::width() const {
+  return width_;
+}
+
+size_t WrappedNV12Buffer::height() const {
+  return height_;
+}
+
+size_t WrappedNV12Buffer::StrideY() const {
+  return y_stride_;
+}
+
+size_t WrappedNV12Buffer::StrideUV() const {
+  return uv_stride_;
+}
+
+const uint8_t* WrappedNV12Buffer::DataY() const {
+  return y_plane_;
+}
+
+const uint8_t* WrappedNV12Buffer::DataUV() const {
+  return uv_plane_;
+}
+
+/** WrappedYUYVBuffer **/
+
+// static
+std::shared_ptr<WrappedYUYVBuffer> WrappedYUYVBuffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* data,
+    size_t stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedYUYVBuffer>(width, height, data, stride,
+                                             std::move(no_longer_used));
+}
+
+WrappedYUYVBuffer::WrappedYUYVBuffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* data,
+                                     size_t stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      data_(data),
+      stride_(stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride, width * 2);
+}
+
+WrappedYUYVBuffer::~WrappedYUYVBuffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedYUYVBuffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedYUYVBuffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // yuyv -> i420
+    libyuv::YUY2ToI420(Data(), Stride(), buffer->MutableDataY(),
+                       buffer->StrideY(), buffer->MutableDataU(),
+                       buffer->StrideU(), buffer->MutableDataV(),
+                       buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedYUYVBuffer::width() const {
+  return width_;
+}
+
+size_t WrappedYUYVBuffer::height() const {
+  return height_;
+}
+
+const uint8_t* WrappedYUYVBuffer::Data() const {
+  return data_;
+}
+
+size_t WrappedYUYVBuffer::Stride() const {
+  return stride_;
+}
+
+/** WrappedNV21Buffer **/
+
+// static
+std::shared_ptr<WrappedNV21Buffer> WrappedNV21Buffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* y_plane,
+    size_t y_stride,
+    const uint8_t* vu_plane,
+    size_t vu_stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedNV21Buffer>(width, height, y_plane, y_stride,
+                                             vu_plane, vu_stride,
+                                             std::move(no_longer_used));
+}
+
+WrappedNV21Buffer::WrappedNV21Buffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* y_plane,
+                                     size_t y_stride,
+                                     const uint8_t* vu_plane,
+                                     size_t vu_stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      y_plane_(y_plane),
+      vu_plane_(vu_plane),
+      y_stride_(y_stride),
+      vu_stride_(vu_stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(y_stride, width);
+  AVE_DCHECK_GE(vu_stride, (width + width % 2));
+}
+
+WrappedNV21Buffer::~WrappedNV21Buffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedNV21Buffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedNV21Buffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // nv21 -> i420
+    libyuv::NV21ToI420(
+        DataY(), StrideY(), DataUV(), StrideUV(), buffer->MutableDataY(),
+        buffer->StrideY(), buffer->MutableDataU(), buffer->StrideU(),
+        buffer->MutableDataV(), buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedNV21Buffer::width() const {
+  return width_;
+}
+
+size_t WrappedNV21Buffer::height() const {
+  return height_;
+}
+
+size_t WrappedNV21Buffer::StrideY() const {
+  return y_stride_;
+}
+
+size_t WrappedNV21Buffer::StrideUV() const {
+  return vu_stride_;
+}
+
+const uint8_t* WrappedNV21Buffer::DataY() const {
+  return y_plane_;
+}
+
+const uint8_t* WrappedNV21Buffer::DataUV() const {
+  return vu_plane_;
+}
+
+/** WrappedUYVYBuffer **/
+
+// static
+std::shared_ptr<WrappedUYVYBuffer> WrappedUYVYBuffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* data,
+    size_t stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedUYVYBuffer>(width, height, data, stride,
+                                            std::move(no_longer_used));
+}
+
+WrappedUYVYBuffer::WrappedUYVYBuffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* data,
+                                     size_t stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      data_(data),
+      stride_(stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride, width * 2);
+}
+
+WrappedUYVYBuffer::~WrappedUYVYBuffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedUYVYBuffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedUYVYBuffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // uyvy -> i420
+    libyuv::UYVYToI420(Data(), Stride(), buffer->MutableDataY(),
+                       buffer->StrideY(), buffer->MutableDataU(),
+                       buffer->StrideU(), buffer->MutableDataV(),
+                       buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedUYVYBuffer::width() const {
+  return width_;
+}
+
+size_t WrappedUYVYBuffer::height() const {
+  return height_;
+}
+
+const uint8_t* WrappedUYVYBuffer::Data() const {
+  return data_;
+}
+
+size_t WrappedUYVYBuffer::Stride() const {
+  return stride_;
+}
+
+/** WrappedRGB24Buffer **/
+
+// static
+std::shared_ptr<WrappedRGB24Buffer> WrappedRGB24Buffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* data,
+    size_t stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedRGB24Buffer>(width, height, data, stride,
+                                             std::move(no_longer_used));
+}
+
+WrappedRGB24Buffer::WrappedRGB24Buffer(size_t width,
+                                       size_t height,
+                                       const uint8_t* data,
+                                       size_t stride,
+                                       std::function<void()> no_longer_used,
+                                       protect_parameter)
+    : width_(width),
+      height_(height),
+      data_(data),
+      stride_(stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride, width * 3);
+}
+
+WrappedRGB24Buffer::~WrappedRGB24Buffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedRGB24Buffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedRGB24Buffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // r g b bytes, libyuv names them RAW
+    libyuv::RAWToI420(Data(), Stride(), buffer->MutableDataY(),
+                      buffer->StrideY(), buffer->MutableDataU(),
+                      buffer->StrideU(), buffer->MutableDataV(),
+                      buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedRGB24Buffer::width() const {
+  return width_;
+}
+
+size_t WrappedRGB24Buffer::height() const {
+  return height_;
+}
+
+const uint8_t* WrappedRGB24Buffer::Data() const {
+  return data_;
+}
+
+size_t WrappedRGB24Buffer::Stride() const {
+  return stride_;
+}
+
+/** WrappedBGRABuffer **/
+
+// static
+std::shared_ptr<WrappedBGRABuffer> WrappedBGRABuffer::Create(
+    size_t width,
+    size_t height,
+    const uint8_t* data,
+    size_t stride,
+    std::function<void()> no_longer_used) {
+  return std::make_shared<WrappedBGRABuffer>(width, height, data, stride,
+                                            std::move(no_longer_used));
+}
+
+WrappedBGRABuffer::WrappedBGRABuffer(size_t width,
+                                     size_t height,
+                                     const uint8_t* data,
+                                     size_t stride,
+                                     std::function<void()> no_longer_used,
+                                     protect_parameter)
+    : width_(width),
+      height_(height),
+      data_(data),
+      stride_(stride),
+      no_longer_used_cb_(std::move(no_longer_used)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride, width * 4);
+}
+
+WrappedBGRABuffer::~WrappedBGRABuffer() {
+  if (no_longer_used_cb_) {
+    no_longer_used_cb_();
+  }
+}
+
+VideoFrameBuffer::Type WrappedBGRABuffer::type() const {
+  return Type::kHardware;
+}
+
+std::shared_ptr<I420BufferInterface> WrappedBGRABuffer::ToI420() {
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // b g r a bytes, libyuv names them ARGB
+    libyuv::ARGBToI420(Data(), Stride(), buffer->MutableDataY(),
+                       buffer->StrideY(), buffer->MutableDataU(),
+                       buffer->StrideU(), buffer->MutableDataV(),
+                       buffer->StrideV(), width_, height_);
+    return buffer;
+  });
+}
+
+size_t WrappedBGRABuffer::width() const {
+  return width_;
+}
+
+size_t WrappedBGRABuffer::height() const {
+  return height_;
+}
+
+const uint8_t* WrappedBGRABuffer::Data() const {
+  return data_;
+}
+
+size_t WrappedBGRABuffer::Stride() const {
+  return stride_;
+}
+
+}  // namespace ave
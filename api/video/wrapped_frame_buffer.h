@@ -0,0 +1,344 @@
+/*
+ * wrapped_frame_buffer.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef WRAPPED_FRAME_BUFFER_H
+#define WRAPPED_FRAME_BUFFER_H
+
+#include <functional>
+#include <memory>
+
+#include "api/video/video_frame_buffer.h"
+
+namespace ave {
+
+// Frame buffers which borrow pixel memory owned by someone else, e.g. a
+// mmap'd v4l2 capture buffer, instead of copying it. `no_longer_used` is
+// invoked exactly once, when the last reference to the buffer is released,
+// so the owner can recycle the memory.
+
+class WrappedI420Buffer : public I420BufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedI420Buffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* y_plane,
+      size_t y_stride,
+      const uint8_t* u_plane,
+      size_t u_stride,
+      const uint8_t* v_plane,
+      size_t v_stride,
+      std::function<void()> no_longer_used);
+
+  WrappedI420Buffer(size_t width,
+                    size_t height,
+                    const uint8_t* y_plane,
+                    size_t y_stride,
+                    const uint8_t* u_plane,
+                    size_t u_stride,
+                    const uint8_t* v_plane,
+                    size_t v_stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedI420Buffer() override;
+
+  Type type() const override;
+
+  size_t width() const override;
+  size_t height() const override;
+  const uint8_t* DataY() const override;
+  const uint8_t* DataU() const override;
+  const uint8_t* DataV() const override;
+
+  size_t StrideY() const override;
+  size_t StrideU() const override;
+  size_t StrideV() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const y_plane_;
+  const uint8_t* const u_plane_;
+  const uint8_t* const v_plane_;
+  const size_t y_stride_;
+  const size_t u_stride_;
+  const size_t v_stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedNV12Buffer : public NV12BufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedNV12Buffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* y_plane,
+      size_t y_stride,
+      const uint8_t* uv_plane,
+      size_t uv_stride,
+      std::function<void()> no_longer_used);
+
+  WrappedNV12Buffer(size_t width,
+                    size_t height,
+                    const uint8_t* y_plane,
+                    size_t y_stride,
+                    const uint8_t* uv_plane,
+                    size_t uv_stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedNV12Buffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  size_t StrideY() const override;
+  size_t StrideUV() const override;
+
+  const uint8_t* DataY() const override;
+  const uint8_t* DataUV() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const y_plane_;
+  const uint8_t* const uv_plane_;
+  const size_t y_stride_;
+  const size_t uv_stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedYUYVBuffer : public YUYVBufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedYUYVBuffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* data,
+      size_t stride,
+      std::function<void()> no_longer_used);
+
+  WrappedYUYVBuffer(size_t width,
+                    size_t height,
+                    const uint8_t* data,
+                    size_t stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedYUYVBuffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  const uint8_t* Data() const override;
+  size_t Stride() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const data_;
+  const size_t stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedNV21Buffer : public NV21BufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedNV21Buffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* y_plane,
+      size_t y_stride,
+      const uint8_t* vu_plane,
+      size_t vu_stride,
+      std::function<void()> no_longer_used);
+
+  WrappedNV21Buffer(size_t width,
+                    size_t height,
+                    const uint8_t* y_plane,
+                    size_t y_stride,
+                    const uint8_t* vu_plane,
+                    size_t vu_stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedNV21Buffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  size_t StrideY() const override;
+  size_t StrideUV() const override;
+
+  const uint8_t* DataY() const override;
+  const uint8_t* DataUV() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const y_plane_;
+  const uint8_t* const vu_plane_;
+  const size_t y_stride_;
+  const size_t vu_stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedUYVYBuffer : public UYVYBufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedUYVYBuffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* data,
+      size_t stride,
+      std::function<void()> no_longer_used);
+
+  WrappedUYVYBuffer(size_t width,
+                    size_t height,
+                    const uint8_t* data,
+                    size_t stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedUYVYBuffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  const uint8_t* Data() const override;
+  size_t Stride() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const data_;
+  const size_t stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedRGB24Buffer : public RGB24BufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedRGB24Buffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* data,
+      size_t stride,
+      std::function<void()> no_longer_used);
+
+  WrappedRGB24Buffer(size_t width,
+                     size_t height,
+                     const uint8_t* data,
+                     size_t stride,
+                     std::function<void()> no_longer_used,
+                     protect_parameter = protect_parameter());
+  ~WrappedRGB24Buffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  const uint8_t* Data() const override;
+  size_t Stride() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const data_;
+  const size_t stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+class WrappedBGRABuffer : public BGRABufferInterface {
+ protected:
+  // for private construct
+  struct protect_parameter {
+    explicit protect_parameter() {}
+  };
+
+ public:
+  static std::shared_ptr<WrappedBGRABuffer> Create(
+      size_t width,
+      size_t height,
+      const uint8_t* data,
+      size_t stride,
+      std::function<void()> no_longer_used);
+
+  WrappedBGRABuffer(size_t width,
+                    size_t height,
+                    const uint8_t* data,
+                    size_t stride,
+                    std::function<void()> no_longer_used,
+                    protect_parameter = protect_parameter());
+  ~WrappedBGRABuffer() override;
+
+  Type type() const override;
+
+  std::shared_ptr<I420BufferInterface> ToI420() override;
+
+  size_t width() const override;
+  size_t height() const override;
+
+  const uint8_t* Data() const override;
+  size_t Stride() const override;
+
+ private:
+  const size_t width_;
+  const size_t height_;
+  const uint8_t* const data_;
+  const size_t stride_;
+  std::function<void()> no_longer_used_cb_;
+};
+
+}  // namespace ave
+
+#endif /* !WRAPPED_FRAME_BUFFER_H */
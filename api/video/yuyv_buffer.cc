@@ -7,9 +7,12 @@
 
 #include "yuyv_buffer.h"
 #include <cstring>
+#include <utility>
 
 #include "api/video/i420_buffer.h"
+#include "api/video/yuyv_scale.h"
 #include "base/checks.h"
+#include "base/memory/aligned_memory.h"
 #include "third_party/libyuv/include/libyuv.h"
 #include "third_party/libyuv/include/libyuv/convert.h"
 #include "third_party/libyuv/include/libyuv/planar_functions.h"
@@ -37,25 +40,42 @@ YUYVBuffer::YUYVBuffer(size_t width,
       height_(height),
       stride_yuyv_(stride_yuyv),
       data_(static_cast<uint8_t*>(
-          base::AlignedMalloc(YUYVDataSize(height_, stride_yuyv_),
-                              kBufferAlignment))) {
+                base::AlignedMalloc(YUYVDataSize(height_, stride_yuyv_),
+                                    kBufferAlignment)),
+            base::AlignedFreeDeleter()) {
   AVE_DCHECK_GT(width, 0);
   AVE_DCHECK_GT(height, 0);
   AVE_DCHECK_GE(stride_yuyv, width);
 }
 
+YUYVBuffer::YUYVBuffer(size_t width,
+                       size_t height,
+                       size_t stride_yuyv,
+                       FrameBufferMemory data,
+                       protect_parameter)
+    : width_(width),
+      height_(height),
+      stride_yuyv_(stride_yuyv),
+      data_(std::move(data)) {
+  AVE_DCHECK_GT(width, 0);
+  AVE_DCHECK_GT(height, 0);
+  AVE_DCHECK_GE(stride_yuyv, width);
+  AVE_DCHECK(data_ != nullptr);
+}
+
 YUYVBuffer::~YUYVBuffer() = default;
 
 // static
 std::shared_ptr<YUYVBuffer> YUYVBuffer::Create(size_t width, size_t height) {
-  return std::make_shared<YUYVBuffer>(width, height);
+  return Create(width, height, (width + width % 2) * 2);
 }
 
 // static
 std::shared_ptr<YUYVBuffer> YUYVBuffer::Create(size_t width,
                                                size_t height,
                                                size_t stride_yuyv) {
-  return std::make_shared<YUYVBuffer>(width, height, stride_yuyv);
+  return VideoFrameBufferPool::Default()->CreateYUYVBuffer(width, height,
+                                                           stride_yuyv);
 }
 
 // static
@@ -85,13 +105,15 @@ std::shared_ptr<YUYVBuffer> YUYVBuffer::Copy(const uint8_t* data,
 }
 
 std::shared_ptr<I420BufferInterface> YUYVBuffer::ToI420() {
-  std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
-  // yuyv -> i420
-  libyuv::YUY2ToI420(Data(), Stride(), buffer->MutableDataY(),
-                     buffer->StrideY(), buffer->MutableDataU(),
-                     buffer->StrideU(), buffer->MutableDataV(),
-                     buffer->StrideV(), width_, height_);
-  return buffer;
+  return CachedI420([this]() {
+    std::shared_ptr<I420Buffer> buffer = I420Buffer::Create(width_, height_);
+    // yuyv -> i420
+    libyuv::YUY2ToI420(Data(), Stride(), buffer->MutableDataY(),
+                       buffer->StrideY(), buffer->MutableDataU(),
+                       buffer->StrideU(), buffer->MutableDataV(),
+                       buffer->StrideV(), width_, height_);
+    return buffer;
+  });
 }
 
 size_t YUYVBuffer::width() const {
@@ -111,6 +133,7 @@ const uint8_t* YUYVBuffer::Data() const {
 }
 
 uint8_t* YUYVBuffer::MutableData() {
+  ResetCachedI420();
   return data_.get();
 }
 
@@ -125,7 +148,13 @@ void YUYVBuffer::CropAndScaleFrom(const YUYVBufferInterface& src,
   AVE_CHECK_LE(crop_height + offset_y, src.height());
   AVE_CHECK_GE(offset_x, 0);
   AVE_CHECK_GE(offset_y, 0);
-  // TODO(youfa) not support now
+
+  // a pixel pair shares its chroma, start the crop on a pair
+  offset_x = offset_x / 2 * 2;
+
+  const uint8_t* data = src.Data() + src.Stride() * offset_y + offset_x * 2;
+  ScaleYUYV(data, src.Stride(), crop_width, crop_height, MutableData(),
+            Stride(), width(), height());
 }
 
 }  // namespace ave
@@ -11,7 +11,7 @@
 #include <memory>
 
 #include "api/video/video_frame_buffer.h"
-#include "base/memory/aligned_memory.h"
+#include "api/video/video_frame_buffer_pool.h"
 
 namespace ave {
 
@@ -47,6 +47,13 @@ class YUYVBuffer : public YUYVBufferInterface {
              size_t stride_yuyv,
              protect_parameter = protect_parameter());
 
+  // takes `data`, e.g. recycled by a VideoFrameBufferPool
+  YUYVBuffer(size_t width,
+             size_t height,
+             size_t stride_yuyv,
+             FrameBufferMemory data,
+             protect_parameter = protect_parameter());
+
   ~YUYVBuffer() override;
 
   size_t width() const override;
@@ -59,6 +66,8 @@ class YUYVBuffer : public YUYVBufferInterface {
 
   std::shared_ptr<I420BufferInterface> ToI420() override;
 
+  // Scale the cropped area of `src` to the size of `this` buffer, and
+  // write the result into `this`.
   void CropAndScaleFrom(const YUYVBufferInterface& src,
                         size_t offset_x,
                         size_t offset_y,
@@ -69,7 +78,7 @@ class YUYVBuffer : public YUYVBufferInterface {
   const size_t width_;
   const size_t height_;
   const size_t stride_yuyv_;
-  const std::unique_ptr<uint8_t, base::AlignedFreeDeleter> data_;
+  const FrameBufferMemory data_;
 };
 
 }  // namespace ave
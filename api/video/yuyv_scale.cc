@@ -0,0 +1,336 @@
+/*
+ * yuyv_scale.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "yuyv_scale.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "base/checks.h"
+
+namespace ave {
+
+namespace {
+
+// distance between two samples of a component in a YUYV row
+constexpr size_t kLumaStep = 2;
+constexpr size_t kChromaStep = 4;
+// offsets of the components in a packed 4:2:2 pixel pair
+struct Packed422Layout {
+  size_t y;
+  size_t u;
+  size_t v;
+};
+constexpr Packed422Layout kYUYVLayout = {0, 1, 3};
+constexpr Packed422Layout kUYVYLayout = {1, 0, 2};
+constexpr size_t kBlendChunk = 32;
+// samples a box averages at most, so 16 bit sums of them cannot overflow
+constexpr size_t kMaxBoxCount = 256;
+
+// How every destination sample is made of the source. Mild scales blend the
+// two samples around it, `first` and `second` by the 8 bit `weight` of the
+// second one. Downscales of 2x and more average the `count` samples from
+// `first` on instead, as 2 taps would skip samples and alias there, dividing
+// by a multiply with the 16 bit fixed point `reciprocal` of the count.
+// Offsets are in bytes, or rows for the vertical taps.
+struct Taps {
+  bool box = false;
+  std::vector<int32_t> first;
+  std::vector<int32_t> second;
+  std::vector<uint16_t> weight;
+  std::vector<uint16_t> count;
+  std::vector<uint16_t> reciprocal;
+};
+
+// a box has 2 samples at least, so the reciprocal fits 16 bits
+uint16_t Reciprocal(uint32_t count) {
+  AVE_DCHECK_GE(count, 2u);
+  return static_cast<uint16_t>((65536 + count / 2) / count);
+}
+
+// the rounded `sum` of `count` samples divided by their count, a 16 bit
+// multiply high which SSE2 and NEON have
+inline uint8_t Average(uint16_t sum, uint16_t count, uint16_t reciprocal) {
+  return static_cast<uint8_t>(
+      (static_cast<uint32_t>(static_cast<uint16_t>(sum + count / 2)) *
+       reciprocal) >>
+      16);
+}
+
+// `step` is the distance between two samples of the component in the row
+Taps ComputeTaps(size_t src_length, size_t dst_length, size_t step) {
+  AVE_DCHECK_GT(src_length, 0);
+  AVE_DCHECK_GT(dst_length, 0);
+  Taps taps;
+  taps.first.resize(dst_length);
+
+  if (src_length >= 2 * dst_length) {
+    taps.box = true;
+    taps.count.resize(dst_length);
+    taps.reciprocal.resize(dst_length);
+    for (size_t i = 0; i < dst_length; i++) {
+      const size_t first = i * src_length / dst_length;
+      const size_t last = (i + 1) * src_length / dst_length;
+      taps.first[i] = static_cast<int32_t>(first * step);
+      taps.count[i] = static_cast<uint16_t>(
+          std::min<size_t>(last - first, kMaxBoxCount));
+      taps.reciprocal[i] = Reciprocal(taps.count[i]);
+    }
+    return taps;
+  }
+
+  taps.second.resize(dst_length);
+  taps.weight.resize(dst_length);
+  // sample at pixel centers, (i + 0.5) * src / dst - 0.5 in 1/256 steps
+  const int64_t max_position = static_cast<int64_t>(src_length - 1) * 256;
+  for (size_t i = 0; i < dst_length; i++) {
+    int64_t position =
+        static_cast<int64_t>((2 * i + 1) * src_length * 256 /
+                             (2 * dst_length)) -
+        128;
+    position = std::clamp<int64_t>(position, 0, max_position);
+    const size_t first = static_cast<size_t>(position >> 8);
+    taps.first[i] = static_cast<int32_t>(first * step);
+    taps.second[i] =
+        static_cast<int32_t>(std::min(first + 1, src_length - 1) * step);
+    taps.weight[i] = static_cast<uint16_t>(position & 255);
+  }
+  return taps;
+}
+
+// vertical box over the whole packed row
+void AverageRows(const uint8_t* src,
+                 size_t src_stride,
+                 const Taps& y_taps,
+                 size_t row,
+                 size_t length,
+                 uint8_t* blended) {
+  const uint8_t* row0 = src + y_taps.first[row] * src_stride;
+  const uint16_t count = y_taps.count[row];
+  const uint16_t reciprocal = y_taps.reciprocal[row];
+  size_t i = 0;
+  // chunked like BlendRows, the 16 bit sums hold up to kMaxBoxCount rows
+  for (; i + kBlendChunk <= length; i += kBlendChunk) {
+    uint16_t sums[kBlendChunk] = {};
+    for (uint16_t r = 0; r < count; r++) {
+      uint8_t line[kBlendChunk];
+      memcpy(line, row0 + r * src_stride + i, kBlendChunk);
+      for (size_t j = 0; j < kBlendChunk; j++) {
+        sums[j] += line[j];
+      }
+    }
+    uint8_t out[kBlendChunk];
+    for (size_t j = 0; j < kBlendChunk; j++) {
+      out[j] = Average(sums[j], count, reciprocal);
+    }
+    memcpy(blended + i, out, kBlendChunk);
+  }
+  for (; i < length; i++) {
+    uint16_t sum = 0;
+    for (uint16_t r = 0; r < count; r++) {
+      sum += row0[r * src_stride + i];
+    }
+    blended[i] = Average(sum, count, reciprocal);
+  }
+}
+
+// vertical pass over the whole packed row, all components at once
+void BlendRows(const uint8_t* src,
+               size_t src_stride,
+               const Taps& y_taps,
+               size_t row,
+               size_t length,
+               uint8_t* blended) {
+  if (y_taps.box) {
+    AverageRows(src, src_stride, y_taps, row, length, blended);
+    return;
+  }
+  const uint8_t* row0 = src + y_taps.first[row] * src_stride;
+  const uint8_t* row1 = src + y_taps.second[row] * src_stride;
+  const uint16_t weight = y_taps.weight[row];
+  if (weight == 0) {
+    memcpy(blended, row0, length);
+    return;
+  }
+  const uint16_t inverse = 256 - weight;
+  size_t i = 0;
+  // fixed size chunks through locals, which cannot alias, so the compiler
+  // vectorizes them at -O2 as well
+  for (; i + kBlendChunk <= length; i += kBlendChunk) {
+    uint8_t a[kBlendChunk];
+    uint8_t b[kBlendChunk];
+    uint8_t out[kBlendChunk];
+    memcpy(a, row0 + i, kBlendChunk);
+    memcpy(b, row1 + i, kBlendChunk);
+    for (size_t j = 0; j < kBlendChunk; j++) {
+      out[j] = static_cast<uint8_t>(
+          static_cast<uint16_t>(a[j] * inverse + b[j] * weight + 128) >> 8);
+    }
+    memcpy(blended + i, out, kBlendChunk);
+  }
+  for (; i < length; i++) {
+    blended[i] = static_cast<uint8_t>(
+        static_cast<uint16_t>(row0[i] * inverse + row1[i] * weight + 128) >> 8);
+  }
+}
+
+// horizontal pass for one component of a blended row, `kSrcStep` is the
+// distance between two samples of the component in the row
+template <size_t kSrcStep, size_t kDstStep>
+void SampleRow(const uint8_t* src, const Taps& x_taps, uint8_t* dst) {
+  const size_t length = x_taps.first.size();
+  const int32_t* first = x_taps.first.data();
+  if (x_taps.box) {
+    const uint16_t* count = x_taps.count.data();
+    const uint16_t* reciprocal = x_taps.reciprocal.data();
+    for (size_t i = 0; i < length; i++) {
+      const uint8_t* samples = src + first[i];
+      uint16_t sum = 0;
+      for (uint16_t k = 0; k < count[i]; k++) {
+        sum += samples[k * kSrcStep];
+      }
+      dst[i * kDstStep] = Average(sum, count[i], reciprocal[i]);
+    }
+    return;
+  }
+  const int32_t* second = x_taps.second.data();
+  const uint16_t* weight = x_taps.weight.data();
+  for (size_t i = 0; i < length; i++) {
+    dst[i * kDstStep] = static_cast<uint8_t>(
+        static_cast<uint16_t>(src[first[i]] * (256 - weight[i]) +
+                              src[second[i]] * weight[i] + 128) >>
+        8);
+  }
+}
+
+// scales to planar 4:2:0 output, `dst_chroma_step` is 1 for I420 and 2 for
+// the interleaved NV12 plane
+void ScalePacked422To420(const Packed422Layout& layout,
+                         const uint8_t* src,
+                         size_t src_stride,
+                         size_t src_width,
+                         size_t src_height,
+                         uint8_t* dst_y,
+                         size_t dst_stride_y,
+                         uint8_t* dst_u,
+                         size_t dst_stride_u,
+                         uint8_t* dst_v,
+                         size_t dst_stride_v,
+                         size_t dst_chroma_step,
+                         size_t dst_width,
+                         size_t dst_height) {
+  const size_t row_length = (src_width + src_width % 2) * 2;
+  const Taps luma_x = ComputeTaps(src_width, dst_width, kLumaStep);
+  const Taps luma_y = ComputeTaps(src_height, dst_height, 1);
+  // source chroma is full height, destination chroma half height
+  const Taps chroma_x =
+      ComputeTaps((src_width + 1) / 2, (dst_width + 1) / 2, kChromaStep);
+  const Taps chroma_y = ComputeTaps(src_height, (dst_height + 1) / 2, 1);
+
+  std::vector<uint8_t> blended(row_length);
+  for (size_t row = 0; row < dst_height; row++) {
+    BlendRows(src, src_stride, luma_y, row, row_length, blended.data());
+    SampleRow<kLumaStep, 1>(blended.data() + layout.y, luma_x,
+                            dst_y + row * dst_stride_y);
+    if (row % 2 == 0) {
+      const size_t chroma_row = row / 2;
+      BlendRows(src, src_stride, chroma_y, chroma_row, row_length,
+                blended.data());
+      uint8_t* u = dst_u + chroma_row * dst_stride_u;
+      uint8_t* v = dst_v + chroma_row * dst_stride_v;
+      if (dst_chroma_step == 1) {
+        SampleRow<kChromaStep, 1>(blended.data() + layout.u, chroma_x, u);
+        SampleRow<kChromaStep, 1>(blended.data() + layout.v, chroma_x, v);
+      } else {
+        SampleRow<kChromaStep, 2>(blended.data() + layout.u, chroma_x, u);
+        SampleRow<kChromaStep, 2>(blended.data() + layout.v, chroma_x, v);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void ScaleYUYV(const uint8_t* src,
+               size_t src_stride,
+               size_t src_width,
+               size_t src_height,
+               uint8_t* dst,
+               size_t dst_stride,
+               size_t dst_width,
+               size_t dst_height) {
+  const size_t row_length = (src_width + src_width % 2) * 2;
+  // keep the last pixel pair complete for odd widths
+  const size_t padded_width = dst_width + dst_width % 2;
+  const Taps luma_x = ComputeTaps(src_width, padded_width, kLumaStep);
+  const Taps chroma_x =
+      ComputeTaps((src_width + 1) / 2, padded_width / 2, kChromaStep);
+  const Taps rows = ComputeTaps(src_height, dst_height, 1);
+
+  std::vector<uint8_t> blended(row_length);
+  for (size_t row = 0; row < dst_height; row++) {
+    uint8_t* dst_row = dst + row * dst_stride;
+    BlendRows(src, src_stride, rows, row, row_length, blended.data());
+    SampleRow<kLumaStep, kLumaStep>(blended.data(), luma_x, dst_row);
+    SampleRow<kChromaStep, kChromaStep>(blended.data() + kYUYVLayout.u,
+                                        chroma_x, dst_row + kYUYVLayout.u);
+    SampleRow<kChromaStep, kChromaStep>(blended.data() + kYUYVLayout.v,
+                                        chroma_x, dst_row + kYUYVLayout.v);
+  }
+}
+
+void ScaleYUYVToI420(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_u,
+                     size_t dst_stride_u,
+                     uint8_t* dst_v,
+                     size_t dst_stride_v,
+                     size_t dst_width,
+                     size_t dst_height) {
+  ScalePacked422To420(kYUYVLayout, src, src_stride, src_width, src_height,
+                      dst_y, dst_stride_y, dst_u, dst_stride_u, dst_v,
+                      dst_stride_v, 1, dst_width, dst_height);
+}
+
+void ScaleYUYVToNV12(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_uv,
+                     size_t dst_stride_uv,
+                     size_t dst_width,
+                     size_t dst_height) {
+  ScalePacked422To420(kYUYVLayout, src, src_stride, src_width, src_height,
+                      dst_y, dst_stride_y, dst_uv, dst_stride_uv, dst_uv + 1,
+                      dst_stride_uv, 2, dst_width, dst_height);
+}
+
+void ScaleUYVYToI420(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_u,
+                     size_t dst_stride_u,
+                     uint8_t* dst_v,
+                     size_t dst_stride_v,
+                     size_t dst_width,
+                     size_t dst_height) {
+  ScalePacked422To420(kUYVYLayout, src, src_stride, src_width, src_height,
+                      dst_y, dst_stride_y, dst_u, dst_stride_u, dst_v,
+                      dst_stride_v, 1, dst_width, dst_height);
+}
+
+}  // namespace ave
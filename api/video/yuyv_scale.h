@@ -0,0 +1,73 @@
+/*
+ * yuyv_scale.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef YUYV_SCALE_H
+#define YUYV_SCALE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ave {
+
+// Scaling kernels reading packed YUYV/UYVY (4:2:2) directly, libyuv has no
+// scaler for them. Bilinear, and a box filter per axis downscaled by 2x or
+// more. `src` points at the first pixel of the area to scale, which must
+// start on an even column.
+
+// YUYV -> scaled YUYV
+void ScaleYUYV(const uint8_t* src,
+               size_t src_stride,
+               size_t src_width,
+               size_t src_height,
+               uint8_t* dst,
+               size_t dst_stride,
+               size_t dst_width,
+               size_t dst_height);
+
+// YUYV -> scaled I420 in one pass, without an intermediate full size I420.
+void ScaleYUYVToI420(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_u,
+                     size_t dst_stride_u,
+                     uint8_t* dst_v,
+                     size_t dst_stride_v,
+                     size_t dst_width,
+                     size_t dst_height);
+
+// YUYV -> scaled NV12 in one pass.
+void ScaleYUYVToNV12(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_uv,
+                     size_t dst_stride_uv,
+                     size_t dst_width,
+                     size_t dst_height);
+
+// UYVY -> scaled I420 in one pass.
+void ScaleUYVYToI420(const uint8_t* src,
+                     size_t src_stride,
+                     size_t src_width,
+                     size_t src_height,
+                     uint8_t* dst_y,
+                     size_t dst_stride_y,
+                     uint8_t* dst_u,
+                     size_t dst_stride_u,
+                     uint8_t* dst_v,
+                     size_t dst_stride_v,
+                     size_t dst_width,
+                     size_t dst_height);
+
+}  // namespace ave
+
+#endif /* !YUYV_SCALE_H */
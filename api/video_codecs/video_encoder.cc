@@ -7,11 +7,125 @@
 
 #include "video_encoder.h"
 
+#if defined(AVE_LINUX)
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+
 #include "base/types.h"
 #include "common/video_codec_property.h"
 
 namespace ave {
 
+namespace {
+#if defined(AVE_LINUX)
+// cores a cpu quota of quota_us per period_us grants, 0 if unlimited
+int QuotaCores(int64_t quota_us, int64_t period_us) {
+  if (quota_us <= 0 || period_us <= 0) {
+    return 0;
+  }
+  return static_cast<int>((quota_us + period_us - 1) / period_us);
+}
+
+// cores granted by the cpu.max of a cgroup v2 directory, 0 if unlimited
+int CgroupV2QuotaCores(const std::string& dir) {
+  std::ifstream cpu_max(dir + "/cpu.max");
+  std::string quota;
+  int64_t period = 0;
+  if (!(cpu_max >> quota >> period) || quota == "max") {
+    return 0;
+  }
+  return QuotaCores(strtoll(quota.c_str(), nullptr, 10), period);
+}
+
+// cores granted by the cfs quota of a cgroup v1 cpu directory, 0 if unlimited
+int CgroupV1QuotaCores(const std::string& dir) {
+  std::ifstream quota_file(dir + "/cpu.cfs_quota_us");
+  std::ifstream period_file(dir + "/cpu.cfs_period_us");
+  int64_t quota = 0;
+  int64_t period = 0;
+  if (!(quota_file >> quota) || !(period_file >> period)) {
+    return 0;
+  }
+  return QuotaCores(quota, period);
+}
+
+// the tightest quota of the cgroup at `path` below `root` and its ancestors,
+// a cgroup can't use more than its parents grant. Directories missing because
+// the process sits in a cgroup namespace, or a container mounting only its own
+// subtree, are skipped up to the root.
+int CgroupTreeQuotaCores(const std::string& root,
+                         std::string path,
+                         int (*quota_cores)(const std::string&)) {
+  int cores = 0;
+  while (true) {
+    const int cgroup_cores = quota_cores(root + path);
+    if (cgroup_cores > 0 && (cores == 0 || cgroup_cores < cores)) {
+      cores = cgroup_cores;
+    }
+    if (path.empty() || path == "/") {
+      return cores;
+    }
+    path.erase(path.rfind('/'));
+  }
+}
+
+// cores granted by the cgroup cpu quota, 0 if unlimited or unknown. The cgroup
+// of the process is resolved from /proc/self/cgroup, for the unified v2
+// hierarchy ("0::<path>") and the v1 cpu controller ("<id>:cpu,...:<path>").
+int CgroupQuotaCores() {
+  std::ifstream self_cgroup("/proc/self/cgroup");
+  std::string line;
+  int cores = 0;
+  while (std::getline(self_cgroup, line)) {
+    const size_t first = line.find(':');
+    const size_t second =
+        first == std::string::npos ? first : line.find(':', first + 1);
+    if (second == std::string::npos) {
+      continue;
+    }
+    const std::string controllers = line.substr(first + 1, second - first - 1);
+    const std::string path = line.substr(second + 1);
+
+    int cgroup_cores = 0;
+    if (controllers.empty()) {
+      cgroup_cores =
+          CgroupTreeQuotaCores("/sys/fs/cgroup", path, CgroupV2QuotaCores);
+    } else if (("," + controllers + ",").find(",cpu,") != std::string::npos) {
+      cgroup_cores =
+          CgroupTreeQuotaCores("/sys/fs/cgroup/cpu", path, CgroupV1QuotaCores);
+    }
+    if (cgroup_cores > 0 && (cores == 0 || cgroup_cores < cores)) {
+      cores = cgroup_cores;
+    }
+  }
+  return cores;
+}
+#endif
+}  // namespace
+
+int VideoEncoder::DetectNumberOfCores() {
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+#if defined(AVE_LINUX)
+  // a cpuset cgroup or taskset narrows the affinity mask
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    cores = CPU_COUNT(&cpu_set);
+  }
+  const int quota_cores = CgroupQuotaCores();
+  if (quota_cores > 0) {
+    cores = std::min(cores, quota_cores);
+  }
+#endif
+  return std::max(cores, 1);
+}
+
 H264Specific VideoEncoder::GetDefaultH264Specific() {
   H264Specific h264_specific;
   memset(&h264_specific, 0, sizeof(h264_specific));
@@ -55,4 +169,6 @@ status_t VideoEncoder::InitEncoder(const VideoCodecProperty& codec_settings,
                                    const Settings& settings) {
   return OK;
 }
+
+void VideoEncoder::SetRates(const RateControlParameters& parameters) {}
 }  // namespace ave
@@ -12,6 +12,7 @@
 
 #include "api/video/encoded_image.h"
 #include "api/video/video_frame.h"
+#include "api/video_codecs/video_encoder_config.h"
 #include "common/video_codec_property.h"
 
 namespace ave {
@@ -78,6 +79,16 @@ class VideoEncoder {
     Capabilities capabilities;
     int number_of_cores;
     size_t max_payload_size;
+    RateControlMode rate_control_mode = RateControlMode::kBitrate;
+  };
+
+  struct RateControlParameters {
+    RateControlParameters(uint32_t bitrate_bps, double framerate_fps)
+        : bitrate_bps(bitrate_bps), framerate_fps(framerate_fps) {}
+
+    // 0 pauses the stream until a non zero rate comes
+    uint32_t bitrate_bps;
+    double framerate_fps;
   };
 
   static VP8Specific GetDefaultVp8Specific();
@@ -85,6 +96,10 @@ class VideoEncoder {
   static H264Specific GetDefaultH264Specific();
   static H265Specific GetDefaultH265Specific();
 
+  // cores this process may run on, the cpuset and affinity mask it got and
+  // the cgroup cpu quota, at least 1
+  static int DetectNumberOfCores();
+
   virtual ~VideoEncoder() = default;
 
   virtual status_t InitEncoder(const VideoCodecProperty& codec_settings,
@@ -97,8 +112,9 @@ class VideoEncoder {
 
   virtual status_t Encode(const std::shared_ptr<VideoFrame>& frame) = 0;
 
-  // ongoing rate control
-  // virtual void SetRate(rate);
+  // ongoing rate control, applied to the next frame without an encoder
+  // reset, the bitrate is kept within the range given at init
+  virtual void SetRates(const RateControlParameters& parameters);
 
   // request key frame on-going
   virtual void RequestKeyFrame() = 0;
@@ -54,6 +54,9 @@ VideoEncoderConfig::VideoEncoderConfig()
       //     encoder_specific_settings(nullptr),
       min_bitrate_kbps(0),
       max_bitrate_kbps(0),
+      target_bitrate_kbps(0),
+      max_framerate(0),
+      rate_control_mode(RateControlMode::kBitrate),
       bitrate_priority(1.0),
       number_of_streams(0),
       is_quality_scaling_allowed(false) {}
@@ -80,6 +83,9 @@ std::string VideoEncoderConfig::ToString() const {
 
   ss << ", min_bitrate_bps: " << min_bitrate_kbps;
   ss << ", max_bitrate_bps: " << max_bitrate_kbps;
+  ss << ", target_bitrate_kbps: " << target_bitrate_kbps;
+  ss << ", max_framerate: " << max_framerate;
+  ss << ", rate_control_mode: " << static_cast<int>(rate_control_mode);
   ss << '}';
   return ss.str();
 }
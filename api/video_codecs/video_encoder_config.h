@@ -17,6 +17,16 @@
 #include "common/video_codec_property.h"
 
 namespace ave {
+// How the encoder spends bits.
+enum class RateControlMode {
+  // holds the target bitrate, quality follows the scene
+  kBitrate,
+  // holds the quality, bitrate stays under the max
+  kQuality,
+  // follows the fill of the send buffer, no target
+  kBufferBased,
+};
+
 // The `VideoStreamConfig` struct describes a simulcast layer, or "stream".
 struct VideoStreamConfig {
   VideoStreamConfig();
@@ -156,6 +166,11 @@ class VideoEncoderConfig {
   // unless the estimated bandwidth indicates that the link can handle it.
   int min_bitrate_kbps;
   int max_bitrate_kbps;
+  // rate the encoder aims for within [min, max], max if unset
+  int target_bitrate_kbps;
+  // frame rate the encoder is tuned for, the default if unset
+  int max_framerate;
+  RateControlMode rate_control_mode;
   // The bitrate priority used for all VideoStreamConfigs.
   double bitrate_priority;
 
@@ -8,6 +8,8 @@
 #ifndef APP_CONFIG_H
 #define APP_CONFIG_H
 
+#include <algorithm>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -16,10 +18,28 @@
 #include "third_party/inih/src/INIReader.h"
 
 namespace ave {
+// One encoded output of the camera, the main stream plus the substreams
+// scaled down from it. Each maps to an onvif profile and a rtsp session.
+struct StreamTier {
+  std::string name;
+  int width;
+  int height;
+  int min_kbps;
+  int max_kbps;
+  // rate the encoder aims for, 0 for max_kbps
+  int target_kbps;
+  // 0 encodes every captured frame
+  int max_fps;
+  std::string stream_url;
+};
+
 struct AppConfig {
   /************ oc info *************/
   float version;
   std::string v4l2_device;
+  int v4l2_buffer_count;
+  bool v4l2_export_dmabuf;
+  int frame_buffer_pool_size;
 
   /************** rtsp **************/
 
@@ -45,9 +65,27 @@ struct AppConfig {
   std::string stream_url;
   std::string snapurl;
   std::string stream_type;
+  int min_kbps;
+  int max_kbps;
+  int target_kbps;
+  int max_fps;
+  // "bitrate", "quality" or "buffer", the rate control of every stream
+  std::string rc_mode;
+  // main stream first, then the substreams from largest to smallest
+  std::vector<StreamTier> stream_tiers;
 
   // PTZ Infomation
   bool ptz_enable;
+  // "command" runs the move_* commands, "digital" crops the frame
+  std::string ptz_mode;
+  // magnification of the digital ptz at full zoom
+  float ptz_max_zoom;
+  // command mode, "script" spawns the move_* commands, "device" writes them
+  // as lines to ptz_device
+  std::string ptz_backend;
+  // serial port, UART or sysfs attribute
+  std::string ptz_device;
+  int ptz_device_baudrate;
   std::string move_left;
   std::string move_right;
   std::string move_up;
@@ -69,6 +107,12 @@ struct AppConfig {
 
     appConfig.version = reader.GetFloat("oc", "version", 0.0);
     appConfig.v4l2_device = reader.Get("oc", "v4l2_device", "/dev/video0");
+    appConfig.v4l2_buffer_count =
+        reader.GetInteger("oc", "v4l2_buffer_count", 4);
+    appConfig.v4l2_export_dmabuf =
+        reader.GetBoolean("oc", "v4l2_export_dmabuf", false);
+    appConfig.frame_buffer_pool_size =
+        reader.GetInteger("oc", "frame_buffer_pool_size", 8);
 
     // onvif device
     appConfig.onvif_port = reader.GetInteger("onvif", "onvif_port", 0);
@@ -94,12 +138,60 @@ struct AppConfig {
         reader.Get("onvif", "stream_url", "rtsp://127.0.0.1:8554/live");
     appConfig.snapurl = reader.Get("onvif", "snapurl", "https://google.com");
     appConfig.stream_type = reader.Get("onvif", "stream_type", "H264");
+    appConfig.min_kbps = reader.GetInteger("onvif", "min_kbps", 300);
+    appConfig.max_kbps = reader.GetInteger("onvif", "max_kbps", 10000);
+    appConfig.target_kbps = reader.GetInteger("onvif", "target_kbps", 4000);
+    appConfig.max_fps = reader.GetInteger("onvif", "max_fps", 30);
+    appConfig.rc_mode = reader.Get("onvif", "rc_mode", "bitrate");
+
+    appConfig.stream_tiers.push_back(
+        {appConfig.name, appConfig.width, appConfig.height, appConfig.min_kbps,
+         appConfig.max_kbps, appConfig.target_kbps, appConfig.max_fps,
+         appConfig.stream_url});
+    // substreams, each one described by a section named after it
+    std::stringstream substreams(reader.Get("onvif", "substreams", ""));
+    std::string substream;
+    while (std::getline(substreams, substream, ',')) {
+      substream.erase(0, substream.find_first_not_of(' '));
+      substream.erase(substream.find_last_not_of(' ') + 1);
+      if (substream.empty()) {
+        continue;
+      }
+      StreamTier tier;
+      tier.name = reader.Get(substream, "stream_name", substream);
+      tier.width = reader.GetInteger(substream, "width", 0);
+      tier.height = reader.GetInteger(substream, "height", 0);
+      tier.min_kbps = reader.GetInteger(substream, "min_kbps", 100);
+      tier.max_kbps = reader.GetInteger(substream, "max_kbps", 2000);
+      tier.target_kbps = reader.GetInteger(substream, "target_kbps", 0);
+      tier.max_fps = reader.GetInteger(substream, "max_fps", appConfig.max_fps);
+      tier.stream_url = reader.Get(substream, "stream_url", "");
+      if (tier.width <= 0 || tier.height <= 0 || tier.stream_url.empty() ||
+          tier.width * tier.height >= appConfig.width * appConfig.height) {
+        AVE_LOG(LS_WARNING) << "ignore substream " << substream
+                            << ", it needs stream_url and a size smaller "
+                               "than the main stream";
+        continue;
+      }
+      appConfig.stream_tiers.push_back(tier);
+    }
+    std::stable_sort(appConfig.stream_tiers.begin() + 1,
+                     appConfig.stream_tiers.end(),
+                     [](const StreamTier& a, const StreamTier& b) {
+                       return a.width * a.height > b.width * b.height;
+                     });
 
     AVE_LOG(LS_INFO) << "stream:" << appConfig.stream_url
                      << ", name:" << appConfig.name;
 
     // onvif ptz
     appConfig.ptz_enable = reader.GetBoolean("ptz", "ptz_enable", false);
+    appConfig.ptz_mode = reader.Get("ptz", "ptz_mode", "command");
+    appConfig.ptz_max_zoom = reader.GetFloat("ptz", "ptz_max_zoom", 4.0);
+    appConfig.ptz_backend = reader.Get("ptz", "ptz_backend", "script");
+    appConfig.ptz_device = reader.Get("ptz", "ptz_device", "/dev/ttyS1");
+    appConfig.ptz_device_baudrate =
+        reader.GetInteger("ptz", "ptz_device_baudrate", 9600);
     appConfig.move_left =
         reader.Get("ptz", "ptz_move_left", "oc_ptz_move_left");
     appConfig.move_right =
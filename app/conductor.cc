@@ -5,8 +5,12 @@
  * Distributed under terms of the GPLv2 license.
  */
 #include "conductor.h"
+#include <algorithm>
 #include <memory>
+#include <string>
 
+#include "api/video/video_frame_buffer_pool.h"
+#include "api/video_codecs/video_encoder_config.h"
 #include "base/checks.h"
 #include "base/logging.h"
 #include "common/message.h"
@@ -21,12 +25,40 @@ namespace {
 using EncodedAudioSink = AudioSinkInterface<MediaPacket>;
 using VideoSource = VideoSourceInterface<std::shared_ptr<VideoFrame>>;
 using EncodedVideoSink = VideoSinkInterface<EncodedImage>;
+
+// the rtsp session a stream url points at, e.g. "sub" for
+// rtsp://host:8554/sub
+std::string SessionName(const std::string& stream_url) {
+  size_t pos = stream_url.find_last_of('/');
+  return pos == std::string::npos ? stream_url : stream_url.substr(pos + 1);
+}
+
+// a camera whose capture died is restarted after this long, a few times
+// unless it captured this long since the last restart
+constexpr int64_t kCameraRestartDelayUs = 1000 * 1000;
+constexpr int64_t kCameraHealthyUs = 60 * 1000 * 1000;
+constexpr int kMaxCameraRestarts = 5;
+
+RateControlMode ParseRateControlMode(const std::string& rc_mode) {
+  if (rc_mode == "quality") {
+    return RateControlMode::kQuality;
+  }
+  if (rc_mode == "buffer") {
+    return RateControlMode::kBufferBased;
+  }
+  if (rc_mode != "bitrate") {
+    AVE_LOG(LS_WARNING) << "unknown rc_mode " << rc_mode << ", use bitrate";
+  }
+  return RateControlMode::kBitrate;
+}
 }  // namespace
 
 Conductor::Conductor(AppConfig appConfig)
     : config_(appConfig),
       looper_(std::make_shared<Looper>()),
       max_stream_id_(0),
+      camera_restarts_(0),
+      camera_restart_time_us_(0),
       video_source_(std::make_shared<H264FileSource>("data/h264.bin")) {
   AVE_DCHECK(!config_.error);
   looper_->setName("conductor");
@@ -39,6 +71,8 @@ Conductor::~Conductor() {
 
 status_t Conductor::Init() {
   status_t ret = OK;
+  VideoFrameBufferPool::Default()->SetMaxPooledBuffers(
+      std::max(config_.frame_buffer_pool_size, 0));
   looper_->start();
   looper_->registerHandler(shared_from_this());
 
@@ -49,8 +83,15 @@ status_t Conductor::Init() {
     return ret;
   }
 
+  if (config_.ptz_enable && config_.ptz_mode == "digital") {
+    DigitalPTZ::Config ptz_config;
+    ptz_config.max_zoom = std::max(config_.ptz_max_zoom, 1.0f);
+    digital_ptz_ = std::make_shared<DigitalPTZ>(ptz_config);
+  }
+
   msg = std::make_shared<Message>(kWhatOnvifNotify, shared_from_this());
   onvif_server_ = std::make_shared<OnvifServer>(config_, msg);
+  onvif_server_->SetDigitalPTZ(digital_ptz_);
 
   if ((ret = onvif_server_->Init()) != OK) {
     return ret;
@@ -93,21 +134,93 @@ uint32_t Conductor::GenerateStreamId() {
 void Conductor::AddCameraSource() {
   auto media_info = std::make_shared<Message>();
   media_info->setString("v4l2-dev", config_.v4l2_device);
+  media_info->setInt32("buffer-count", config_.v4l2_buffer_count);
+  media_info->setInt32("export-dmabuf", config_.v4l2_export_dmabuf);
   camera_source_ = V4L2VideoSource::Create(media_info);
+  camera_source_->setNotify(
+      std::make_shared<Message>(kWhatCameraNotify, shared_from_this()));
+
+  // one capturer per stream tier, each one a sink of the tier above it, so
+  // frames are scaled 1080p -> 720p -> 360p instead of 1080p -> each tier
+  VideoSource* upstream = camera_source_.get();
+  for (const auto& tier : config_.stream_tiers) {
+    VideoSinkWants wants;
+    if (upstream != camera_source_.get()) {
+      wants.max_pixel_count = tier.width * tier.height;
+      wants.resolution_alignment = 2;
+      wants.resolutions = {{tier.width, tier.height}};
+    }
 
-  int32_t id = GenerateStreamId();
-  video_capturers_.push_back({std::make_unique<VideoCapturer>(nullptr), id});
-  video_capturers_.back().capturer->SetVideoSource(camera_source_.get(),
-                                                   VideoSinkWants());
-
-  auto msg = std::make_shared<Message>(kWhatAddVideoSource, shared_from_this());
-  msg->setObject("video_source", video_capturers_.back().capturer);
-  msg->setInt32("stream_id", id);
-  msg->setInt32("codec_format",
-                static_cast<int32_t>(CodecId::AV_CODEC_ID_H264));
-  msg->setInt32("min_kbps", 300);
-  msg->setInt32("max_kbps", 10000);
-  msg->post();
+    int32_t id = GenerateStreamId();
+    video_capturers_.push_back({std::make_unique<VideoCapturer>(nullptr), id});
+    video_capturers_.back().capturer->SetVideoSource(upstream, wants);
+    // cropped once at the top, the substreams scale the cropped frames
+    if (upstream == camera_source_.get() && digital_ptz_) {
+      video_capturers_.back().capturer->SetDigitalPTZ(digital_ptz_);
+    }
+
+    auto msg =
+        std::make_shared<Message>(kWhatAddVideoSource, shared_from_this());
+    msg->setObject("video_source", video_capturers_.back().capturer);
+    msg->setInt32("stream_id", id);
+    msg->setInt32("codec_format",
+                  static_cast<int32_t>(CodecId::AV_CODEC_ID_H264));
+    msg->setInt32("min_kbps", tier.min_kbps);
+    msg->setInt32("max_kbps", tier.max_kbps);
+    msg->setInt32("target_kbps", tier.target_kbps);
+    msg->setInt32("max_fps", tier.max_fps);
+    msg->setInt32("rc_mode",
+                  static_cast<int32_t>(ParseRateControlMode(config_.rc_mode)));
+    msg->setString("session_name", SessionName(tier.stream_url));
+    msg->post();
+
+    upstream = video_capturers_.back().capturer.get();
+  }
+}
+
+void Conductor::OnCameraNotify(const std::shared_ptr<Message>& msg) {
+  int32_t what;
+  AVE_CHECK(msg->findInt32("what", &what));
+  switch (what) {
+    case V4L2VideoSource::kWhatCaptureError: {
+      int32_t err = OK;
+      msg->findInt32("err", &err);
+      AVE_LOG(LS_ERROR) << "camera capture stopped, err:" << err;
+      if (Looper::getNowUs() - camera_restart_time_us_ > kCameraHealthyUs) {
+        camera_restarts_ = 0;
+      }
+      if (camera_restarts_ >= kMaxCameraRestarts) {
+        AVE_LOG(LS_ERROR) << "camera keeps failing, give up";
+        break;
+      }
+      auto restart =
+          std::make_shared<Message>(kWhatRestartCamera, shared_from_this());
+      restart->post(kCameraRestartDelayUs);
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+}
+
+void Conductor::OnRestartCamera(const std::shared_ptr<Message>& msg) {
+  camera_restart_time_us_ = Looper::getNowUs();
+  camera_restarts_++;
+  status_t err = camera_source_->restart();
+  if (err == OK) {
+    AVE_LOG(LS_INFO) << "camera restarted";
+    return;
+  }
+  if (camera_restarts_ >= kMaxCameraRestarts) {
+    AVE_LOG(LS_ERROR) << "camera restart failed " << camera_restarts_
+                      << " times, give up, err:" << err;
+    return;
+  }
+  AVE_LOG(LS_WARNING) << "camera restart failed, err:" << err << ", retry";
+  auto restart =
+      std::make_shared<Message>(kWhatRestartCamera, shared_from_this());
+  restart->post(kCameraRestartDelayUs);
 }
 
 void Conductor::OnRtspNotify(const std::shared_ptr<Message>& msg) {
@@ -200,6 +313,16 @@ void Conductor::onMessageReceived(const std::shared_ptr<Message>& msg) {
       OnOnvifNotify(msg);
       break;
     }
+
+    case kWhatCameraNotify: {
+      OnCameraNotify(msg);
+      break;
+    }
+
+    case kWhatRestartCamera: {
+      OnRestartCamera(msg);
+      break;
+    }
     case kWhatAddVideoSource: {
       int32_t id;
       AVE_CHECK(msg->findInt32("stream_id", &id));
@@ -209,6 +332,12 @@ void Conductor::onMessageReceived(const std::shared_ptr<Message>& msg) {
       AVE_CHECK(msg->findInt32("min_kbps", &min_bitrate));
       int32_t max_bitrate;
       AVE_CHECK(msg->findInt32("max_kbps", &max_bitrate));
+      int32_t target_bitrate;
+      AVE_CHECK(msg->findInt32("target_kbps", &target_bitrate));
+      int32_t max_framerate;
+      AVE_CHECK(msg->findInt32("max_fps", &max_framerate));
+      int32_t rc_mode;
+      AVE_CHECK(msg->findInt32("rc_mode", &rc_mode));
 
       std::shared_ptr<MessageObject> obj;
       AVE_CHECK(msg->findObject("video_source", obj));
@@ -216,11 +345,16 @@ void Conductor::onMessageReceived(const std::shared_ptr<Message>& msg) {
           std::dynamic_pointer_cast<VideoSource>(obj);
       AVE_DCHECK(video_source != nullptr);
 
-      media_service_->AddVideoSource(video_source, id,
-                                     static_cast<CodecId>(codec_id),
-                                     min_bitrate, max_bitrate);
+      std::string session_name;
+      AVE_CHECK(msg->findString("session_name", session_name));
+
+      media_service_->AddVideoSource(
+          video_source, id, static_cast<CodecId>(codec_id), min_bitrate,
+          max_bitrate, target_bitrate, max_framerate,
+          static_cast<RateControlMode>(rc_mode));
 
-      rtsp_server_->RequestVideoSink(id, static_cast<CodecId>(codec_id));
+      rtsp_server_->RequestVideoSink(id, static_cast<CodecId>(codec_id),
+                                     session_name);
       break;
     }
 
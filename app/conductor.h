@@ -17,6 +17,8 @@
 #include "common/looper.h"
 #include "common/message.h"
 #include "media/media_service.h"
+#include "media/video/digital_ptz.h"
+#include "media/video/v4l2_video_source.h"
 #include "onvif/onvif_server.h"
 #include "rtsp/h264_file_source.h"
 #include "rtsp/rtsp_server.h"
@@ -45,6 +47,8 @@ class Conductor : public Handler {
   void SignalFinished();
   void OnRtspNotify(const std::shared_ptr<Message>& message);
   void OnOnvifNotify(const std::shared_ptr<Message>& message);
+  void OnCameraNotify(const std::shared_ptr<Message>& message);
+  void OnRestartCamera(const std::shared_ptr<Message>& message);
 
   void OnStart(const std::shared_ptr<Message>& message);
   void OnStop(const std::shared_ptr<Message>& message);
@@ -58,6 +62,8 @@ class Conductor : public Handler {
     kWhatRtspNotify = 'rtsp',
     kWhatOnvifNotify = 'onvf',
     kWhatMediaServiceNotify = 'meds',
+    kWhatCameraNotify = 'camn',
+    kWhatRestartCamera = 'rcam',
 
     kWhatAddVideoSource = 'avss',
 
@@ -69,10 +75,14 @@ class Conductor : public Handler {
   std::shared_ptr<RtspServer> rtsp_server_;
   std::shared_ptr<OnvifServer> onvif_server_;
   std::shared_ptr<MediaService> media_service_;
+  // set in digital ptz mode, crops the main stream
+  std::shared_ptr<DigitalPTZ> digital_ptz_;
 
   uint32_t max_stream_id_;
-  std::shared_ptr<VideoSourceInterface<std::shared_ptr<VideoFrame>>>
-      camera_source_;
+  std::shared_ptr<V4L2VideoSource> camera_source_;
+  // restarts tried since the camera last captured for a while
+  int camera_restarts_;
+  int64_t camera_restart_time_us_;
   std::shared_ptr<MediaSource> video_source_;
   std::vector<VideoCapturerPair> video_capturers_;
 
@@ -5,27 +5,44 @@
  * Distributed under terms of the GPLv2 license.
  */
 
-#include <unistd.h>
 #include <condition_variable>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <mutex>
-#include <thread>
+#include <utility>
 
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_buffer.h"
+#include "api/video/video_sink_interface.h"
 #include "base/logging.h"
 #include "common/buffer.h"
-#include "common/codec_constants.h"
 #include "common/handler.h"
+#include "common/looper.h"
 #include "common/message.h"
-#include "common/meta_data.h"
-#include "media/camera_info/default_video_source_factory.h"
-#include "v4l2_video_source.h"
-#include "video_source_factory.h"
+#include "media/video/v4l2_video_source.h"
 
 using namespace ave;
 
+namespace {
+
+constexpr int kDumpFrames = 100;
+
 std::mutex mutex_;
 std::condition_variable condition_;
+bool finished_ = false;
+
+void CopyPlane(uint8_t* dst,
+               const uint8_t* src,
+               size_t stride,
+               size_t width,
+               size_t height) {
+  for (size_t i = 0; i < height; i++) {
+    memcpy(dst + i * width, src + i * stride, width);
+  }
+}
+
+}  // namespace
 
 class ImageWriter : public Handler {
  public:
@@ -72,58 +89,94 @@ void ImageWriter::onMessageReceived(const std::shared_ptr<Message>& message) {
     }
 
     case kWhatStop: {
+      std::lock_guard<std::mutex> l(mutex_);
+      finished_ = true;
       condition_.notify_all();
       break;
     }
   }
 }
 
+// Dumps the first frames as packed i420, whatever format the camera captures.
+class FrameDumper : public VideoSinkInterface<std::shared_ptr<VideoFrame>> {
+ public:
+  FrameDumper(std::shared_ptr<ImageWriter> writer, int frames)
+      : mWriter(std::move(writer)), mFrames(frames), mDumped(0) {}
+
+  void OnFrame(const std::shared_ptr<VideoFrame>& frame) override {
+    if (mDumped >= mFrames) {
+      return;
+    }
+
+    auto i420 = frame->video_frame_buffer()->ToI420();
+    const size_t width = i420->width();
+    const size_t height = i420->height();
+    const size_t chroma_width = i420->ChromaWidth();
+    const size_t chroma_height = i420->ChromaHeight();
+    auto buffer = std::make_shared<Buffer>(width * height +
+                                           2 * chroma_width * chroma_height);
+    uint8_t* data = buffer->data();
+    CopyPlane(data, i420->DataY(), i420->StrideY(), width, height);
+    data += width * height;
+    CopyPlane(data, i420->DataU(), i420->StrideU(), chroma_width,
+              chroma_height);
+    data += chroma_width * chroma_height;
+    CopyPlane(data, i420->DataV(), i420->StrideV(), chroma_width,
+              chroma_height);
+
+    auto msg = std::make_shared<Message>(ImageWriter::kWhatVideoFrame, mWriter);
+    msg->setBuffer("buffer", buffer);
+    msg->post();
+
+    if (++mDumped == mFrames) {
+      std::make_shared<Message>(ImageWriter::kWhatStop, mWriter)->post();
+    }
+  }
+
+ private:
+  std::shared_ptr<ImageWriter> mWriter;
+  const int mFrames;
+  int mDumped;
+};
+
 int main(int argc, char* argv[]) {
   ave::base::LogMessage::LogToDebug(LS_VERBOSE);
 
+  if (argc < 2) {
+    AVE_LOG(LS_ERROR) << "usage: " << argv[0] << " /dev/videoX";
+    return -1;
+  }
+
   auto writer = std::make_shared<ImageWriter>("frame.yuv");
   writer->init();
 
-  // auto source(std::make_unique<V4L2VideoSource>(argv[1]));
-  auto source_factory = CreateDefaultVideoSourceFactory();
   auto video_info = std::make_shared<Message>();
   video_info->setString("v4l2-dev", argv[1]);
-  auto source = source_factory->CreateVideoSource(video_info);
+  auto source = V4L2VideoSource::Create(video_info);
 
-  MetaData metaData;
-  metaData.setInt32(kKeyWidth, 1920);
-  metaData.setInt32(kKeyHeight, 1080);
-  metaData.setInt32(kKeyColorFormat, COLOR_FormatYUV420Planar);
-
-  int ret = source->start(&metaData);
-
-  AVE_LOG(LS_INFO) << "start ret: " << ret;
-
-  if (ret < 0) {
-    return ret;
+  for (auto pixel_format : source->supportedPixelFormats()) {
+    AVE_LOG(LS_INFO) << "usable pixel format: "
+                     << static_cast<int32_t>(pixel_format);
   }
-
-  for (int i = 0; i < 100; i++) {
-    std::shared_ptr<Buffer> buffer;
-    ret = source->read(buffer);
-    AVE_LOG(LS_INFO) << "read ret:" << ret << ", size:" << buffer->size();
-    if (ret != OK) {
-      continue;
-    }
-    auto msg = std::make_shared<Message>(ImageWriter::kWhatVideoFrame, writer);
-    msg->setBuffer("buffer", buffer);
-    msg->post();
-
-    usleep(5000);
+  if (source->fourcc() == 0) {
+    AVE_LOG(LS_ERROR) << "no usable format on " << argv[1];
+    return -1;
   }
-  source->stop();
+  AVE_LOG(LS_INFO) << "capturing "
+                   << V4L2VideoSource::fourccToString(source->fourcc()) << " "
+                   << source->width() << "x" << source->height();
 
-  AVE_LOG(LS_INFO) << "source stop";
+  FrameDumper dumper(writer, kDumpFrames);
+  source->AddOrUpdateSink(&dumper, VideoSinkWants());
 
-  auto msg = std::make_shared<Message>(ImageWriter::kWhatStop, writer);
-  msg->post();
+  {
+    std::unique_lock<std::mutex> l(mutex_);
+    condition_.wait(l, [] { return finished_; });
+  }
 
-  std::unique_lock<std::mutex> l_(mutex_);
-  condition_.wait(l_);
+  source->RemoveSink(&dumper);
+  source->stop();
+  AVE_LOG(LS_INFO) << "dropped:" << source->frame_dropped()
+                   << ", lost:" << source->frame_lost();
   AVE_LOG(LS_INFO) << "end";
 }
@@ -0,0 +1,177 @@
+/*
+ * v4l2_capture_benchmark.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+// Measures, for every pixel format the camera offers, how long a frame takes
+// from VIDIOC_DQBUF to reaching a sink and to being available as i420, which
+// is what the encoder asks for.
+//
+//   v4l2_capture_benchmark /dev/videoX [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "api/video/video_frame_buffer.h"
+#include "api/video/video_frame_buffer_pool.h"
+#include "api/video/video_sink_interface.h"
+#include "base/logging.h"
+#include "common/codec_constants.h"
+#include "common/looper.h"
+#include "common/message.h"
+#include "common/meta_data.h"
+#include "media/video/v4l2_video_source.h"
+
+using namespace ave;
+
+namespace {
+
+constexpr int kDefaultFrames = 300;
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+
+struct LatencyStats {
+  int64_t min_us;
+  int64_t avg_us;
+  int64_t p99_us;
+  int64_t max_us;
+};
+
+LatencyStats Summarize(std::vector<int64_t> samples) {
+  LatencyStats stats = {};
+  if (samples.empty()) {
+    return stats;
+  }
+  std::sort(samples.begin(), samples.end());
+  int64_t total = 0;
+  for (auto sample : samples) {
+    total += sample;
+  }
+  stats.min_us = samples.front();
+  stats.avg_us = total / static_cast<int64_t>(samples.size());
+  stats.p99_us = samples[samples.size() * 99 / 100];
+  stats.max_us = samples.back();
+  return stats;
+}
+
+class LatencySink : public VideoSinkInterface<std::shared_ptr<VideoFrame>> {
+ public:
+  LatencySink(V4L2VideoSource* source, int frames)
+      : source_(source), frames_(frames) {
+    deliver_us_.reserve(frames);
+    i420_us_.reserve(frames);
+  }
+
+  // called on the capture thread, right after the frame was dequeued
+  void OnFrame(const std::shared_ptr<VideoFrame>& frame) override {
+    const int64_t dequeued_us = source_->last_dequeue_time_us();
+    const int64_t deliver_us = Looper::getNowUs() - dequeued_us;
+    frame->video_frame_buffer()->ToI420();
+    const int64_t i420_us = Looper::getNowUs() - dequeued_us;
+
+    std::lock_guard<std::mutex> l(mutex_);
+    if (static_cast<int>(deliver_us_.size()) >= frames_) {
+      return;
+    }
+    deliver_us_.push_back(deliver_us);
+    i420_us_.push_back(i420_us);
+    if (static_cast<int>(deliver_us_.size()) == frames_) {
+      condition_.notify_all();
+    }
+  }
+
+  bool Wait(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> l(mutex_);
+    return condition_.wait_for(l, timeout, [this] {
+      return static_cast<int>(deliver_us_.size()) >= frames_;
+    });
+  }
+
+  LatencyStats deliver() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return Summarize(deliver_us_);
+  }
+
+  LatencyStats i420() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return Summarize(i420_us_);
+  }
+
+ private:
+  V4L2VideoSource* source_;
+  const int frames_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<int64_t> deliver_us_;
+  std::vector<int64_t> i420_us_;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ave::base::LogMessage::LogToDebug(LS_INFO);
+
+  if (argc < 2) {
+    AVE_LOG(LS_ERROR) << "usage: " << argv[0] << " /dev/videoX [frames]";
+    return -1;
+  }
+  const int frames = argc > 2 ? std::max(1, atoi(argv[2])) : kDefaultFrames;
+
+  auto video_info = std::make_shared<Message>();
+  video_info->setString("v4l2-dev", argv[1]);
+  auto source = V4L2VideoSource::Create(video_info);
+
+  for (auto pixel_format : source->supportedPixelFormats()) {
+    MetaData params;
+    params.setInt32(kKeyWidth, kWidth);
+    params.setInt32(kKeyHeight, kHeight);
+    params.setInt32(kKeyColorFormat, static_cast<int32_t>(pixel_format));
+    if (source->start(&params) != OK) {
+      AVE_LOG(LS_WARNING) << "pixel format "
+                          << static_cast<int32_t>(pixel_format)
+                          << " failed to start";
+      continue;
+    }
+
+    const uint64_t dropped = source->frame_dropped();
+    const uint64_t lost = source->frame_lost();
+    const auto pool = VideoFrameBufferPool::Default()->stats();
+    LatencySink sink(source.get(), frames);
+    source->AddOrUpdateSink(&sink, VideoSinkWants());
+    // a generous bound, even 5fps captures get through
+    const bool complete = sink.Wait(std::chrono::milliseconds(frames * 200));
+    source->RemoveSink(&sink);
+    source->stop();
+
+    const LatencyStats deliver = sink.deliver();
+    const LatencyStats i420 = sink.i420();
+    AVE_LOG(LS_INFO) << V4L2VideoSource::fourccToString(source->fourcc())
+                     << " " << source->width() << "x" << source->height()
+                     << (complete ? "" : " (timed out)")
+                     << "\n  dequeue->sink us min/avg/p99/max: "
+                     << deliver.min_us << "/" << deliver.avg_us << "/"
+                     << deliver.p99_us << "/" << deliver.max_us
+                     << "\n  dequeue->i420 us min/avg/p99/max: " << i420.min_us
+                     << "/" << i420.avg_us << "/" << i420.p99_us << "/"
+                     << i420.max_us
+                     << "\n  dropped: " << source->frame_dropped() - dropped
+                     << ", lost: " << source->frame_lost() - lost;
+
+    const auto pool_after = VideoFrameBufferPool::Default()->stats();
+    AVE_LOG(LS_INFO) << "  buffer pool hit/miss: "
+                     << pool_after.hits - pool.hits << "/"
+                     << pool_after.misses - pool.misses
+                     << ", outstanding: " << pool_after.outstanding
+                     << ", pooled: " << pool_after.pooled;
+  }
+
+  return 0;
+}
@@ -83,7 +83,10 @@ void MediaService::AddVideoSource(
     int32_t stream_id,
     CodecId codec_id,
     int32_t min_bitrate,
-    int32_t max_bitrate) {
+    int32_t max_bitrate,
+    int32_t target_bitrate,
+    int32_t max_framerate,
+    RateControlMode rate_control_mode) {
   // TODO(youfa) capturer lock
   // video_capturers_.push_back({std::make_unique<VideoCapturer>(nullptr), id});
 
@@ -94,6 +97,9 @@ void MediaService::AddVideoSource(
   msg->setInt32("codec_format", static_cast<int32_t>(codec_id));
   msg->setInt32("min_kbps", min_bitrate);
   msg->setInt32("max_kbps", max_bitrate);
+  msg->setInt32("target_kbps", target_bitrate);
+  msg->setInt32("max_fps", max_framerate);
+  msg->setInt32("rc_mode", static_cast<int32_t>(rate_control_mode));
   msg->post();
 }
 
@@ -192,6 +198,18 @@ void MediaService::onMessageReceived(const std::shared_ptr<Message>& message) {
       AVE_CHECK(message->findInt32("max_kbps", &max_bitrate));
       encoder_config.max_bitrate_kbps = max_bitrate;
 
+      int32_t target_bitrate;
+      AVE_CHECK(message->findInt32("target_kbps", &target_bitrate));
+      encoder_config.target_bitrate_kbps = target_bitrate;
+
+      int32_t max_framerate;
+      AVE_CHECK(message->findInt32("max_fps", &max_framerate));
+      encoder_config.max_framerate = max_framerate;
+
+      int32_t rc_mode;
+      AVE_CHECK(message->findInt32("rc_mode", &rc_mode));
+      encoder_config.rate_control_mode = static_cast<RateControlMode>(rc_mode);
+
       // add source to each media worker
       for (auto& worker : media_workers_) {
         auto config = encoder_config.Copy();
@@ -12,6 +12,7 @@
 
 #include "api/audio/audio_device.h"
 #include "api/audio/audio_sink_interface.h"
+#include "api/video_codecs/video_encoder_config.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "app/app_config.h"
 #include "base/constructor_magic.h"
@@ -44,7 +45,10 @@ class MediaService : public Handler {
       int32_t stream_id,
       CodecId codec_id,
       int32_t min_bitrate,
-      int32_t max_bitrate);
+      int32_t max_bitrate,
+      int32_t target_bitrate,
+      int32_t max_framerate,
+      RateControlMode rate_control_mode);
 
   void AddVideoSink(
       const std::shared_ptr<VideoSinkInterface<EncodedImage>>& video_sink,
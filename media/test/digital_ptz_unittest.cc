@@ -0,0 +1,107 @@
+/*
+ * digital_ptz_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "media/video/digital_ptz.h"
+#include "test/gtest.h"
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+namespace ave {
+namespace {
+
+constexpr size_t kWidth = 1280;
+constexpr size_t kHeight = 720;
+// 25 fps
+constexpr int64_t kFrameIntervalUs = 40 * 1000;
+
+// runs `frames` frames through `ptz`, returns the last crop
+std::optional<VideoFrame::Rect> RunFrames(DigitalPTZ* ptz,
+                                          int64_t* timestamp_us,
+                                          int frames) {
+  std::optional<VideoFrame::Rect> rect;
+  for (int i = 0; i < frames; i++) {
+    rect = ptz->Advance(*timestamp_us, kWidth, kHeight);
+    *timestamp_us += kFrameIntervalUs;
+  }
+  return rect;
+}
+
+}  // namespace
+
+TEST(DigitalPTZTest, WholeFrameWithoutZoom) {
+  DigitalPTZ ptz(DigitalPTZ::Config{});
+  int64_t timestamp_us = 0;
+  EXPECT_FALSE(RunFrames(&ptz, &timestamp_us, 3));
+
+  // panning a whole frame shows the whole frame
+  ptz.AbsoluteMove({1.0, 1.0, 0.0});
+  EXPECT_FALSE(RunFrames(&ptz, &timestamp_us, 100));
+}
+
+TEST(DigitalPTZTest, AbsoluteMoveEasesToTarget) {
+  DigitalPTZ ptz(DigitalPTZ::Config{});
+  int64_t timestamp_us = 0;
+  RunFrames(&ptz, &timestamp_us, 1);
+
+  ptz.AbsoluteMove({1.0, -1.0, 1.0});
+  auto rect = RunFrames(&ptz, &timestamp_us, 1);
+  ASSERT_TRUE(rect);
+  // on its way after one frame
+  EXPECT_TRUE(ptz.moving());
+  EXPECT_GT(ptz.position().zoom, 0.0);
+  EXPECT_LT(ptz.position().zoom, 1.0);
+
+  rect = RunFrames(&ptz, &timestamp_us, 100);
+  EXPECT_FALSE(ptz.moving());
+  // 4x zoom into the bottom right corner
+  ASSERT_TRUE(rect);
+  EXPECT_EQ(kWidth / 4, rect->width);
+  EXPECT_EQ(kHeight / 4, rect->height);
+  EXPECT_EQ(kWidth - kWidth / 4, rect->offset_x);
+  EXPECT_EQ(kHeight - kHeight / 4, rect->offset_y);
+}
+
+TEST(DigitalPTZTest, ContinuousMoveUntilStop) {
+  DigitalPTZ::Config config;
+  config.speed = 0.5;
+  DigitalPTZ ptz(config);
+  int64_t timestamp_us = 0;
+  RunFrames(&ptz, &timestamp_us, 1);
+
+  ptz.ContinuousMove(0, 0, 1.0);
+  // one second at half a unit per second
+  RunFrames(&ptz, &timestamp_us, 25);
+  EXPECT_NEAR(0.5, ptz.position().zoom, 0.05);
+
+  ptz.Stop();
+  const double zoom = ptz.position().zoom;
+  RunFrames(&ptz, &timestamp_us, 25);
+  EXPECT_EQ(zoom, ptz.position().zoom);
+  EXPECT_FALSE(ptz.moving());
+}
+
+TEST(DigitalPTZTest, Presets) {
+  DigitalPTZ::Config config;
+  config.max_presets = 2;
+  DigitalPTZ ptz(config);
+
+  ptz.AbsoluteMove({0.5, 0.5, 0.5});
+  EXPECT_EQ("1", ptz.SetPreset(""));
+  EXPECT_EQ("door", ptz.SetPreset("door"));
+  EXPECT_EQ("", ptz.SetPreset(""));
+  EXPECT_EQ(2u, ptz.presets().size());
+
+  ptz.AbsoluteMove({0, 0, 0});
+  EXPECT_TRUE(ptz.GotoPreset("door"));
+  int64_t timestamp_us = 0;
+  RunFrames(&ptz, &timestamp_us, 100);
+  EXPECT_EQ(0.5, ptz.position().pan);
+
+  EXPECT_TRUE(ptz.RemovePreset("door"));
+  EXPECT_FALSE(ptz.GotoPreset("door"));
+}
+
+}  // namespace ave
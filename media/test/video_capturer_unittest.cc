@@ -45,9 +45,10 @@ class TestVideoSource
     sink_ = nullptr;
   }
 
-  void ProduceOneFrame(size_t width, size_t height) {
-    auto frame = std::make_shared<VideoFrame>(
-        frame_sent_++, I420Buffer::Create(width, height), 0, std::nullopt);
+  void ProduceOneFrame(size_t width, size_t height, int64_t timestamp_us = 0) {
+    auto frame = std::make_shared<VideoFrame>(frame_sent_++,
+                                              I420Buffer::Create(width, height),
+                                              timestamp_us, std::nullopt);
 
     if (sink_) {
       sink_->OnFrame(frame);
@@ -73,6 +74,36 @@ class TestVideoSink : public VideoSinkInterface<std::shared_ptr<VideoFrame>> {
   uint64_t frame_received_;
 };
 
+class TestScaledVideoSink
+    : public VideoSinkInterface<std::shared_ptr<VideoFrame>> {
+ public:
+  void OnFrame(const std::shared_ptr<VideoFrame>& frame) override {
+    last_frame_ = frame;
+  }
+
+  std::shared_ptr<VideoFrame> last_frame_;
+};
+
+// stamps the encode stages like an encoder of its stream would
+class TestEncodingSink : public TestScaledVideoSink {
+ public:
+  TestEncodingSink(int64_t encode_start_us, int64_t encode_finish_us)
+      : encode_start_us_(encode_start_us),
+        encode_finish_us_(encode_finish_us) {}
+
+  void OnFrame(const std::shared_ptr<VideoFrame>& frame) override {
+    frame->metadata()->SetStageTime(FrameMetadata::Stage::kEncodeStart,
+                                    encode_start_us_);
+    frame->metadata()->SetStageTime(FrameMetadata::Stage::kEncodeFinish,
+                                    encode_finish_us_);
+    TestScaledVideoSink::OnFrame(frame);
+  }
+
+ private:
+  const int64_t encode_start_us_;
+  const int64_t encode_finish_us_;
+};
+
 class TestVideoProcessor
     : public VideoProcessorInterface<std::shared_ptr<VideoFrame>> {
  public:
@@ -165,6 +196,166 @@ TEST(VideoCapturerTest, VideoSinkTest) {
   EXPECT_EQ((uint64_t)2, sink2.frame_received());
 }
 
+TEST(VideoCapturerTest, MaxFramerateTest) {
+  constexpr int kCaptureFps = 30;
+  VideoCapturer capturer(nullptr);
+  TestVideoSource source;
+  TestVideoSink full_rate_sink;
+  TestVideoSink low_rate_sink;
+
+  capturer.SetVideoSource(&source, VideoSinkWants());
+  VideoSinkWants low_rate_wants;
+  low_rate_wants.max_framerate_fps = 10;
+  capturer.AddOrUpdateSink(&full_rate_sink, VideoSinkWants());
+  capturer.AddOrUpdateSink(&low_rate_sink, low_rate_wants);
+  std::this_thread::sleep_for(100ms);
+
+  // one second of 30fps capture
+  for (int i = 0; i < kCaptureFps; i++) {
+    source.ProduceOneFrame(kWidth, kHeight, i * 1000000 / kCaptureFps);
+  }
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ((uint64_t)kCaptureFps, capturer.frame_received());
+  EXPECT_EQ((uint64_t)kCaptureFps, capturer.frame_sent());
+  EXPECT_EQ((uint64_t)0, capturer.frame_dropped());
+  EXPECT_EQ((uint64_t)kCaptureFps, full_rate_sink.frame_received());
+  EXPECT_EQ((uint64_t)10, low_rate_sink.frame_received());
+
+  // only the low rate sink left, surplus frames are dropped up front
+  capturer.RemoveSink(&full_rate_sink);
+  std::this_thread::sleep_for(100ms);
+  for (int i = kCaptureFps; i < 2 * kCaptureFps; i++) {
+    source.ProduceOneFrame(kWidth, kHeight, i * 1000000 / kCaptureFps);
+  }
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ((uint64_t)2 * kCaptureFps, capturer.frame_received());
+  EXPECT_EQ((uint64_t)kCaptureFps + 10, capturer.frame_sent());
+  EXPECT_EQ((uint64_t)kCaptureFps - 10, capturer.frame_dropped());
+  EXPECT_EQ((uint64_t)20, low_rate_sink.frame_received());
+}
+
+TEST(VideoCapturerTest, MaxPixelCountTest) {
+  VideoCapturer capturer(nullptr);
+  TestVideoSource source;
+  TestScaledVideoSink full_size_sink;
+  TestScaledVideoSink small_sink1;
+  TestScaledVideoSink small_sink2;
+
+  capturer.SetVideoSource(&source, VideoSinkWants());
+  VideoSinkWants small_wants;
+  small_wants.max_pixel_count = kWidth * kHeight / 4;
+  small_wants.resolution_alignment = 2;
+  capturer.AddOrUpdateSink(&full_size_sink, VideoSinkWants());
+  capturer.AddOrUpdateSink(&small_sink1, small_wants);
+  capturer.AddOrUpdateSink(&small_sink2, small_wants);
+  std::this_thread::sleep_for(100ms);
+
+  source.ProduceOneFrame(kWidth, kHeight);
+  std::this_thread::sleep_for(100ms);
+  ASSERT_NE(nullptr, full_size_sink.last_frame_);
+  ASSERT_NE(nullptr, small_sink1.last_frame_);
+  EXPECT_EQ(kWidth, full_size_sink.last_frame_->width());
+  EXPECT_EQ(kHeight, full_size_sink.last_frame_->height());
+  EXPECT_EQ(kWidth / 2, small_sink1.last_frame_->width());
+  EXPECT_EQ(kHeight / 2, small_sink1.last_frame_->height());
+  // scaled once, shared by both sinks
+  EXPECT_EQ(small_sink1.last_frame_, small_sink2.last_frame_);
+}
+
+TEST(VideoCapturerTest, ScalePyramidTest) {
+  constexpr size_t kMainWidth = 1920;
+  constexpr size_t kMainHeight = 1080;
+  // main -> sub -> mobile, each tier scales from the one above it
+  VideoCapturer main_capturer(nullptr);
+  VideoCapturer sub_capturer(nullptr);
+  VideoCapturer mobile_capturer(nullptr);
+  TestVideoSource source;
+  TestScaledVideoSink main_sink;
+  TestScaledVideoSink sub_sink;
+  TestScaledVideoSink mobile_sink;
+
+  VideoSinkWants sub_wants;
+  sub_wants.max_pixel_count = 1280 * 720;
+  sub_wants.resolution_alignment = 2;
+  sub_wants.resolutions = {{1280, 720}};
+  VideoSinkWants mobile_wants;
+  mobile_wants.max_pixel_count = 640 * 360;
+  mobile_wants.resolution_alignment = 2;
+  mobile_wants.resolutions = {{640, 360}};
+
+  main_capturer.SetVideoSource(&source, VideoSinkWants());
+  sub_capturer.SetVideoSource(&main_capturer, sub_wants);
+  mobile_capturer.SetVideoSource(&sub_capturer, mobile_wants);
+  main_capturer.AddOrUpdateSink(&main_sink, VideoSinkWants());
+  sub_capturer.AddOrUpdateSink(&sub_sink, VideoSinkWants());
+  mobile_capturer.AddOrUpdateSink(&mobile_sink, VideoSinkWants());
+  std::this_thread::sleep_for(100ms);
+
+  source.ProduceOneFrame(kMainWidth, kMainHeight);
+  std::this_thread::sleep_for(200ms);
+  ASSERT_NE(nullptr, main_sink.last_frame_);
+  ASSERT_NE(nullptr, sub_sink.last_frame_);
+  ASSERT_NE(nullptr, mobile_sink.last_frame_);
+  EXPECT_EQ(kMainWidth, main_sink.last_frame_->width());
+  EXPECT_EQ(kMainHeight, main_sink.last_frame_->height());
+  EXPECT_EQ((size_t)1280, sub_sink.last_frame_->width());
+  EXPECT_EQ((size_t)720, sub_sink.last_frame_->height());
+  EXPECT_EQ((size_t)640, mobile_sink.last_frame_->width());
+  EXPECT_EQ((size_t)360, mobile_sink.last_frame_->height());
+  EXPECT_EQ((uint64_t)1, mobile_capturer.frame_received());
+}
+
+TEST(VideoCapturerTest, SubstreamsStampOwnStagesTest) {
+  VideoCapturer main_capturer(nullptr);
+  VideoCapturer sub_capturer(nullptr);
+  VideoCapturer mobile_capturer(nullptr);
+  TestVideoSource source;
+  TestEncodingSink main_sink(100, 110);
+  TestEncodingSink sub_sink(200, 220);
+  TestEncodingSink mobile_sink(300, 330);
+
+  VideoSinkWants sub_wants;
+  sub_wants.max_pixel_count = 1280 * 720;
+  sub_wants.resolutions = {{1280, 720}};
+  VideoSinkWants mobile_wants;
+  mobile_wants.max_pixel_count = 640 * 360;
+  mobile_wants.resolutions = {{640, 360}};
+
+  main_capturer.SetVideoSource(&source, VideoSinkWants());
+  sub_capturer.SetVideoSource(&main_capturer, sub_wants);
+  mobile_capturer.SetVideoSource(&sub_capturer, mobile_wants);
+  main_capturer.AddOrUpdateSink(&main_sink, VideoSinkWants());
+  sub_capturer.AddOrUpdateSink(&sub_sink, VideoSinkWants());
+  mobile_capturer.AddOrUpdateSink(&mobile_sink, VideoSinkWants());
+  std::this_thread::sleep_for(100ms);
+
+  auto frame = std::make_shared<VideoFrame>(0, I420Buffer::Create(1920, 1080),
+                                            0, std::nullopt);
+  frame->metadata()->SetStageTime(FrameMetadata::Stage::kCapture, 10);
+  frame->metadata()->SetSourceSequence(5);
+  source.sink_->OnFrame(frame);
+  std::this_thread::sleep_for(200ms);
+  ASSERT_NE(nullptr, main_sink.last_frame_);
+  ASSERT_NE(nullptr, sub_sink.last_frame_);
+  ASSERT_NE(nullptr, mobile_sink.last_frame_);
+
+  const TestEncodingSink* sinks[] = {&main_sink, &sub_sink, &mobile_sink};
+  const int64_t encode_start_us[] = {100, 200, 300};
+  const int64_t encode_finish_us[] = {110, 220, 330};
+  for (size_t i = 0; i < 3; i++) {
+    const auto& metadata = sinks[i]->last_frame_->metadata();
+    // the capture side is shared, the encode stages are the stream's own
+    EXPECT_EQ(10, *metadata->StageTime(FrameMetadata::Stage::kCapture));
+    EXPECT_EQ(5, *metadata->SourceSequence());
+    EXPECT_TRUE(metadata->StageTime(FrameMetadata::Stage::kDeliver));
+    EXPECT_EQ(encode_start_us[i],
+              *metadata->StageTime(FrameMetadata::Stage::kEncodeStart));
+    EXPECT_EQ(encode_finish_us[i] - encode_start_us[i],
+              *metadata->StageDelta(FrameMetadata::Stage::kEncodeStart,
+                                    FrameMetadata::Stage::kEncodeFinish));
+  }
+}
+
 TEST(VideoCapturerTest, VideoProcessorTest) {
   TestVideoSink sink;
   TestVideoProcessor processor;
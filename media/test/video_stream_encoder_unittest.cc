@@ -0,0 +1,237 @@
+/*
+ * video_stream_encoder_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "api/video_codecs/video_encoder.h"
+#include "api/video_codecs/video_encoder_factory.h"
+#include "base/task_util/default_task_runner_factory.h"
+#include "media/video/video_stream_encoder.h"
+#include "test/gtest.h"
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+namespace ave {
+using namespace std::chrono_literals;
+namespace {
+
+constexpr size_t kWidth = 320;
+constexpr size_t kHeight = 240;
+
+// Encode() blocks while the gate is closed, so frames pile up behind it
+struct EncoderGate {
+  void Close() {
+    std::lock_guard<std::mutex> l(mutex);
+    open = false;
+  }
+
+  void Open() {
+    std::lock_guard<std::mutex> l(mutex);
+    open = true;
+    cond.notify_all();
+  }
+
+  // waits until Encode() was entered for `count` frames
+  bool WaitForEncodes(size_t count) {
+    std::unique_lock<std::mutex> l(mutex);
+    return cond.wait_for(l, 1s, [&] { return encoded_ids.size() >= count; });
+  }
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool open = true;
+  std::vector<uint64_t> encoded_ids;
+};
+
+class FakeEncoder : public VideoEncoder {
+ public:
+  explicit FakeEncoder(EncoderGate* gate) : gate_(gate) {}
+  ~FakeEncoder() override = default;
+
+  status_t InitEncoder(const VideoCodecProperty& codec_settings,
+                       const Settings& settings) override {
+    return OK;
+  }
+
+  status_t RegisterEncoderCompleteCallback(
+      EncodedImageCallback* callback) override {
+    return OK;
+  }
+
+  status_t Release() override { return OK; }
+
+  status_t Encode(const std::shared_ptr<VideoFrame>& frame) override {
+    std::unique_lock<std::mutex> l(gate_->mutex);
+    gate_->encoded_ids.push_back(frame->id());
+    gate_->cond.notify_all();
+    gate_->cond.wait(l, [this] { return gate_->open; });
+    return OK;
+  }
+
+  void RequestKeyFrame() override {}
+
+ private:
+  EncoderGate* gate_;
+};
+
+class FakeEncoderFactory : public VideoEncoderFactory {
+ public:
+  explicit FakeEncoderFactory(EncoderGate* gate) : gate_(gate) {}
+
+  std::unique_ptr<VideoEncoder> CreateVideoEncoder() override {
+    return std::make_unique<FakeEncoder>(gate_);
+  }
+
+ private:
+  EncoderGate* gate_;
+};
+
+class DropCountingSink : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& frame) override {
+    return Result(Result::ENCODED_OK);
+  }
+
+  void OnDroppedFrame(DropReason reason) override {
+    std::lock_guard<std::mutex> l(mutex_);
+    dropped_++;
+  }
+
+  size_t dropped() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return dropped_;
+  }
+
+ private:
+  std::mutex mutex_;
+  size_t dropped_ = 0;
+};
+
+// a VideoStreamEncoder on a fake encoder which blocks while the gate is closed
+class StreamEncoderHarness {
+ public:
+  explicit StreamEncoderHarness(size_t max_queue_depth)
+      : task_runner_factory_(base::CreateDefaultTaskRunnerFactory()),
+        encoder_factory_(&gate_),
+        next_frame_id_(0) {
+    stream_encoder_ = std::make_unique<VideoStreamEncoder>(
+        task_runner_factory_.get(), &encoder_factory_, &sink_,
+        max_queue_depth);
+    VideoEncoderConfig config;
+    config.codec_id = CodecId::AV_CODEC_ID_H264;
+    config.min_bitrate_kbps = 300;
+    config.max_bitrate_kbps = 2000;
+    config.max_framerate = 30;
+    stream_encoder_->ConfigureEncoder(std::move(config), 1200);
+  }
+
+  ~StreamEncoderHarness() {
+    gate_.Open();
+    stream_encoder_.reset();
+  }
+
+  void SendFrame() {
+    stream_encoder_->OnFrame(std::make_shared<VideoFrame>(
+        next_frame_id_++, I420Buffer::Create(kWidth, kHeight), 0,
+        std::nullopt));
+  }
+
+  // the stats are updated after Encode() returned
+  bool WaitForStatsEncoded(uint64_t count) {
+    for (int i = 0; i < 1000; i++) {
+      if (stats().frames_encoded >= count) {
+        return true;
+      }
+      std::this_thread::sleep_for(1ms);
+    }
+    return false;
+  }
+
+  VideoStreamEncoderInterface::Stats stats() const {
+    return stream_encoder_->GetStats();
+  }
+
+  EncoderGate& gate() { return gate_; }
+  DropCountingSink& sink() { return sink_; }
+
+ private:
+  EncoderGate gate_;
+  std::unique_ptr<base::TaskRunnerFactory> task_runner_factory_;
+  FakeEncoderFactory encoder_factory_;
+  DropCountingSink sink_;
+  std::unique_ptr<VideoStreamEncoder> stream_encoder_;
+  uint64_t next_frame_id_;
+};
+
+}  // namespace
+
+TEST(VideoStreamEncoderTest, DropsOldestFramesBeyondQueueDepth) {
+  StreamEncoderHarness harness(1);
+  harness.gate().Close();
+
+  harness.SendFrame();
+  ASSERT_TRUE(harness.gate().WaitForEncodes(1));
+  // frame 0 is in the encoder, 1 and 2 are replaced by 3
+  harness.SendFrame();
+  harness.SendFrame();
+  harness.SendFrame();
+
+  VideoStreamEncoderInterface::Stats stats = harness.stats();
+  EXPECT_EQ(stats.frames_received, 4u);
+  EXPECT_EQ(stats.frames_dropped, 2u);
+  EXPECT_EQ(stats.queue_depth, 1u);
+  EXPECT_EQ(stats.max_queue_depth, 1u);
+
+  harness.gate().Open();
+  ASSERT_TRUE(harness.gate().WaitForEncodes(2));
+  ASSERT_TRUE(harness.WaitForStatsEncoded(2));
+
+  EXPECT_EQ(harness.gate().encoded_ids, (std::vector<uint64_t>{0, 3}));
+  EXPECT_EQ(harness.sink().dropped(), 2u);
+  stats = harness.stats();
+  EXPECT_EQ(stats.frames_encoded, 2u);
+  EXPECT_EQ(stats.frames_dropped, 2u);
+  EXPECT_EQ(stats.queue_depth, 0u);
+}
+
+TEST(VideoStreamEncoderTest, EncodesNewestFrameWithinQueueDepth) {
+  StreamEncoderHarness harness(3);
+  harness.gate().Close();
+
+  harness.SendFrame();
+  ASSERT_TRUE(harness.gate().WaitForEncodes(1));
+  harness.SendFrame();
+  harness.SendFrame();
+  harness.SendFrame();
+
+  // frames within the depth are held, none dropped yet
+  VideoStreamEncoderInterface::Stats stats = harness.stats();
+  EXPECT_EQ(stats.frames_dropped, 0u);
+  EXPECT_EQ(stats.queue_depth, 3u);
+  EXPECT_EQ(stats.max_queue_depth, 3u);
+
+  // once free the encoder takes frame 3, 1 and 2 are stale
+  harness.gate().Open();
+  ASSERT_TRUE(harness.gate().WaitForEncodes(2));
+  ASSERT_TRUE(harness.WaitForStatsEncoded(2));
+
+  EXPECT_EQ(harness.gate().encoded_ids, (std::vector<uint64_t>{0, 3}));
+  EXPECT_EQ(harness.sink().dropped(), 2u);
+  stats = harness.stats();
+  EXPECT_EQ(stats.frames_encoded, 2u);
+  EXPECT_EQ(stats.frames_dropped, 2u);
+  EXPECT_EQ(stats.queue_depth, 0u);
+}
+
+}  // namespace ave
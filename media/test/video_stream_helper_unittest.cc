@@ -0,0 +1,62 @@
+/*
+ * video_stream_helper_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "media/video/video_stream_helper.h"
+#include "test/gtest.h"
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+namespace ave {
+namespace {
+
+VideoEncoderConfig CreateEncoderConfig(int min_kbps,
+                                       int max_kbps,
+                                       int target_kbps,
+                                       int max_framerate) {
+  VideoEncoderConfig config;
+  config.codec_id = CodecId::AV_CODEC_ID_H264;
+  config.min_bitrate_kbps = min_kbps;
+  config.max_bitrate_kbps = max_kbps;
+  config.target_bitrate_kbps = target_kbps;
+  config.max_framerate = max_framerate;
+  return config;
+}
+
+VideoCodecProperty SetupCodecProperty(const VideoEncoderConfig& config) {
+  VideoCodecProperty property;
+  EXPECT_TRUE(SetupVideoCodecProperity(
+      config, CreateVideoStreamConfig(1920, 1080, config), &property));
+  return property;
+}
+
+}  // namespace
+
+TEST(VideoStreamHelperTest, TargetAndFramerateReachTheCodec) {
+  VideoCodecProperty property =
+      SetupCodecProperty(CreateEncoderConfig(300, 10000, 4000, 25));
+  EXPECT_EQ(property.bit_rate, 4000u);
+  EXPECT_EQ(property.bit_rate_range.min, 300u);
+  EXPECT_EQ(property.bit_rate_range.max, 10000u);
+  EXPECT_EQ(property.frame_rate, 25u);
+}
+
+TEST(VideoStreamHelperTest, UnsetTargetRunsAtMax) {
+  VideoCodecProperty property =
+      SetupCodecProperty(CreateEncoderConfig(300, 2000, 0, 0));
+  EXPECT_EQ(property.bit_rate, 2000u);
+  EXPECT_EQ(property.frame_rate, 60u);
+}
+
+TEST(VideoStreamHelperTest, TargetIsClampedToRange) {
+  EXPECT_EQ(SetupCodecProperty(CreateEncoderConfig(300, 2000, 5000, 30))
+                .bit_rate,
+            2000u);
+  EXPECT_EQ(
+      SetupCodecProperty(CreateEncoderConfig(300, 2000, 100, 30)).bit_rate,
+      300u);
+}
+
+}  // namespace ave
@@ -0,0 +1,182 @@
+/*
+ * digital_ptz.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "digital_ptz.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "base/checks.h"
+#include "base/logging.h"
+
+namespace ave {
+
+namespace {
+// a frame gap beyond this is a stall, the window does not jump across it
+constexpr int64_t kMaxStepUs = 200 * 1000;
+// the ease ends once the window is this close to its target
+constexpr double kArrived = 1e-3;
+
+DigitalPTZ::Position Clamp(const DigitalPTZ::Position& position) {
+  return {std::clamp(position.pan, -1.0, 1.0),
+          std::clamp(position.tilt, -1.0, 1.0),
+          std::clamp(position.zoom, 0.0, 1.0)};
+}
+
+size_t EvenFloor(double value) {
+  return static_cast<size_t>(std::max(value, 0.0)) & ~static_cast<size_t>(1);
+}
+
+}  // namespace
+
+DigitalPTZ::DigitalPTZ(Config config) : config_(config) {
+  AVE_DCHECK_GE(config_.max_zoom, 1.0);
+}
+
+DigitalPTZ::~DigitalPTZ() = default;
+
+void DigitalPTZ::ContinuousMove(double pan_velocity,
+                                double tilt_velocity,
+                                double zoom_velocity) {
+  lock_guard l(&lock_);
+  target_.reset();
+  velocity_ = {std::clamp(pan_velocity, -1.0, 1.0),
+               std::clamp(tilt_velocity, -1.0, 1.0),
+               std::clamp(zoom_velocity, -1.0, 1.0)};
+}
+
+void DigitalPTZ::AbsoluteMove(const Position& position) {
+  lock_guard l(&lock_);
+  SetTargetLocked(position);
+}
+
+void DigitalPTZ::RelativeMove(const Position& translation) {
+  lock_guard l(&lock_);
+  const Position from = target_.value_or(position_);
+  SetTargetLocked({from.pan + translation.pan, from.tilt + translation.tilt,
+                   from.zoom + translation.zoom});
+}
+
+void DigitalPTZ::Stop() {
+  lock_guard l(&lock_);
+  target_.reset();
+  velocity_ = Position();
+}
+
+std::string DigitalPTZ::SetPreset(const std::string& token) {
+  lock_guard l(&lock_);
+  std::string preset_token = token;
+  if (preset_token.empty()) {
+    for (size_t i = 1; preset_token.empty(); i++) {
+      if (presets_.count(std::to_string(i)) == 0) {
+        preset_token = std::to_string(i);
+      }
+    }
+  }
+  if (presets_.count(preset_token) == 0 &&
+      presets_.size() >= config_.max_presets) {
+    AVE_LOG(LS_WARNING) << "all " << config_.max_presets
+                        << " ptz presets taken";
+    return std::string();
+  }
+  presets_[preset_token] = target_.value_or(position_);
+  return preset_token;
+}
+
+bool DigitalPTZ::RemovePreset(const std::string& token) {
+  lock_guard l(&lock_);
+  return presets_.erase(token) > 0;
+}
+
+bool DigitalPTZ::GotoPreset(const std::string& token) {
+  lock_guard l(&lock_);
+  auto it = presets_.find(token);
+  if (it == presets_.end()) {
+    return false;
+  }
+  SetTargetLocked(it->second);
+  return true;
+}
+
+std::vector<std::pair<std::string, DigitalPTZ::Position>> DigitalPTZ::presets()
+    const {
+  lock_guard l(&lock_);
+  return {presets_.begin(), presets_.end()};
+}
+
+void DigitalPTZ::SetHomePosition() {
+  lock_guard l(&lock_);
+  home_ = target_.value_or(position_);
+}
+
+void DigitalPTZ::GotoHomePosition() {
+  lock_guard l(&lock_);
+  SetTargetLocked(home_);
+}
+
+DigitalPTZ::Position DigitalPTZ::position() const {
+  lock_guard l(&lock_);
+  return position_;
+}
+
+bool DigitalPTZ::moving() const {
+  lock_guard l(&lock_);
+  return target_ || velocity_.pan != 0 || velocity_.tilt != 0 ||
+         velocity_.zoom != 0;
+}
+
+std::optional<VideoFrame::Rect> DigitalPTZ::Advance(int64_t timestamp_us,
+                                                    size_t width,
+                                                    size_t height) {
+  lock_guard l(&lock_);
+  int64_t step_us = 0;
+  if (last_timestamp_us_) {
+    step_us = std::clamp<int64_t>(timestamp_us - *last_timestamp_us_, 0,
+                                  kMaxStepUs);
+  }
+  last_timestamp_us_ = timestamp_us;
+
+  if (target_) {
+    const double ease =
+        1.0 - std::exp(-static_cast<double>(step_us) / config_.ease_us);
+    position_.pan += (target_->pan - position_.pan) * ease;
+    position_.tilt += (target_->tilt - position_.tilt) * ease;
+    position_.zoom += (target_->zoom - position_.zoom) * ease;
+    if (std::abs(target_->pan - position_.pan) < kArrived &&
+        std::abs(target_->tilt - position_.tilt) < kArrived &&
+        std::abs(target_->zoom - position_.zoom) < kArrived) {
+      position_ = *target_;
+      target_.reset();
+    }
+  } else {
+    const double step = config_.speed * step_us / 1e6;
+    position_ = Clamp({position_.pan + velocity_.pan * step,
+                       position_.tilt + velocity_.tilt * step,
+                       position_.zoom + velocity_.zoom * step});
+  }
+
+  // pan and tilt only move a window smaller than the frame
+  const double magnification = 1.0 + position_.zoom * (config_.max_zoom - 1.0);
+  if (magnification <= 1.0) {
+    return std::nullopt;
+  }
+  const size_t crop_width =
+      std::max<size_t>(EvenFloor(width / magnification), 2);
+  const size_t crop_height =
+      std::max<size_t>(EvenFloor(height / magnification), 2);
+  return VideoFrame::Rect{
+      EvenFloor((width - crop_width) * (1.0 + position_.pan) / 2),
+      EvenFloor((height - crop_height) * (1.0 - position_.tilt) / 2),
+      crop_width, crop_height};
+}
+
+void DigitalPTZ::SetTargetLocked(const Position& position) {
+  velocity_ = Position();
+  target_ = Clamp(position);
+}
+
+}  // namespace ave
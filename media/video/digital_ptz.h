@@ -0,0 +1,100 @@
+/*
+ * digital_ptz.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef DIGITAL_PTZ_H
+#define DIGITAL_PTZ_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "api/video/video_frame.h"
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
+
+namespace ave {
+
+// Digital pan, tilt and zoom for fixed lens cameras. Moves steer a crop
+// window over the captured frame, the capturer asks for the window of every
+// frame and scales it back to the frame size, so the output resolution never
+// changes. The window follows absolute moves and presets with an exponential
+// ease and continuous moves at a constant speed, so it glides instead of
+// jumping.
+// Positions use the onvif generic spaces: pan and tilt in [-1, 1] with
+// positive tilt up, zoom in [0, 1] from the whole frame to max_zoom.
+// Thread safe, moves come from the onvif thread while frames are cropped on
+// the capture thread.
+class DigitalPTZ {
+ public:
+  struct Position {
+    double pan = 0;
+    double tilt = 0;
+    double zoom = 0;
+  };
+
+  struct Config {
+    // magnification at zoom 1
+    double max_zoom = 4.0;
+    // position units per second at velocity 1
+    double speed = 0.5;
+    // time constant of the ease towards an absolute target
+    int64_t ease_us = 250 * 1000;
+    // onvif node MaximumNumberOfPresets
+    size_t max_presets = 8;
+  };
+
+  explicit DigitalPTZ(Config config);
+  ~DigitalPTZ();
+
+  // move with velocities in [-1, 1] until Stop()
+  void ContinuousMove(double pan_velocity,
+                      double tilt_velocity,
+                      double zoom_velocity);
+  void AbsoluteMove(const Position& position);
+  void RelativeMove(const Position& translation);
+  void Stop();
+
+  // stores the current target as `token`, or as a new numeric token if
+  // `token` is empty. Returns the token, empty if all presets are taken.
+  std::string SetPreset(const std::string& token);
+  bool RemovePreset(const std::string& token);
+  bool GotoPreset(const std::string& token);
+  std::vector<std::pair<std::string, Position>> presets() const;
+
+  void SetHomePosition();
+  void GotoHomePosition();
+
+  // where the window is, and whether it is still on its way
+  Position position() const;
+  bool moving() const;
+
+  // Moves the window on to `timestamp_us` and returns its crop of a
+  // width x height frame, nullopt while it shows the whole frame.
+  std::optional<VideoFrame::Rect> Advance(int64_t timestamp_us,
+                                          size_t width,
+                                          size_t height);
+
+ private:
+  void SetTargetLocked(const Position& position) REQUIRES(lock_);
+
+  const Config config_;
+
+  mutable Mutex lock_;
+  Position position_ GUARDED_BY(lock_);
+  // absolute target, unset during a continuous move
+  std::optional<Position> target_ GUARDED_BY(lock_);
+  Position velocity_ GUARDED_BY(lock_);
+  Position home_ GUARDED_BY(lock_);
+  std::map<std::string, Position> presets_ GUARDED_BY(lock_);
+  std::optional<int64_t> last_timestamp_us_ GUARDED_BY(lock_);
+};
+
+}  // namespace ave
+
+#endif /* !DIGITAL_PTZ_H */
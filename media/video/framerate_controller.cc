@@ -0,0 +1,69 @@
+/*
+ * framerate_controller.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "framerate_controller.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace ave {
+
+namespace {
+constexpr int64_t kUsPerSec = 1000000;
+// frames this much early still pass, so capture jitter doesn't drop extra
+// ones, kept well below any capture interval so no extra frame passes either
+constexpr int64_t kMaxJitterToleranceUs = 5000;
+}  // namespace
+
+FramerateController::FramerateController(int max_framerate_fps)
+    : max_framerate_fps_(max_framerate_fps) {}
+
+FramerateController::~FramerateController() = default;
+
+void FramerateController::SetMaxFramerate(int max_framerate_fps) {
+  if (max_framerate_fps_ != max_framerate_fps) {
+    max_framerate_fps_ = max_framerate_fps;
+    Reset();
+  }
+}
+
+bool FramerateController::ShouldDropFrame(int64_t timestamp_us) {
+  if (max_framerate_fps_ == std::numeric_limits<int>::max()) {
+    return false;
+  }
+  if (max_framerate_fps_ <= 0) {
+    return true;
+  }
+
+  const int64_t frame_interval_us = kUsPerSec / max_framerate_fps_;
+  if (next_frame_timestamp_us_) {
+    const int64_t time_until_next_frame_us =
+        *next_frame_timestamp_us_ - timestamp_us;
+    // on schedule, otherwise the source paused or jumped, so start over
+    if (std::abs(time_until_next_frame_us) < 2 * frame_interval_us) {
+      const int64_t jitter_tolerance_us =
+          std::min(kMaxJitterToleranceUs, frame_interval_us / 4);
+      if (time_until_next_frame_us > jitter_tolerance_us) {
+        return true;
+      }
+      *next_frame_timestamp_us_ += frame_interval_us;
+      return false;
+    }
+  }
+
+  // a full interval after the first frame, so the first second doesn't get
+  // one frame too many
+  next_frame_timestamp_us_ = timestamp_us + frame_interval_us;
+  return false;
+}
+
+void FramerateController::Reset() {
+  next_frame_timestamp_us_.reset();
+}
+
+}  // namespace ave
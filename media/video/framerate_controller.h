@@ -0,0 +1,39 @@
+/*
+ * framerate_controller.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef FRAMERATE_CONTROLLER_H
+#define FRAMERATE_CONTROLLER_H
+
+#include <cstdint>
+#include <optional>
+
+namespace ave {
+
+// Decimates a frame sequence down to a maximum framerate using the frame
+// timestamps, e.g. keeps every third frame of a 30fps capture for 10fps.
+class FramerateController {
+ public:
+  // std::numeric_limits<int>::max() keeps every frame, zero drops every one.
+  explicit FramerateController(int max_framerate_fps);
+  ~FramerateController();
+
+  void SetMaxFramerate(int max_framerate_fps);
+  int max_framerate() const { return max_framerate_fps_; }
+
+  // Returns true if the frame captured at `timestamp_us` should be dropped.
+  bool ShouldDropFrame(int64_t timestamp_us);
+
+  void Reset();
+
+ private:
+  int max_framerate_fps_;
+  std::optional<int64_t> next_frame_timestamp_us_;
+};
+
+}  // namespace ave
+
+#endif /* !FRAMERATE_CONTROLLER_H */
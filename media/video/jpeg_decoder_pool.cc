@@ -0,0 +1,57 @@
+/*
+ * jpeg_decoder_pool.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "jpeg_decoder_pool.h"
+
+#include <algorithm>
+
+#include "api/video_codecs/video_encoder.h"
+#include "base/logging.h"
+#include "base/task_util/default_task_runner_factory.h"
+
+namespace ave {
+
+namespace {
+// 1080p30 mjpeg needs about two cores, keep one for capture and encode.
+constexpr size_t kMaxDecodeWorkers = 3;
+}  // namespace
+
+JpegDecoderPool::JpegDecoderPool(size_t num_workers)
+    : task_runner_factory_(base::CreateDefaultTaskRunnerFactory()),
+      next_worker_(0) {
+  if (num_workers == 0) {
+    // the cores this process may actually use, not those of the machine
+    const size_t cpus = VideoEncoder::DetectNumberOfCores();
+    num_workers = std::clamp<size_t>(cpus > 1 ? cpus - 1 : 1, 1,
+                                     kMaxDecodeWorkers);
+  }
+
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_.push_back(std::make_unique<base::TaskRunner>(
+        task_runner_factory_->CreateTaskRunner(
+            "jpeg_decoder",
+            base::TaskRunnerFactory::Priority::NORMAL)));
+  }
+  AVE_LOG(LS_INFO) << "jpeg decoder pool with " << num_workers << " workers";
+}
+
+JpegDecoderPool::~JpegDecoderPool() {
+  // the task runners join their threads before the factory goes away
+  workers_.clear();
+}
+
+void JpegDecoderPool::Decode(const std::shared_ptr<MJPEGBuffer>& buffer) {
+  std::weak_ptr<MJPEGBuffer> weak_buffer = buffer;
+  const size_t worker = next_worker_++ % workers_.size();
+  workers_[worker]->PostTask([weak_buffer]() {
+    if (auto buffer = weak_buffer.lock()) {
+      buffer->Decode();
+    }
+  });
+}
+
+}  // namespace ave
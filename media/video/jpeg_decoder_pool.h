@@ -0,0 +1,44 @@
+/*
+ * jpeg_decoder_pool.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef JPEG_DECODER_POOL_H
+#define JPEG_DECODER_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api/video/mjpeg_buffer.h"
+#include "base/task_util/task_runner.h"
+#include "base/task_util/task_runner_factory.h"
+
+namespace ave {
+
+// Decodes mjpeg frames ahead of their consumers on a few worker threads, so
+// consecutive frames decode in parallel instead of one after another on the
+// encoder thread.
+class JpegDecoderPool {
+ public:
+  // `num_workers` of 0 picks a worker count from the online cpus.
+  explicit JpegDecoderPool(size_t num_workers = 0);
+  ~JpegDecoderPool();
+
+  // Starts decoding `buffer` on the next worker. Frames already released by
+  // every consumer when their turn comes are skipped.
+  void Decode(const std::shared_ptr<MJPEGBuffer>& buffer);
+
+  size_t num_workers() const { return workers_.size(); }
+
+ private:
+  std::unique_ptr<base::TaskRunnerFactory> task_runner_factory_;
+  std::vector<std::unique_ptr<base::TaskRunner>> workers_;
+  std::atomic<size_t> next_worker_;
+};
+
+}  // namespace ave
+
+#endif /* !JPEG_DECODER_POOL_H */
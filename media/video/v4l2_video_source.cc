@@ -8,21 +8,33 @@
 
 #include <fcntl.h>
 #include <linux/videodev2.h>
-#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <thread>
+#include <utility>
 
-#include "api/video/i420_buffer.h"
-#include "api/video/nv12_buffer.h"
+#include "api/video/dmabuf_frame_buffer.h"
+#if defined(OC_MJPEG)
+#include "api/video/mjpeg_buffer.h"
+#endif
 #include "api/video/video_frame_buffer.h"
-#include "api/video/yuyv_buffer.h"
+#include "api/video/wrapped_frame_buffer.h"
 #include "base/checks.h"
 #include "base/errors.h"
 #include "base/logging.h"
-#include "base/task_util/default_task_runner_factory.h"
+#include "base/mutex.h"
+#include "base/thread_annotation.h"
+#include "base/thread_defs.h"
 #include "base/types.h"
 #include "common/buffer.h"
 #include "common/codec_constants.h"
@@ -33,15 +45,29 @@
 namespace ave {
 namespace {
 
-// Desired number of v4l2 video buffers to allocate.
-constexpr uint32_t kNumVideoBuffers = 4;
+// Default number of v4l2 video buffers to allocate, frames held downstream
+// zero-copy keep their buffer, so slow consumers may need more.
+constexpr uint32_t kDefaultVideoBuffers = 4;
+
+// Buffers always left queued in the driver, frames are dropped rather than
+// lending out the last one, otherwise the driver has nothing to capture into.
+constexpr size_t kMinQueuedBuffers = 1;
+
+// How long a start waits for the frames of the last stream to give their
+// buffers back, the driver can't allocate new ones while they are mapped.
+constexpr int kRetiredBuffersWaitMs = 1000;
+constexpr int kRetiredBuffersPollMs = 5;
 
 // Timeout in milliseconds v4l2_thread_ blocks waiting for a frame from the hw.
 // This value has been fine tuned. Before changing or modifying it see
 constexpr int kCaptureTimeoutMs = 1000;
 
+// The capture timeout is at least this many frame intervals, so low frame
+// rates don't time out between two regular frames.
+constexpr int kCaptureTimeoutFrames = 3;
+
 // The number of continuous timeouts tolerated before treated as error.
-// constexpr int kContinuousTimeoutLimit = 10;
+constexpr int kContinuousTimeoutLimit = 10;
 
 // Some drivers use rational time per frame instead of float frame rate, this
 // constant k is used to convert between both: A fps -> [k/k*A] seconds/frame.
@@ -50,20 +76,39 @@ const int kFrameRatePrecision = 10000;
 // Typical framerate, in fps
 constexpr int kTypicalFramerate = 25;
 
-// This list is ordered by precedence of use if no perfer color format
+// Driver timestamps further than this from now are treated as bogus.
+constexpr int64_t kMaxCaptureDelayUs = 1000 * 1000;
+
+// This list is ordered by precedence of use if no perfer color format, the
+// formats cheapest to get to the encoder first
 struct {
   uint32_t fourcc;
   VideoFrameBuffer::PixelFormat pixel_format;
   size_t num_planes;
 } constexpr kSupportedFormatsAndPlanarity[] = {
     {V4L2_PIX_FMT_YUV420, VideoFrameBuffer::PixelFormat::kI420, 1},
+    {V4L2_PIX_FMT_YUV420M, VideoFrameBuffer::PixelFormat::kI420, 3},
     {V4L2_PIX_FMT_NV12, VideoFrameBuffer::PixelFormat::kNV12, 1},
+    {V4L2_PIX_FMT_NV12M, VideoFrameBuffer::PixelFormat::kNV12, 2},
+    {V4L2_PIX_FMT_NV21, VideoFrameBuffer::PixelFormat::kNV21, 1},
+    {V4L2_PIX_FMT_NV21M, VideoFrameBuffer::PixelFormat::kNV21, 2},
     {V4L2_PIX_FMT_YUYV, VideoFrameBuffer::PixelFormat::kYUY2, 1},
+    {V4L2_PIX_FMT_UYVY, VideoFrameBuffer::PixelFormat::kUYVY, 1},
+    {V4L2_PIX_FMT_ABGR32, VideoFrameBuffer::PixelFormat::kBGRA, 1},
+    {V4L2_PIX_FMT_XBGR32, VideoFrameBuffer::PixelFormat::kBGRA, 1},
+    {V4L2_PIX_FMT_BGR32, VideoFrameBuffer::PixelFormat::kBGRA, 1},
     {V4L2_PIX_FMT_RGB24, VideoFrameBuffer::PixelFormat::kRGB24, 1},
-    // error format
-    {V4L2_PIX_FMT_Y16, VideoFrameBuffer::PixelFormat::kMJPEG, 1},
+#if defined(OC_MJPEG)
+    {V4L2_PIX_FMT_MJPEG, VideoFrameBuffer::PixelFormat::kMJPEG, 1},
+#endif
 };
 
+int64_t MonotonicNowUs() {
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 static void V4L2MakeFourCCString(uint32_t x, char* s) {
   s[3] = x >> 24;
   s[2] = (x >> 16) & 0xff;
@@ -74,145 +119,449 @@ static void V4L2MakeFourCCString(uint32_t x, char* s) {
 
 std::vector<uint32_t> getListOfUsableFourCcs(int32_t perferColorFormat) {
   std::vector<uint32_t> supportedFormats;
-  uint32_t perferFourCc = 0;
+  // several fourccs, e.g. contiguous and multi-planar, share a pixel format
+  std::vector<uint32_t> perferFourCcs;
   for (const auto& format : kSupportedFormatsAndPlanarity) {
     if (format.pixel_format ==
         static_cast<VideoFrameBuffer::PixelFormat>(perferColorFormat)) {
-      perferFourCc = format.fourcc;
+      perferFourCcs.push_back(format.fourcc);
       // insert later
       continue;
     }
     supportedFormats.push_back(format.fourcc);
   }
-  if (perferFourCc > 0) {
-    supportedFormats.insert(supportedFormats.begin(), perferFourCc);
-  }
+  supportedFormats.insert(supportedFormats.begin(), perferFourCcs.begin(),
+                          perferFourCcs.end());
   return supportedFormats;
 }
 
-uint32_t preferFormatFourCc(std::vector<v4l2_fmtdesc> deviceSupportV4L2Formats,
-                            int32_t perferColorFormat) {
+size_t numPlanes(uint32_t fourcc) {
+  for (const auto& format : kSupportedFormatsAndPlanarity) {
+    if (format.fourcc == fourcc) {
+      return format.num_planes;
+    }
+  }
+  return 1;
+}
+
+// Whether the device can capture `fourcc` at exactly width x height, devices
+// which can't enumerate frame sizes are assumed to.
+bool supportFrameSize(int fd,
+                      uint32_t fourcc,
+                      uint32_t width,
+                      uint32_t height) {
+  v4l2_frmsizeenum frmsize = {};
+  frmsize.pixel_format = fourcc;
+  if (::ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frmsize) < 0) {
+    return true;
+  }
+
+  if (frmsize.type != V4L2_FRMSIZE_TYPE_DISCRETE) {
+    const v4l2_frmsize_stepwise& step = frmsize.stepwise;
+    return width >= step.min_width && width <= step.max_width &&
+           height >= step.min_height && height <= step.max_height;
+  }
+
+  do {
+    if (frmsize.discrete.width == width && frmsize.discrete.height == height) {
+      return true;
+    }
+    frmsize.index++;
+  } while (::ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frmsize) >= 0);
+  return false;
+}
+
+// Whether the device can capture `fourcc` at width x height with at least
+// `framerate` fps, devices which can't enumerate frame intervals are assumed
+// to.
+bool supportFrameRate(int fd,
+                      uint32_t fourcc,
+                      uint32_t width,
+                      uint32_t height,
+                      int32_t framerate) {
+  v4l2_frmivalenum frmival = {};
+  frmival.pixel_format = fourcc;
+  frmival.width = width;
+  frmival.height = height;
+  if (::ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &frmival) < 0) {
+    return true;
+  }
+
+  // a frame interval of num/den seconds reaches framerate if den/num >= it,
+  // within 1% so 30000/1001 passes for 30
+  auto reaches = [framerate](const v4l2_fract& interval) {
+    return interval.numerator > 0 &&
+           static_cast<uint64_t>(interval.denominator) * 100 >=
+               static_cast<uint64_t>(framerate) * interval.numerator * 99;
+  };
+
+  if (frmival.type != V4L2_FRMIVAL_TYPE_DISCRETE) {
+    // the shortest interval is the fastest the device goes
+    return reaches(frmival.stepwise.min);
+  }
+
+  do {
+    if (reaches(frmival.discrete)) {
+      return true;
+    }
+    frmival.index++;
+  } while (::ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &frmival) >= 0);
+  return false;
+}
+
+// The first usable format which the device captures at width x height and
+// `framerate`, so e.g. a usb camera only streaming 1080p as mjpeg isn't dropped
+// to yuyv 480p, nor to the yuyv 1080p it only manages at 5 fps. Falls back to
+// the first format at that size at any rate, then to the first usable format
+// at all. Formats the device captures natively win over ones converted in
+// software (V4L2_FMT_FLAG_EMULATED), e.g. a yuyv camera isn't asked for the
+// i420 libv4l derives from it.
+uint32_t preferFormatFourCc(int fd,
+                            std::vector<v4l2_fmtdesc> deviceSupportV4L2Formats,
+                            int32_t perferColorFormat,
+                            uint32_t width,
+                            uint32_t height,
+                            int32_t framerate) {
   const std::vector<uint32_t>& desiredFormats =
       getListOfUsableFourCcs(perferColorFormat);
 
-  for (auto& format : desiredFormats) {
-    char cc[5];
-    V4L2MakeFourCCString(format, cc);
-    if (std::find_if(deviceSupportV4L2Formats.begin(),
-                     deviceSupportV4L2Formats.end(),
-                     [format](v4l2_fmtdesc v4l2Format) {
-                       return format == v4l2Format.pixelformat;
-                     }) != deviceSupportV4L2Formats.end()) {
-      return format;
+  uint32_t sizeFallback = 0;
+  uint32_t fallback = 0;
+  for (bool emulated : {false, true}) {
+    for (auto& format : desiredFormats) {
+      auto it = std::find_if(deviceSupportV4L2Formats.begin(),
+                             deviceSupportV4L2Formats.end(),
+                             [format](v4l2_fmtdesc v4l2Format) {
+                               return format == v4l2Format.pixelformat;
+                             });
+      if (it == deviceSupportV4L2Formats.end() ||
+          ((it->flags & V4L2_FMT_FLAG_EMULATED) != 0) != emulated) {
+        continue;
+      }
+      if (supportFrameSize(fd, format, width, height)) {
+        if (supportFrameRate(fd, format, width, height, framerate)) {
+          return format;
+        }
+        if (sizeFallback == 0) {
+          sizeFallback = format;
+        }
+      }
+      if (fallback == 0) {
+        fallback = format;
+      }
     }
   }
-  return 0;
+  return sizeFallback != 0 ? sizeFallback : fallback;
+}
+
+bool isMultiPlanar(v4l2_buf_type type) {
+  return type == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
 }
 
 void fillV4L2Format(v4l2_format* format,
+                    v4l2_buf_type type,
                     uint32_t width,
                     uint32_t height,
                     uint32_t pixelformat) {
   memset(format, 0, sizeof(*format));
-  format->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  format->fmt.pix.width = width;
-  format->fmt.pix.height = height;
-  format->fmt.pix.pixelformat = pixelformat;
+  format->type = type;
+  if (isMultiPlanar(type)) {
+    format->fmt.pix_mp.width = width;
+    format->fmt.pix_mp.height = height;
+    format->fmt.pix_mp.pixelformat = pixelformat;
+    format->fmt.pix_mp.num_planes = numPlanes(pixelformat);
+  } else {
+    format->fmt.pix.width = width;
+    format->fmt.pix.height = height;
+    format->fmt.pix.pixelformat = pixelformat;
+  }
 }
 
-void fillV4L2RequestBuffer(v4l2_requestbuffers* request_buffer, int count) {
+void fillV4L2RequestBuffer(v4l2_requestbuffers* request_buffer,
+                           v4l2_buf_type type,
+                           int count) {
   memset(request_buffer, 0, sizeof(*request_buffer));
-  request_buffer->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  request_buffer->type = type;
   request_buffer->memory = V4L2_MEMORY_MMAP;
   request_buffer->count = count;
 }
 
-// Fills all parts of |buffer|.
+// Fills all parts of |buffer|, multi-planar buffers describe their planes in
+// |planes| which must hold VIDEO_MAX_PLANES entries.
 
-void fillV4L2Buffer(v4l2_buffer* buffer, int index) {
+void fillV4L2Buffer(v4l2_buffer* buffer,
+                    v4l2_buf_type type,
+                    int index,
+                    v4l2_plane* planes) {
   memset(buffer, 0, sizeof(*buffer));
   buffer->memory = V4L2_MEMORY_MMAP;
   buffer->index = index;
-  buffer->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buffer->type = type;
+  if (isMultiPlanar(type)) {
+    memset(planes, 0, sizeof(*planes) * VIDEO_MAX_PLANES);
+    buffer->m.planes = planes;
+    buffer->length = VIDEO_MAX_PLANES;
+  }
 }
 
-static void CreateVideoFrame(std::shared_ptr<VideoFrame>& frame_buffer,
-                             v4l2_format* format,
-                             uint8_t* data,
-                             size_t size) {
-  const int64_t now = Looper::getNowUs();
-  // char cc[5];
-  // V4L2MakeFourCCString(format->fmt.pix.pixelformat, cc);
-  // AVE_LOG(LS_INFO) << "CreateVideoFrame, format: " << cc
-  //              << ", width:" << format->fmt.pix.width
-  //              << ", timestamp:";
-  //              << ", height:" << format->fmt.pix.height << ", size:" << size
-
-  switch (format->fmt.pix.pixelformat) {
+// Wraps the mmap'd driver buffer planes `planes`, the first holding
+// `bytesused` bytes, without copying them, `release` is called once the last
+// reference to the returned buffer goes away. Returns nullptr, without taking
+// `release`, if the pixel format is not supported.
+std::shared_ptr<VideoFrameBuffer> WrapV4L2Buffer(
+    const v4l2_format& format,
+    const uint8_t* const* planes,
+    size_t bytesused,
+    const std::function<void()>& release) {
+  const bool mplane = isMultiPlanar(static_cast<v4l2_buf_type>(format.type));
+  const v4l2_pix_format_mplane& pix_mp = format.fmt.pix_mp;
+  const size_t width = mplane ? pix_mp.width : format.fmt.pix.width;
+  const size_t height = mplane ? pix_mp.height : format.fmt.pix.height;
+  const uint32_t pixelformat =
+      mplane ? pix_mp.pixelformat : format.fmt.pix.pixelformat;
+  const size_t bytesperline = mplane ? pix_mp.plane_fmt[0].bytesperline
+                                     : format.fmt.pix.bytesperline;
+  const uint8_t* data = planes[0];
+
+  switch (pixelformat) {
     case V4L2_PIX_FMT_YUV420: {
-      auto video_frame_buffer =
-          I420Buffer::Create(format->fmt.pix.width, format->fmt.pix.height);
-      memcpy(video_frame_buffer->MutableDataY(), data,
-             video_frame_buffer->StrideY() * video_frame_buffer->height());
-      memcpy(
-          video_frame_buffer->MutableDataU(),
-          data + video_frame_buffer->StrideY() * video_frame_buffer->height(),
-          video_frame_buffer->StrideU() * video_frame_buffer->height() / 2);
-
-      memcpy(
-          video_frame_buffer->MutableDataV(),
-          data + video_frame_buffer->StrideY() * video_frame_buffer->height() +
-              video_frame_buffer->StrideU() * video_frame_buffer->height() / 2,
-          video_frame_buffer->StrideV() * video_frame_buffer->height() / 2);
-
-      frame_buffer = std::make_shared<VideoFrame>(0, video_frame_buffer, now,
-                                                  std::nullopt);
-      break;
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      const size_t stride_uv = (stride_y + 1) / 2;
+      const uint8_t* data_u = data + stride_y * height;
+      const uint8_t* data_v = data_u + stride_uv * ((height + 1) / 2);
+      return WrappedI420Buffer::Create(width, height, data, stride_y, data_u,
+                                       stride_uv, data_v, stride_uv, release);
     }
 
     case V4L2_PIX_FMT_NV12: {
-      auto video_frame_buffer = NV12Buffer::Copy(
-          data, format->fmt.pix.width,
-          data + format->fmt.pix.width * format->fmt.pix.height,
-          format->fmt.pix.width + format->fmt.pix.width % 2,
-          format->fmt.pix.width, format->fmt.pix.height);
-      frame_buffer = std::make_shared<VideoFrame>(0, video_frame_buffer, now,
-                                                  std::nullopt);
-      break;
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      return WrappedNV12Buffer::Create(width, height, data, stride_y,
+                                       data + stride_y * height,
+                                       stride_y + stride_y % 2, release);
+    }
+
+    case V4L2_PIX_FMT_YUV420M: {
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      const size_t stride_u = pix_mp.plane_fmt[1].bytesperline
+                                  ? pix_mp.plane_fmt[1].bytesperline
+                                  : (width + 1) / 2;
+      const size_t stride_v = pix_mp.plane_fmt[2].bytesperline
+                                  ? pix_mp.plane_fmt[2].bytesperline
+                                  : (width + 1) / 2;
+      return WrappedI420Buffer::Create(width, height, planes[0], stride_y,
+                                       planes[1], stride_u, planes[2],
+                                       stride_v, release);
+    }
+
+    case V4L2_PIX_FMT_NV12M: {
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      const size_t stride_uv = pix_mp.plane_fmt[1].bytesperline
+                                   ? pix_mp.plane_fmt[1].bytesperline
+                                   : width + width % 2;
+      return WrappedNV12Buffer::Create(width, height, planes[0], stride_y,
+                                       planes[1], stride_uv, release);
+    }
+
+    case V4L2_PIX_FMT_NV21: {
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      return WrappedNV21Buffer::Create(width, height, data, stride_y,
+                                       data + stride_y * height,
+                                       stride_y + stride_y % 2, release);
+    }
+
+    case V4L2_PIX_FMT_NV21M: {
+      const size_t stride_y = bytesperline ? bytesperline : width;
+      const size_t stride_vu = pix_mp.plane_fmt[1].bytesperline
+                                   ? pix_mp.plane_fmt[1].bytesperline
+                                   : width + width % 2;
+      return WrappedNV21Buffer::Create(width, height, planes[0], stride_y,
+                                       planes[1], stride_vu, release);
     }
 
     case V4L2_PIX_FMT_YUYV: {
-      auto video_frame_buffer =
-          YUYVBuffer::Copy(data, format->fmt.pix.width * 2,
-                           format->fmt.pix.width, format->fmt.pix.height);
-      frame_buffer = std::make_shared<VideoFrame>(0, video_frame_buffer, now,
-                                                  std::nullopt);
-      break;
+      const size_t stride = bytesperline ? bytesperline : width * 2;
+      return WrappedYUYVBuffer::Create(width, height, data, stride, release);
+    }
+
+    case V4L2_PIX_FMT_UYVY: {
+      const size_t stride = bytesperline ? bytesperline : width * 2;
+      return WrappedUYVYBuffer::Create(width, height, data, stride, release);
     }
 
+    case V4L2_PIX_FMT_ABGR32:
+    case V4L2_PIX_FMT_XBGR32:
+    case V4L2_PIX_FMT_BGR32: {
+      const size_t stride = bytesperline ? bytesperline : width * 4;
+      return WrappedBGRABuffer::Create(width, height, data, stride, release);
+    }
+
+    case V4L2_PIX_FMT_RGB24: {
+      const size_t stride = bytesperline ? bytesperline : width * 3;
+      return WrappedRGB24Buffer::Create(width, height, data, stride, release);
+    }
+
+#if defined(OC_MJPEG)
+    case V4L2_PIX_FMT_MJPEG: {
+      return MJPEGBuffer::Create(width, height, data, bytesused, release);
+    }
+#endif
+
     default: {
-      break;
+      return nullptr;
     }
   }
 }
 
 }  // namespace
 
+// Frames handed out zero-copy keep a reference to the queue, so a buffer
+// released after the stream stopped is unmapped here instead of being queued
+// to a stream (or fd) that no longer exists.
+class V4L2VideoSource::BufferQueue {
+ public:
+  struct Plane {
+    uint8_t* data;
+    size_t size;
+    // -1 if the plane was not exported
+    int dmabuf_fd;
+  };
+
+  // keeps a dup of `fd`, the last frame may outlive the source
+  BufferQueue(int fd, v4l2_buf_type type)
+      : fd_(::fcntl(fd, F_DUPFD_CLOEXEC, 0)),
+        type_(type),
+        streaming_(true),
+        outstanding_(0) {}
+
+  ~BufferQueue() {
+    for (auto& planes : buffers_) {
+      for (auto& plane : planes) {
+        ::munmap(plane.data, plane.size);
+        if (plane.dmabuf_fd >= 0) {
+          ::close(plane.dmabuf_fd);
+        }
+      }
+    }
+    if (fd_ < 0) {
+      return;
+    }
+    // the driver refuses to free buffers which are still mapped with EBUSY,
+    // so this waits for the last frame instead of happening on stop
+    v4l2_requestbuffers request;
+    fillV4L2RequestBuffer(&request, type_, 0);
+    if (::ioctl(fd_, VIDIOC_REQBUFS, &request) < 0) {
+      AVE_LOG(LS_ERROR) << "Failed to VIDIOC_REQBUFS with count = 0, errno:"
+                        << errno;
+    }
+    ::close(fd_);
+  }
+
+  // one plane per v4l2 plane, a single one unless capturing multi-planar
+  void AddBuffer(std::vector<Plane> planes) {
+    buffers_.push_back(std::move(planes));
+  }
+
+  const std::vector<Plane>& planes(uint32_t index) const {
+    return buffers_[index];
+  }
+
+  // Lends the dequeued buffer `index` to a frame. If that would leave the
+  // driver with fewer than kMinQueuedBuffers buffers to fill, the buffer is
+  // given straight back to the driver instead and false is returned.
+  bool Lend(uint32_t index) {
+    lock_guard l(&lock_);
+    if (buffers_.size() - outstanding_ - 1 < kMinQueuedBuffers) {
+      QueueLocked(index);
+      return false;
+    }
+    outstanding_++;
+    return true;
+  }
+
+  // Called from any thread when the last frame referencing `index` is gone.
+  void Release(uint32_t index) {
+    lock_guard l(&lock_);
+    AVE_DCHECK_GT(outstanding_, 0);
+    outstanding_--;
+    QueueLocked(index);
+  }
+
+  // After stop, released buffers are no longer handed back to the driver.
+  void Stop() {
+    lock_guard l(&lock_);
+    streaming_ = false;
+  }
+
+ private:
+  void QueueLocked(uint32_t index) {
+    if (!streaming_) {
+      return;
+    }
+    v4l2_buffer buffer;
+    v4l2_plane planes[VIDEO_MAX_PLANES];
+    fillV4L2Buffer(&buffer, type_, index, planes);
+    if (::ioctl(fd_, VIDIOC_QBUF, &buffer) < 0) {
+      AVE_LOG(LS_ERROR) << "failed to enqueue capture buffer " << index;
+    }
+  }
+
+  const int fd_;
+  const v4l2_buf_type type_;
+  std::vector<std::vector<Plane>> buffers_;
+
+  Mutex lock_;
+  bool streaming_ GUARDED_BY(lock_);
+  size_t outstanding_ GUARDED_BY(lock_);
+};
+
 std::shared_ptr<V4L2VideoSource> V4L2VideoSource::Create(
     std::shared_ptr<Message> info) {
   std::string v4l2_dev;
   AVE_CHECK(info->findString("v4l2-dev", v4l2_dev));
-  return std::make_shared<V4L2VideoSource>(v4l2_dev.c_str());
+  int32_t timeout_limit = kContinuousTimeoutLimit;
+  info->findInt32("continuous-timeout-limit", &timeout_limit);
+  int32_t buffer_count = kDefaultVideoBuffers;
+  info->findInt32("buffer-count", &buffer_count);
+  int32_t export_dmabuf = 0;
+  info->findInt32("export-dmabuf", &export_dmabuf);
+  buffer_count = std::clamp<int32_t>(
+      buffer_count, static_cast<int32_t>(kMinQueuedBuffers) + 1,
+      VIDEO_MAX_FRAME);
+  return std::make_shared<V4L2VideoSource>(v4l2_dev.c_str(), timeout_limit,
+                                           buffer_count, export_dmabuf != 0);
+}
+
+// static
+std::string V4L2VideoSource::fourccToString(uint32_t fourcc) {
+  char cc[5];
+  V4L2MakeFourCCString(fourcc, cc);
+  return cc;
 }
 
-V4L2VideoSource::V4L2VideoSource(const char* device, protect_parameter)
-    : task_runner_factory_(base::CreateDefaultTaskRunnerFactory()),
-      task_runner_(std::make_unique<base::TaskRunner>(
-          task_runner_factory_->CreateTaskRunner(
-              "V4L2VideoSource",
-              base::TaskRunnerFactory::Priority::NORMAL))),
+V4L2VideoSource::V4L2VideoSource(const char* device,
+                                 int32_t continuous_timeout_limit,
+                                 uint32_t buffer_count,
+                                 bool export_dmabuf,
+                                 protect_parameter)
+    : epoll_fd_(-1),
+      wakeup_fd_(-1),
+      capturing_(false),
+      capture_timeout_ms_(kCaptureTimeoutMs),
+      continuous_timeout_limit_(continuous_timeout_limit),
+      continuous_timeouts_(0),
+      capture_status_(OK),
+      buffer_count_(buffer_count),
+      export_dmabuf_(export_dmabuf),
+      buf_type_(V4L2_BUF_TYPE_VIDEO_CAPTURE),
       mFd(-1),
-      frame_count_(0) {
+      mWidth(0),
+      mHeight(0),
+      mColorFormat(0),
+      frame_count_(0),
+      frame_dropped_(0),
+      frame_lost_(0),
+      last_dequeue_time_us_(0),
+      clock_offset_us_(0) {
   AVE_LOG(LS_INFO) << "V4L2VideoSource::V4L2VideoSource";
   mFd = ::open(device, O_RDWR);
   if (mFd < 0) {
@@ -221,19 +570,30 @@ V4L2VideoSource::V4L2VideoSource(const char* device, protect_parameter)
   }
 
   v4l2_capability cap = {};
-  if (!(doIoctl(VIDIOC_QUERYCAP, &cap) == 0 &&
-        (((cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) &&
-          !(cap.capabilities & V4L2_CAP_VIDEO_OUTPUT)) ||
-         ((cap.capabilities & V4L2_CAP_DEVICE_CAPS) &&
-          (cap.device_caps & V4L2_CAP_VIDEO_CAPTURE) &&
-          !(cap.device_caps & V4L2_CAP_VIDEO_OUTPUT))))) {
+  if (doIoctl(VIDIOC_QUERYCAP, &cap) < 0) {
     AVE_LOG(LS_ERROR) << "get cap error, not v4l2 device";
     return;
   }
+  const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS)
+                            ? cap.device_caps
+                            : cap.capabilities;
+  if (caps & (V4L2_CAP_VIDEO_OUTPUT | V4L2_CAP_VIDEO_OUTPUT_MPLANE)) {
+    AVE_LOG(LS_ERROR) << "not a capture device";
+    return;
+  }
+  // isp pipelines often expose their planar formats through mplane only
+  if (caps & V4L2_CAP_VIDEO_CAPTURE) {
+    buf_type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  } else if (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) {
+    buf_type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+  } else {
+    AVE_LOG(LS_ERROR) << "not a capture device";
+    return;
+  }
   mV4L2Capability = cap;
 
   v4l2_fmtdesc fmtdesc = {};
-  fmtdesc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  fmtdesc.type = buf_type_;
   for (; doIoctl(VIDIOC_ENUM_FMT, &fmtdesc) == 0; ++fmtdesc.index) {
     char cc[5];
     V4L2MakeFourCCString(fmtdesc.pixelformat, cc);
@@ -250,22 +610,13 @@ V4L2VideoSource::V4L2VideoSource(const char* device, protect_parameter)
   metaData.setInt32(kKeyColorFormat,
                     static_cast<int32_t>(VideoFrameBuffer::PixelFormat::kI420));
   start(&metaData);
-
-  repeating_task_handler_ = base::RepeatingTaskHandle::DelayedStart(
-      task_runner_->Get(), 1 * 1000 * 1000, [this]() {
-        std::shared_ptr<VideoFrame> frame;
-        read(frame);
-        if (frame) {
-          for (auto& sink : sink_pairs()) {
-            sink.sink->OnFrame(frame);
-          }
-        }
-        //   50ms, about 20fps
-        return (uint64_t)(50 * 1000);
-      });
 }
 
 V4L2VideoSource::~V4L2VideoSource() {
+  stopCaptureThread();
+  if (buffer_queue_) {
+    stopStream();
+  }
   if (mFd > 0) {
     ::close(mFd);
     mFd = -1;
@@ -275,24 +626,24 @@ V4L2VideoSource::~V4L2VideoSource() {
 void V4L2VideoSource::AddOrUpdateSink(
     VideoSinkInterface<std::shared_ptr<VideoFrame>>* sink,
     const VideoSinkWants& wants) {
-  task_runner_->PostTask([this, sink, wants]() {
-    VideoSourceBase<std::shared_ptr<VideoFrame>>::AddOrUpdateSink(sink, wants);
-  });
+  lock_guard l(&sink_lock_);
+  VideoSourceBase<std::shared_ptr<VideoFrame>>::AddOrUpdateSink(sink, wants);
 }
 
 void V4L2VideoSource::RemoveSink(
     VideoSinkInterface<std::shared_ptr<VideoFrame>>* sink) {
-  task_runner_->PostTask([this, sink]() {
-    AVE_LOG(LS_INFO) << "RemoveSink";
-    VideoSourceBase::RemoveSink(sink);
-  });
+  AVE_LOG(LS_INFO) << "RemoveSink";
+  lock_guard l(&sink_lock_);
+  VideoSourceBase::RemoveSink(sink);
 }
 
 status_t V4L2VideoSource::start(MetaData* params) {
   if (mFd < 0) {
     return NO_INIT;
   }
-  // TODO() reset
+  if (buffer_queue_) {
+    stop();
+  }
 
   // read params
   int32_t width = 0;
@@ -303,8 +654,16 @@ status_t V4L2VideoSource::start(MetaData* params) {
   int32_t preferColorFormat = -1;
   AVE_CHECK(params->findInt32(kKeyColorFormat, &preferColorFormat));
 
+  int32_t framerate = 0;
+  params->findInt32(kKeyFrameRate, &framerate);
+  if (framerate <= 0) {
+    framerate = kTypicalFramerate;
+  }
+  start_params_ = StartParams{width, height, preferColorFormat, framerate};
+
   // 1. prefer format, 2. support formats by device, support formats in code;
-  uint32_t colorFormat = preferFormatFourCc(mV4L2Formats, preferColorFormat);
+  uint32_t colorFormat = preferFormatFourCc(mFd, mV4L2Formats, preferColorFormat,
+                                            width, height, framerate);
   if (colorFormat == 0) {
     return ERROR_UNSUPPORTED;
   }
@@ -314,30 +673,44 @@ status_t V4L2VideoSource::start(MetaData* params) {
   AVE_LOG(LS_INFO) << "choosen pixel format is " << cc;
   mColorFormat = colorFormat;
 
-  fillV4L2Format(&mVideoFmt, width, height, colorFormat);
+  fillV4L2Format(&mVideoFmt, buf_type_, width, height, colorFormat);
   if (doIoctl(VIDIOC_S_FMT, &mVideoFmt) < 0) {
     AVE_LOG(LS_ERROR) << "failed to set video format";
     return ERROR_UNSUPPORTED;
   }
-  V4L2MakeFourCCString(mVideoFmt.fmt.pix.pixelformat, cc);
 
-  mWidth = mVideoFmt.fmt.pix.width;
-  mHeight = mVideoFmt.fmt.pix.height;
+  uint32_t pixelformat;
+  if (isMultiPlanar(buf_type_)) {
+    pixelformat = mVideoFmt.fmt.pix_mp.pixelformat;
+    mWidth = mVideoFmt.fmt.pix_mp.width;
+    mHeight = mVideoFmt.fmt.pix_mp.height;
+  } else {
+    pixelformat = mVideoFmt.fmt.pix.pixelformat;
+    mWidth = mVideoFmt.fmt.pix.width;
+    mHeight = mVideoFmt.fmt.pix.height;
+  }
+  V4L2MakeFourCCString(pixelformat, cc);
+
+#if defined(OC_MJPEG)
+  if (pixelformat == V4L2_PIX_FMT_MJPEG) {
+    if (!jpeg_decoder_pool_) {
+      jpeg_decoder_pool_ = std::make_unique<JpegDecoderPool>();
+    }
+  } else {
+    jpeg_decoder_pool_.reset();
+  }
+#endif
 
   AVE_LOG(LS_INFO) << "set format: " << cc << ", res: [" << width << "x"
                    << height << "] -> [" << mWidth << "x" << mHeight << "]";
 
-  int32_t framerate = 0;
-  params->findInt32(kKeyFrameRate, &framerate);
-
   v4l2_streamparm streamparm = {};
-  streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  streamparm.type = buf_type_;
   if (doIoctl(VIDIOC_G_PARM, &streamparm) >= 0) {
     if (streamparm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) {
       streamparm.parm.capture.timeperframe.numerator = kFrameRatePrecision;
       streamparm.parm.capture.timeperframe.denominator =
-          (framerate) ? (framerate * kFrameRatePrecision)
-                      : (kTypicalFramerate * kFrameRatePrecision);
+          framerate * kFrameRatePrecision;
 
       if (doIoctl(VIDIOC_S_PARM, &streamparm) < 0) {
         AVE_LOG(LS_ERROR) << "fail to set camera framerate";
@@ -347,36 +720,91 @@ status_t V4L2VideoSource::start(MetaData* params) {
                        << streamparm.parm.capture.timeperframe.denominator
                        << "/" << streamparm.parm.capture.timeperframe.numerator;
     }
+
+    // wait for the rate the driver actually negotiated
+    const v4l2_fract& timeperframe = streamparm.parm.capture.timeperframe;
+    if (timeperframe.numerator > 0 && timeperframe.denominator > 0) {
+      const int frame_interval_ms = static_cast<int>(
+          1000LL * timeperframe.numerator / timeperframe.denominator);
+      capture_timeout_ms_ = std::max(
+          kCaptureTimeoutMs, kCaptureTimeoutFrames * frame_interval_ms);
+    }
   }
 
-  if (!startStream()) {
+  if (!startStream() || !startCaptureThread()) {
     return UNKNOWN_ERROR;
   }
 
   return OK;
 }
 
+std::vector<VideoFrameBuffer::PixelFormat>
+V4L2VideoSource::supportedPixelFormats() const {
+  std::vector<VideoFrameBuffer::PixelFormat> pixel_formats;
+  for (const auto& format : kSupportedFormatsAndPlanarity) {
+    const bool offered =
+        std::any_of(mV4L2Formats.begin(), mV4L2Formats.end(),
+                    [&format](const v4l2_fmtdesc& fmtdesc) {
+                      return fmtdesc.pixelformat == format.fourcc;
+                    });
+    if (offered && std::find(pixel_formats.begin(), pixel_formats.end(),
+                             format.pixel_format) == pixel_formats.end()) {
+      pixel_formats.push_back(format.pixel_format);
+    }
+  }
+  return pixel_formats;
+}
+
 bool V4L2VideoSource::mapAndQueueBuffer(int index) {
   v4l2_buffer buffer;
-  fillV4L2Buffer(&buffer, index);
+  v4l2_plane v4l2_planes[VIDEO_MAX_PLANES];
+  fillV4L2Buffer(&buffer, buf_type_, index, v4l2_planes);
   if (doIoctl(VIDIOC_QUERYBUF, &buffer) < 0) {
     AVE_LOG(LS_ERROR) << "error querying status of a MMAP V4L2 buffer";
     return false;
   }
 
-  constexpr int kFlags = PROT_READ | PROT_WRITE;
-  void* const start =
-      ::mmap(nullptr, buffer.length, kFlags, MAP_SHARED, mFd, buffer.m.offset);
+  const bool mplane = isMultiPlanar(buf_type_);
+  const uint32_t num_planes = mplane ? buffer.length : 1;
+  std::vector<BufferQueue::Plane> planes;
+  for (uint32_t i = 0; i < num_planes; i++) {
+    const size_t length = mplane ? v4l2_planes[i].length : buffer.length;
+    const off_t offset =
+        mplane ? v4l2_planes[i].m.mem_offset : buffer.m.offset;
+
+    constexpr int kFlags = PROT_READ | PROT_WRITE;
+    void* const start =
+        ::mmap(nullptr, length, kFlags, MAP_SHARED, mFd, offset);
+    if (start == MAP_FAILED) {
+      AVE_LOG(LS_ERROR) << "Error mmap()ing a V4L2 buffer into userspace";
+      for (auto& plane : planes) {
+        ::munmap(plane.data, plane.size);
+        if (plane.dmabuf_fd >= 0) {
+          ::close(plane.dmabuf_fd);
+        }
+      }
+      return false;
+    }
 
-  if (start == MAP_FAILED) {
-    AVE_LOG(LS_ERROR) << "Error mmap()ing a V4L2 buffer into userspace";
-    return false;
-  }
+    int dmabuf_fd = -1;
+    if (export_dmabuf_) {
+      v4l2_exportbuffer expbuf = {};
+      expbuf.type = buf_type_;
+      expbuf.index = index;
+      expbuf.plane = i;
+      expbuf.flags = O_RDONLY | O_CLOEXEC;
+      if (doIoctl(VIDIOC_EXPBUF, &expbuf) < 0) {
+        // the cpu mapping still works, only consumers lose the dma-buf
+        AVE_LOG(LS_WARNING) << "failed to export V4L2 buffer " << index
+                            << " plane " << i << " as dma-buf";
+      } else {
+        dmabuf_fd = expbuf.fd;
+      }
+    }
 
-  V4L2Buffer v4lBuffer = {};
-  v4lBuffer.data = static_cast<uint8_t*>(start);
-  v4lBuffer.size = buffer.length;
-  mBuffers.push_back(v4lBuffer);
+    planes.push_back({static_cast<uint8_t*>(start), length, dmabuf_fd});
+  }
+  buffer_queue_->AddBuffer(std::move(planes));
 
   // enqueue the buffer
   if (doIoctl(VIDIOC_QBUF, &buffer) < 0) {
@@ -388,13 +816,29 @@ bool V4L2VideoSource::mapAndQueueBuffer(int index) {
 }
 
 bool V4L2VideoSource::startStream() {
+  for (int waited_ms = 0; !retired_buffer_queue_.expired();
+       waited_ms += kRetiredBuffersPollMs) {
+    if (waited_ms >= kRetiredBuffersWaitMs) {
+      AVE_LOG(LS_ERROR) << "buffers of the last stream still held downstream";
+      return false;
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(kRetiredBuffersPollMs));
+  }
+
   v4l2_requestbuffers r_buffer;
-  fillV4L2RequestBuffer(&r_buffer, kNumVideoBuffers);
+  fillV4L2RequestBuffer(&r_buffer, buf_type_, buffer_count_);
   if (doIoctl(VIDIOC_REQBUFS, &r_buffer) < 0) {
     AVE_LOG(LS_ERROR) << "failed to mmap buffers from V4L2";
     return false;
   }
+  if (r_buffer.count != buffer_count_) {
+    AVE_LOG(LS_INFO) << "requested " << buffer_count_
+                     << " capture buffers, driver allocated "
+                     << r_buffer.count;
+  }
 
+  buffer_queue_ = std::make_shared<BufferQueue>(mFd, buf_type_);
   for (unsigned int i = 0; i < r_buffer.count; ++i) {
     if (!mapAndQueueBuffer(i)) {
       AVE_LOG(LS_ERROR) << "Allocate buffer failed";
@@ -402,86 +846,278 @@ bool V4L2VideoSource::startStream() {
     }
   }
 
-  v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  v4l2_buf_type capture_type = buf_type_;
   if (doIoctl(VIDIOC_STREAMON, &capture_type) < 0) {
     AVE_LOG(LS_ERROR) << "VIDIOC_STREAMON failed";
     return false;
   }
 
+  last_sequence_.reset();
+  clock_offset_us_ = Looper::getNowUs() - MonotonicNowUs();
+
   return true;
 }
 
 status_t V4L2VideoSource::stop() {
+  stopCaptureThread();
   stopStream();
   return OK;
 }
 
+status_t V4L2VideoSource::restart() {
+  if (!start_params_) {
+    return NO_INIT;
+  }
+  MetaData params;
+  params.setInt32(kKeyWidth, start_params_->width);
+  params.setInt32(kKeyHeight, start_params_->height);
+  params.setInt32(kKeyColorFormat, start_params_->color_format);
+  params.setInt32(kKeyFrameRate, start_params_->framerate);
+  // start() stops the capture left behind by the error first
+  return start(&params);
+}
+
+void V4L2VideoSource::setNotify(std::shared_ptr<Message> notify) {
+  lock_guard l(&notify_lock_);
+  notify_ = std::move(notify);
+}
+
+void V4L2VideoSource::notifyCaptureError(status_t err) {
+  lock_guard l(&notify_lock_);
+  if (!notify_) {
+    return;
+  }
+  auto notify = notify_->dup();
+  notify->setInt32("what", kWhatCaptureError);
+  notify->setInt32("err", err);
+  notify->post();
+}
+
 bool V4L2VideoSource::stopStream() {
-  v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  bool ret = true;
+  v4l2_buf_type capture_type = buf_type_;
   if (doIoctl(VIDIOC_STREAMOFF, &capture_type) < 0) {
     AVE_LOG(LS_ERROR) << "VIDIOC_STREAMOFF failed";
+    ret = false;
+  }
 
-    return false;
+  // buffers still held downstream are unmapped and freed in the driver once
+  // their frames are gone
+  if (buffer_queue_) {
+    buffer_queue_->Stop();
+    retired_buffer_queue_ = buffer_queue_;
+    buffer_queue_.reset();
+  }
+  return ret;
+}
+
+status_t V4L2VideoSource::dequeueFrame(std::shared_ptr<VideoFrame>& buffer) {
+  v4l2_buffer v4lBuffer;
+  v4l2_plane v4l2_planes[VIDEO_MAX_PLANES];
+  fillV4L2Buffer(&v4lBuffer, buf_type_, 0, v4l2_planes);
+
+  if (doIoctl(VIDIOC_DQBUF, &v4lBuffer) < 0) {
+    AVE_LOG(LS_ERROR) << "failed to dequeue capture buffer";
+    return UNKNOWN_ERROR;
   }
+  last_dequeue_time_us_ = Looper::getNowUs();
 
-  v4l2_requestbuffers r_buffer;
-  fillV4L2RequestBuffer(&r_buffer, 0);
-  if (doIoctl(VIDIOC_REQBUFS, &r_buffer) < 0) {
-    AVE_LOG(LS_ERROR) << "Failed to VIDIOC_REQBUFS with count = 0";
+  if (last_sequence_ && v4lBuffer.sequence > *last_sequence_ + 1) {
+    const uint32_t lost = v4lBuffer.sequence - *last_sequence_ - 1;
+    const uint64_t total = frame_lost_ += lost;
+    AVE_LOG(LS_VERBOSE) << "driver dropped " << lost << " frames before #"
+                        << v4lBuffer.sequence << ", total " << total;
+  }
+  last_sequence_ = v4lBuffer.sequence;
+
+  const uint32_t index = v4lBuffer.index;
+  if (!buffer_queue_->Lend(index)) {
+    frame_dropped_++;
+    AVE_LOG(LS_VERBOSE) << "all capture buffers held downstream, drop frame";
+    return ERROR_RETRY;
+  }
+
+  std::shared_ptr<BufferQueue> queue = buffer_queue_;
+  auto release = [queue, index]() { queue->Release(index); };
+  const std::vector<BufferQueue::Plane>& planes = buffer_queue_->planes(index);
+  const uint8_t* plane_data[VIDEO_MAX_PLANES] = {};
+  for (size_t i = 0; i < planes.size(); i++) {
+    plane_data[i] = planes[i].data;
+  }
+  const size_t bytesused = isMultiPlanar(buf_type_)
+                               ? v4l2_planes[0].bytesused
+                               : v4lBuffer.bytesused;
+  std::shared_ptr<VideoFrameBuffer> frame_buffer =
+      WrapV4L2Buffer(mVideoFmt, plane_data, bytesused, release);
+  if (frame_buffer == nullptr) {
+    release();
+    return ERROR_UNSUPPORTED;
+  }
+
+#if defined(OC_MJPEG)
+  if (jpeg_decoder_pool_) {
+    jpeg_decoder_pool_->Decode(
+        std::static_pointer_cast<MJPEGBuffer>(frame_buffer));
+  }
+#endif
+
+  if (std::all_of(planes.begin(), planes.end(),
+                  [](const auto& plane) { return plane.dmabuf_fd >= 0; })) {
+    std::vector<DmaBufFrameBuffer::Plane> dmabuf_planes;
+    for (const auto& plane : planes) {
+      dmabuf_planes.push_back({plane.dmabuf_fd, plane.size});
+    }
+    frame_buffer = DmaBufFrameBuffer::Create(std::move(dmabuf_planes),
+                                             std::move(frame_buffer));
+  }
 
+  buffer = std::make_shared<VideoFrame>(frame_count_++, frame_buffer,
+                                        captureTimeUs(v4lBuffer), std::nullopt);
+  const std::shared_ptr<FrameMetadata>& metadata = buffer->metadata();
+  metadata->SetStageTime(FrameMetadata::Stage::kCapture,
+                         buffer->timestamp_us());
+  metadata->SetStageTime(FrameMetadata::Stage::kDequeue,
+                         last_dequeue_time_us_);
+  metadata->SetSourceSequence(static_cast<int64_t>(v4lBuffer.sequence));
+
+  return OK;
+}
+
+int64_t V4L2VideoSource::captureTimeUs(const v4l2_buffer& buffer) {
+  const int64_t now = Looper::getNowUs();
+  if ((buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) !=
+      V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+    // no usable driver timestamp, fall back to dequeue time
+    return now;
+  }
+
+  const int64_t capture_time_us =
+      static_cast<int64_t>(buffer.timestamp.tv_sec) * 1000000 +
+      buffer.timestamp.tv_usec + clock_offset_us_;
+  if (capture_time_us > now || now - capture_time_us > kMaxCaptureDelayUs) {
+    AVE_LOG(LS_VERBOSE) << "driver timestamp " << capture_time_us
+                        << " too far from now " << now;
+    return now;
+  }
+  return capture_time_us;
+}
+
+bool V4L2VideoSource::startCaptureThread() {
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (epoll_fd_ < 0 || wakeup_fd_ < 0) {
+    AVE_LOG(LS_ERROR) << "failed to create capture epoll, errno:" << errno;
+    stopCaptureThread();
+    return false;
+  }
+
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = mFd;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, mFd, &event) < 0) {
+    AVE_LOG(LS_ERROR) << "failed to watch v4l2 fd, errno:" << errno;
+    stopCaptureThread();
+    return false;
+  }
+  event.events = EPOLLIN;
+  event.data.fd = wakeup_fd_;
+  if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) < 0) {
+    AVE_LOG(LS_ERROR) << "failed to watch wakeup fd, errno:" << errno;
+    stopCaptureThread();
     return false;
   }
+
+  continuous_timeouts_ = 0;
+  capture_status_ = OK;
+  capturing_ = true;
+  capture_thread_ = std::make_unique<base::Thread>(
+      [this] {
+        while (captureProcess()) {
+        }
+        // stop() clears capturing_ before waking the thread, so still set
+        // means the capture died on its own
+        if (capturing_.exchange(false)) {
+          notifyCaptureError(capture_status_);
+        }
+      },
+      "v4l2_capture_thread", AVE_PRIORITY_VIDEO);
+  capture_thread_->start();
   return true;
 }
 
-status_t V4L2VideoSource::read(std::shared_ptr<VideoFrame>& buffer) {
-  pollfd pfd = {};
-  pfd.fd = mFd;
-  pfd.events = POLLIN;
-  const int result = ::poll(&pfd, 1, kCaptureTimeoutMs);
-  if (result < 0) {
-    AVE_LOG(LS_ERROR) << "poll failed " << result;
-    return result;
+void V4L2VideoSource::stopCaptureThread() {
+  if (capture_thread_) {
+    capturing_ = false;
+    uint64_t value = 1;
+    if (::write(wakeup_fd_, &value, sizeof(value)) < 0) {
+      AVE_LOG(LS_ERROR) << "failed to wake up capture thread";
+    }
+    capture_thread_.reset();
   }
 
-  if (result == 0) {
-    return ERROR_RETRY;
+  if (wakeup_fd_ >= 0) {
+    ::close(wakeup_fd_);
+    wakeup_fd_ = -1;
+  }
+  if (epoll_fd_ >= 0) {
+    ::close(epoll_fd_);
+    epoll_fd_ = -1;
   }
-  //  AVE_LOG(LS_VERBOSE) << "pfd.events:" << pfd.events
-  //                  << ", pfd.revents:" << pfd.revents;
+}
 
-  if (pfd.revents & POLLIN) {
-    v4l2_buffer v4lBuffer;
-    fillV4L2Buffer(&v4lBuffer, 0);
+bool V4L2VideoSource::captureProcess() {
+  if (!capturing_) {
+    return false;
+  }
 
-    if (doIoctl(VIDIOC_DQBUF, &v4lBuffer) < 0) {
-      AVE_LOG(LS_ERROR) << "failed to dequeue capture buffer";
-      return UNKNOWN_ERROR;
+  epoll_event events[2];
+  const int result = ::epoll_wait(epoll_fd_, events, 2, capture_timeout_ms_);
+  if (result < 0) {
+    if (errno == EINTR) {
+      return true;
     }
+    AVE_LOG(LS_ERROR) << "capture epoll_wait failed, errno:" << errno;
+    capture_status_ = ERROR_IO;
+    return false;
+  }
 
-    CreateVideoFrame(buffer, &mVideoFmt, mBuffers[v4lBuffer.index].data,
-                     v4lBuffer.bytesused);
+  if (result == 0) {
+    if (++continuous_timeouts_ >= continuous_timeout_limit_) {
+      AVE_LOG(LS_ERROR) << "no frame from driver after "
+                        << continuous_timeouts_ << " timeouts of "
+                        << capture_timeout_ms_ << "ms, stop capture";
+      capture_status_ = TIMED_OUT;
+      return false;
+    }
+    AVE_LOG(LS_WARNING) << "capture timeout " << continuous_timeouts_;
+    return true;
+  }
 
-    if (buffer != nullptr) {
-      // TODO(youfa) use now us or v4l2 timestamp
-      // const int64_t now = Looper::getNowUs();
-      // AVE_LOG(LS_INFO) << "now:" << now
-      //             << ", v4lBuffer.timestamp:" << v4lBuffer.timestamp.tv_sec
-      //             << "," << v4lBuffer.timestamp.tv_usec << ", ts:"
-      //             << v4lBuffer.timestamp.tv_sec * 1000000 +
-      //                    v4lBuffer.timestamp.tv_usec;
-      // buffer->set_timestamp_us(now);
-      buffer->set_id(frame_count_++);
+  for (int i = 0; i < result; i++) {
+    if (events[i].data.fd == wakeup_fd_) {
+      return false;
+    }
+    if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+      AVE_LOG(LS_ERROR) << "v4l2 device error, events:" << events[i].events;
+      capture_status_ = ERROR_IO;
+      return false;
+    }
+    if (!(events[i].events & EPOLLIN)) {
+      continue;
     }
 
-    if (doIoctl(VIDIOC_QBUF, &v4lBuffer) < 0) {
-      AVE_LOG(LS_ERROR) << "failed to enqueue capture buffer";
-      return UNKNOWN_ERROR;
+    continuous_timeouts_ = 0;
+    std::shared_ptr<VideoFrame> frame;
+    if (dequeueFrame(frame) != OK || frame == nullptr) {
+      continue;
     }
 
-    return OK;
+    lock_guard l(&sink_lock_);
+    for (auto& sink : sink_pairs()) {
+      sink.sink->OnFrame(frame);
+    }
   }
-  return OK;
+  return true;
 }
 
 status_t V4L2VideoSource::pause() {
@@ -9,12 +9,21 @@
 #define V4L2_VIDEO_SOURCE_H
 #include <linux/videodev2.h>
 
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "api/video/video_frame.h"
-#include "base/task_util/repeating_task.h"
-#include "base/task_util/task_runner.h"
-#include "base/task_util/task_runner_factory.h"
+#include "base/mutex.h"
+#include "base/thread.h"
+#include "base/thread_annotation.h"
 #include "common/message.h"
 #include "common/meta_data.h"
+#if defined(OC_MJPEG)
+#include "media/video/jpeg_decoder_pool.h"
+#endif
 #include "media/video/video_source_base.h"
 
 namespace ave {
@@ -28,8 +37,14 @@ class V4L2VideoSource : public VideoSourceBase<std::shared_ptr<VideoFrame>> {
  public:
   static std::shared_ptr<V4L2VideoSource> Create(std::shared_ptr<Message> info);
 
-  explicit V4L2VideoSource(const char* device,
-                           protect_parameter = protect_parameter());
+  // printable v4l2 fourcc, e.g. "NV12"
+  static std::string fourccToString(uint32_t fourcc);
+
+  V4L2VideoSource(const char* device,
+                  int32_t continuous_timeout_limit,
+                  uint32_t buffer_count,
+                  bool export_dmabuf,
+                  protect_parameter = protect_parameter());
   virtual ~V4L2VideoSource() override;
 
   // VideoSourceBase implementation.
@@ -38,27 +53,100 @@ class V4L2VideoSource : public VideoSourceBase<std::shared_ptr<VideoFrame>> {
   void RemoveSink(
       VideoSinkInterface<std::shared_ptr<VideoFrame>>* sink) override;
 
+  // Negotiates the format in `params` and starts delivering frames to the
+  // sinks, a running capture is stopped first.
   status_t start(MetaData* params = nullptr);
 
   status_t stop();
 
-  status_t read(std::shared_ptr<VideoFrame>& buffer);
-
   status_t pause();
 
- private:
-  struct V4L2Buffer {
-    uint8_t* data;
-    size_t size;
+  // starts again with the params of the last start(), e.g. after
+  // kWhatCaptureError
+  status_t restart();
+
+  // A copy of `notify` is posted with "what" kWhatCaptureError and "err"
+  // when capture ends on its own, on driver timeouts or a device error,
+  // not on stop(). No frames come until the source is started again.
+  void setNotify(std::shared_ptr<Message> notify);
+
+  enum {
+    // notify
+    kWhatCaptureError = 'cerr',
   };
+
+  // pixel formats offered by the device which frames can be built from
+  std::vector<VideoFrameBuffer::PixelFormat> supportedPixelFormats() const;
+
+  // negotiated format, valid after start()
+  int32_t width() const { return mWidth; }
+  int32_t height() const { return mHeight; }
+  uint32_t fourcc() const { return mColorFormat; }
+
+  // when the frame being delivered was dequeued, only meaningful inside
+  // OnFrame() which runs on the capture thread
+  int64_t last_dequeue_time_us() const { return last_dequeue_time_us_; }
+
+  // frames dropped because every driver buffer was still held downstream
+  uint64_t frame_dropped() const { return frame_dropped_; }
+
+  // frames the driver dropped, counted from gaps in the buffer sequence
+  uint64_t frame_lost() const { return frame_lost_; }
+
+ private:
+  // Owns the mmap'd driver buffers, shared with every frame that borrows one.
+  class BufferQueue;
+
   int doIoctl(int request, void* argp);
   bool mapAndQueueBuffer(int index);
   bool startStream();
   bool stopStream();
 
-  std::unique_ptr<base::TaskRunnerFactory> task_runner_factory_;
-  std::unique_ptr<base::TaskRunner> task_runner_;
-  base::RepeatingTaskHandle repeating_task_handler_;
+  // dequeue one filled buffer, only call when the fd is readable
+  status_t dequeueFrame(std::shared_ptr<VideoFrame>& frame);
+
+  // capture time of `buffer` in the pipeline clock
+  int64_t captureTimeUs(const v4l2_buffer& buffer);
+
+  bool startCaptureThread();
+  void stopCaptureThread();
+  // one epoll wait on the capture thread, returns false to end the thread,
+  // with capture_status_ set if not ended by stop()
+  bool captureProcess();
+  void notifyCaptureError(status_t err);
+
+  struct StartParams {
+    int32_t width;
+    int32_t height;
+    int32_t color_format;
+    int32_t framerate;
+  };
+
+  // capture thread, woken by the driver through epoll as soon as a buffer is
+  // filled and by wakeup_fd_ on stop.
+  std::unique_ptr<base::Thread> capture_thread_;
+  int epoll_fd_;
+  int wakeup_fd_;
+  std::atomic<bool> capturing_;
+  int capture_timeout_ms_;
+  const int32_t continuous_timeout_limit_;
+  int32_t continuous_timeouts_;
+  // why captureProcess() ended the thread, only touched on it
+  status_t capture_status_;
+  std::optional<StartParams> start_params_;
+
+  Mutex notify_lock_;
+  std::shared_ptr<Message> notify_ GUARDED_BY(notify_lock_);
+
+  // number of buffers requested from the driver
+  const uint32_t buffer_count_;
+  // export capture buffers as dma-buf fds with VIDIOC_EXPBUF
+  const bool export_dmabuf_;
+  // V4L2_BUF_TYPE_VIDEO_CAPTURE, or _MPLANE for multi-planar only devices
+  v4l2_buf_type buf_type_;
+
+  // sinks are added from any thread and called on the capture thread
+  Mutex sink_lock_;
 
   int mFd;
   v4l2_capability mV4L2Capability;
@@ -67,12 +155,23 @@ class V4L2VideoSource : public VideoSourceBase<std::shared_ptr<VideoFrame>> {
   int32_t mWidth;
   int32_t mHeight;
   int32_t mColorFormat;
-  std::vector<V4L2Buffer> mBuffers;
+  std::shared_ptr<BufferQueue> buffer_queue_;
+  // the queue of the last stream, alive while its frames are
+  std::weak_ptr<BufferQueue> retired_buffer_queue_;
+#if defined(OC_MJPEG)
+  // only while capturing mjpeg
+  std::unique_ptr<JpegDecoderPool> jpeg_decoder_pool_;
+#endif
   uint64_t frame_count_;
+  // written by the capture thread, read by anyone through the getters
+  std::atomic<uint64_t> frame_dropped_;
+  std::atomic<uint64_t> frame_lost_;
+  int64_t last_dequeue_time_us_;
+  std::optional<uint32_t> last_sequence_;
+  // pipeline clock minus CLOCK_MONOTONIC, sampled when streaming starts
+  int64_t clock_offset_us_;
 };
 
-// std::unique_ptr<VideoSourceFactory> CreateV4l2VideoSourceFactory();
-
 }  // namespace ave
 
 #endif /* !V4L2_VIDEO_SOURCE_H */
@@ -7,8 +7,11 @@
 
 #include "video_capturer.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <filesystem>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -25,6 +28,95 @@
 
 namespace ave {
 
+namespace {
+// frames a processor may hold before their sink choice is forgotten
+constexpr size_t kMaxProcessingFrames = 16;
+
+using FrameSize = std::pair<size_t, size_t>;
+
+// The size a sink with `wants` should get a width x height frame at, the
+// aspect ratio is kept and frames are never scaled up.
+FrameSize AdaptFrameSize(const VideoSinkWants& wants,
+                         size_t width,
+                         size_t height) {
+  int64_t max_pixels = wants.max_pixel_count;
+  if (wants.target_pixel_count) {
+    max_pixels = std::min<int64_t>(max_pixels, *wants.target_pixel_count);
+  }
+  // no need to be larger than what the sink is configured to consume
+  int64_t max_resolution_pixels = 0;
+  for (const auto& resolution : wants.resolutions) {
+    max_resolution_pixels = std::max<int64_t>(
+        max_resolution_pixels,
+        static_cast<int64_t>(resolution.width) * resolution.height);
+  }
+  if (max_resolution_pixels > 0) {
+    max_pixels = std::min(max_pixels, max_resolution_pixels);
+  }
+
+  const size_t alignment = std::max(1, wants.resolution_alignment);
+  const int64_t pixels = static_cast<int64_t>(width) * height;
+  if (pixels <= max_pixels && width % alignment == 0 &&
+      height % alignment == 0) {
+    return {width, height};
+  }
+
+  // a configured resolution of the frame's aspect ratio is taken as is, so a
+  // 1080p -> 720p tier does not lose a pixel column to rounding
+  FrameSize configured_size(0, 0);
+  for (const auto& resolution : wants.resolutions) {
+    const size_t res_width = static_cast<size_t>(std::max(resolution.width, 0));
+    const size_t res_height =
+        static_cast<size_t>(std::max(resolution.height, 0));
+    if (res_width == 0 || res_height == 0 || res_width > width ||
+        res_width % alignment != 0 || res_height % alignment != 0 ||
+        static_cast<int64_t>(res_width) * res_height > max_pixels ||
+        res_width * height != res_height * width) {
+      continue;
+    }
+    if (res_width > configured_size.first) {
+      configured_size = {res_width, res_height};
+    }
+  }
+  if (configured_size.first > 0) {
+    return configured_size;
+  }
+
+  const double scale =
+      pixels > max_pixels
+          ? std::sqrt(static_cast<double>(std::max<int64_t>(max_pixels, 1)) /
+                      pixels)
+          : 1.0;
+  const size_t scaled_width = static_cast<size_t>(width * scale);
+  const size_t scaled_height = static_cast<size_t>(height * scale);
+  return {std::max(scaled_width / alignment * alignment, alignment),
+          std::max(scaled_height / alignment * alignment, alignment)};
+}
+
+std::shared_ptr<VideoFrame> ScaleFrame(const std::shared_ptr<VideoFrame>& frame,
+                                       const FrameSize& size) {
+  const size_t width = frame->width();
+  const size_t height = frame->height();
+  auto scaled = std::make_shared<VideoFrame>(*frame);
+  // the scaled copy feeds another stream, it stamps its own stages
+  scaled->set_metadata(frame->metadata()->Fork());
+  scaled->set_video_frame_buffer(frame->video_frame_buffer()->CropAndScale(
+      0, 0, width, height, size.first, size.second));
+
+  // keep the crop rect on the same content
+  const VideoFrame::Rect rect = *frame->rect();
+  if (rect != VideoFrame::Rect{0, 0, width, height}) {
+    std::optional<VideoFrame::Rect> scaled_rect = VideoFrame::Rect{
+        rect.offset_x * size.first / width,
+        rect.offset_y * size.second / height,
+        rect.width * size.first / width, rect.height * size.second / height};
+    scaled->set_rect(scaled_rect);
+  }
+  return scaled;
+}
+
+}  // namespace
+
 VideoCapturer::VideoCapturer(std::shared_ptr<Message> capture_info)
     : capture_info_(std::move(capture_info)),
       task_runner_factory_(base::CreateDefaultTaskRunnerFactory()),
@@ -35,7 +127,8 @@ VideoCapturer::VideoCapturer(std::shared_ptr<Message> capture_info)
       video_source_(nullptr),
       video_processor_(nullptr),
       frame_received_(0),
-      frame_sent_(0) {
+      frame_sent_(0),
+      frame_dropped_(0) {
   // ctor
 }
 
@@ -44,6 +137,81 @@ VideoCapturer::~VideoCapturer() {}
 void VideoCapturer::AddOrUpdateSinkInternal(VideoSink* sink,
                                             const VideoSinkWants& wants) {
   sinks_broadcaster_.AddOrUpdateSink(sink, wants);
+  auto it = sink_framerate_controllers_.find(sink);
+  if (it == sink_framerate_controllers_.end()) {
+    sink_framerate_controllers_.emplace(
+        sink, FramerateController(wants.max_framerate_fps));
+  } else {
+    it->second.SetMaxFramerate(wants.max_framerate_fps);
+  }
+}
+
+void VideoCapturer::RemoveSinkInternal(VideoSink* sink) {
+  sinks_broadcaster_.RemoveSink(sink);
+  sink_framerate_controllers_.erase(sink);
+}
+
+std::vector<VideoCapturer::VideoSink*> VideoCapturer::SinksWantingFrame(
+    const std::shared_ptr<VideoFrame>& frame) {
+  std::vector<VideoSink*> sinks;
+  for (auto& sink : sinks_broadcaster_.sink_pairs()) {
+    auto it = sink_framerate_controllers_.find(sink.sink);
+    if (it != sink_framerate_controllers_.end() &&
+        it->second.ShouldDropFrame(frame->timestamp_us())) {
+      continue;
+    }
+    sinks.push_back(sink.sink);
+  }
+  return sinks;
+}
+
+std::shared_ptr<VideoFrame> VideoCapturer::ApplyDigitalPTZ(
+    const std::shared_ptr<VideoFrame>& frame) {
+  const size_t width = frame->width();
+  const size_t height = frame->height();
+  auto rect = digital_ptz_->Advance(frame->timestamp_us(), width, height);
+  if (!rect) {
+    return frame;
+  }
+  // one scaled buffer from the pool, the sinks keep seeing the frame size
+  auto cropped = std::make_shared<VideoFrame>(*frame);
+  cropped->set_metadata(frame->metadata()->Fork());
+  cropped->set_video_frame_buffer(frame->video_frame_buffer()->CropAndScale(
+      rect->offset_x, rect->offset_y, rect->width, rect->height, width,
+      height));
+  return cropped;
+}
+
+void VideoCapturer::DeliverFrame(const std::shared_ptr<VideoFrame>& input,
+                                 const std::vector<VideoSink*>& sinks) {
+  frame_sent_++;
+  const std::shared_ptr<VideoFrame> frame =
+      digital_ptz_ ? ApplyDigitalPTZ(input) : input;
+  const int64_t deliver_us = Looper::getNowUs();
+  frame->metadata()->SetStageTime(FrameMetadata::Stage::kDeliver, deliver_us);
+  // scaled once per size, sinks wanting the same size share the frame
+  std::map<FrameSize, std::shared_ptr<VideoFrame>> scaled_frames;
+  for (auto* sink : sinks) {
+    // the sink may have been removed while the frame was processed
+    auto* sink_pair = sinks_broadcaster_.FindSinkPair(sink);
+    if (sink_pair == nullptr) {
+      continue;
+    }
+
+    const FrameSize size =
+        AdaptFrameSize(sink_pair->wants, frame->width(), frame->height());
+    if (size == FrameSize(frame->width(), frame->height())) {
+      sink->OnFrame(frame);
+      continue;
+    }
+    auto& scaled_frame = scaled_frames[size];
+    if (scaled_frame == nullptr) {
+      scaled_frame = ScaleFrame(frame, size);
+      scaled_frame->metadata()->SetStageTime(FrameMetadata::Stage::kDeliver,
+                                             deliver_us);
+    }
+    sink->OnFrame(scaled_frame);
+  }
 }
 
 void VideoCapturer::AddOrUpdateSink(VideoSink* sink,
@@ -53,39 +221,50 @@ void VideoCapturer::AddOrUpdateSink(VideoSink* sink,
 }
 
 void VideoCapturer::RemoveSink(VideoSink* sink) {
-  task_runner_->PostTask(
-      [this, sink]() { sinks_broadcaster_.RemoveSink(sink); });
+  task_runner_->PostTask([this, sink]() { RemoveSinkInternal(sink); });
 }
 
 void VideoCapturer::OnFrame(const std::shared_ptr<VideoFrame>& frame) {
   task_runner_->PostTask([this, frame]() {
     frame_received_++;
-    // TODO(youfa) frame rate control
-    // if (drop) {
-    //   return;
-    // }
+    if (sinks_broadcaster_.sink_pairs().empty()) {
+      return;
+    }
+
+    // drop before any processing if no sink wants it at its framerate
+    std::vector<VideoSink*> sinks = SinksWantingFrame(frame);
+    if (sinks.empty()) {
+      frame_dropped_++;
+      return;
+    }
 
     if (video_processor_ != nullptr) {
+      if (processing_frames_.size() >= kMaxProcessingFrames) {
+        processing_frames_.erase(processing_frames_.begin());
+      }
+      processing_frames_[frame->id()] = std::move(sinks);
       // after process, processor will call OnProcessedFrame
       video_processor_->OnFrame(frame);
     } else {
-      if (sinks_broadcaster_.sink_pairs().empty()) {
-        return;
-      }
-      frame_sent_++;
-      for (auto& sink : sinks_broadcaster_.sink_pairs()) {
-        sink.sink->OnFrame(frame);
-      }
+      DeliverFrame(frame, sinks);
     }
   });
 }
 
 void VideoCapturer::OnProcessedFrame(std::shared_ptr<VideoFrame>& frame) {
   task_runner_->PostTask([this, frame]() {
-    frame_sent_++;
-    for (auto& sink : sinks_broadcaster_.sink_pairs()) {
-      sink.sink->OnFrame(frame);
+    auto it = processing_frames_.find(frame->id());
+    if (it == processing_frames_.end()) {
+      // a frame made up by the processor, every sink gets it
+      std::vector<VideoSink*> sinks;
+      for (auto& sink : sinks_broadcaster_.sink_pairs()) {
+        sinks.push_back(sink.sink);
+      }
+      DeliverFrame(frame, sinks);
+      return;
     }
+    DeliverFrame(frame, it->second);
+    processing_frames_.erase(it);
   });
 }
 
@@ -116,4 +295,10 @@ status_t VideoCapturer::SetProcessor(
   return OK;
 }
 
+void VideoCapturer::SetDigitalPTZ(std::shared_ptr<DigitalPTZ> digital_ptz) {
+  task_runner_->PostTask([this, digital_ptz = std::move(digital_ptz)]() {
+    digital_ptz_ = digital_ptz;
+  });
+}
+
 }  // namespace ave
@@ -8,9 +8,12 @@
 #ifndef VIDEO_CAPTURER_H
 #define VIDEO_CAPTURER_H
 
+#include <atomic>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "api/video/video_frame.h"
 #include "api/video/video_processor_interface.h"
@@ -21,6 +24,8 @@
 #include "base/task_util/task_runner_factory.h"
 #include "base/types.h"
 #include "common/message.h"
+#include "media/video/digital_ptz.h"
+#include "media/video/framerate_controller.h"
 #include "media/video/video_source_base.h"
 
 namespace ave {
@@ -53,12 +58,26 @@ class VideoCapturer : public VideoSinkInterface<std::shared_ptr<VideoFrame>>,
   // processor
   status_t SetProcessor(std::shared_ptr<VideoProcessor>& processor);
 
+  // crops every frame to the window of `digital_ptz` and scales it back to
+  // the frame size before the sinks get it, nullptr turns it off
+  void SetDigitalPTZ(std::shared_ptr<DigitalPTZ> digital_ptz);
+
   uint64_t frame_received() const { return frame_received_; }
   uint64_t frame_sent() const { return frame_sent_; }
+  // frames no sink wanted at its max_framerate_fps, dropped before processing
+  uint64_t frame_dropped() const { return frame_dropped_; }
 
  private:
   // with lock
   void AddOrUpdateSinkInternal(VideoSink* sink, const VideoSinkWants& wants);
+  void RemoveSinkInternal(VideoSink* sink);
+  // the sinks whose max_framerate_fps `frame` fits
+  std::vector<VideoSink*> SinksWantingFrame(
+      const std::shared_ptr<VideoFrame>& frame);
+  void DeliverFrame(const std::shared_ptr<VideoFrame>& frame,
+                    const std::vector<VideoSink*>& sinks);
+  std::shared_ptr<VideoFrame> ApplyDigitalPTZ(
+      const std::shared_ptr<VideoFrame>& frame);
 
   std::shared_ptr<Message> capture_info_;
 
@@ -72,11 +91,21 @@ class VideoCapturer : public VideoSinkInterface<std::shared_ptr<VideoFrame>>,
   // std::shared_ptr<VideoProcessor> video_processor_;
   std::shared_ptr<VideoProcessor> video_processor_;
 
+  std::shared_ptr<DigitalPTZ> digital_ptz_;
+
   // sinks broadcaster
   VideoSourceBase<std::shared_ptr<VideoFrame>> sinks_broadcaster_;
 
-  uint64_t frame_received_;
-  uint64_t frame_sent_;
+  // each sink gets frames at its own max_framerate_fps, frames no sink wants
+  // are dropped before they are processed
+  std::map<VideoSink*, FramerateController> sink_framerate_controllers_;
+  // sinks chosen for frames in the processor, by frame id
+  std::map<uint64_t, std::vector<VideoSink*>> processing_frames_;
+
+  // counted on task_runner_, read by anyone through the getters
+  std::atomic<uint64_t> frame_received_;
+  std::atomic<uint64_t> frame_sent_;
+  std::atomic<uint64_t> frame_dropped_;
 };
 
 }  // namespace ave
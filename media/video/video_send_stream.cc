@@ -51,6 +51,17 @@ void VideoSendStream::RequestKeyFrame() {
   task_runner_->PostTask([this]() { video_stream_encoder_->SendKeyFrame(); });
 }
 
+void VideoSendStream::SetRates(uint32_t bitrate_bps, double framerate_fps) {
+  // posted to the encoder thread by the encoder, not behind the tasks of
+  // task_runner_
+  video_stream_encoder_->SetRates(
+      VideoEncoder::RateControlParameters(bitrate_bps, framerate_fps));
+}
+
+VideoStreamEncoderInterface::Stats VideoSendStream::GetStats() const {
+  return video_stream_encoder_->GetStats();
+}
+
 EncodedImageCallback::Result VideoSendStream::OnEncodedImage(
     const EncodedImage& encoded_image) {
   video_stream_sender_->OnEncodedImage(encoded_image);
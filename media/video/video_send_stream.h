@@ -40,6 +40,13 @@ class VideoSendStream : public MediaStream,
 
   void RequestKeyFrame();
 
+  // adapts the encoder to the transport, e.g. on congestion, takes effect
+  // from the next encoded frame
+  void SetRates(uint32_t bitrate_bps, double framerate_fps);
+
+  // queue depth, drops and encode time of this stream
+  VideoStreamEncoderInterface::Stats GetStats() const;
+
   // VideoStreamEncoderInterface::EncoderSink implementation.
   Result OnEncodedImage(const EncodedImage& encoded_image) override;
 
@@ -7,10 +7,13 @@
 
 #include "video_stream_encoder.h"
 
+#include <algorithm>
+
 #include "api/video/encoded_image.h"
 #include "base/logging.h"
 #include "base/sequence_checker.h"
 #include "base/task_util/task_runner_base.h"
+#include "common/looper.h"
 #include "common/video_codec_property.h"
 #include "media/video/video_stream_helper.h"
 
@@ -19,7 +22,8 @@ namespace ave {
 VideoStreamEncoder::VideoStreamEncoder(
     base::TaskRunnerFactory* task_runner_factory,
     VideoEncoderFactory* encoder_factory,
-    EncodedImageCallback* sink)
+    EncodedImageCallback* sink,
+    size_t max_queue_depth)
     : task_runner_factory_(task_runner_factory),
       encoder_factory_(encoder_factory),
       sink_(sink),
@@ -27,6 +31,10 @@ VideoStreamEncoder::VideoStreamEncoder(
       pending_encoder_reconfiguration_(false),
       pending_encoder_creation_(false),
       max_data_payload_length_(0),
+      max_queue_depth_(std::max<size_t>(max_queue_depth, 1)),
+      encode_posted_(false),
+      unreported_drops_(0),
+      total_encode_time_us_(0),
       encoder_runner_(task_runner_factory_->CreateTaskRunner(
           "VideoStreamEncoder",
           base::TaskRunnerFactory::Priority::NORMAL)) {
@@ -46,6 +54,17 @@ void VideoStreamEncoder::SetSink(EncoderSink* sink) {}
 
 void VideoStreamEncoder::SetStartBitrate(int start_bitrate_bps) {}
 
+void VideoStreamEncoder::SetRates(
+    const VideoEncoder::RateControlParameters& parameters) {
+  encoder_runner_.PostTask([this, parameters]() {
+    AVE_DCHECK_RUN_ON(&encoder_runner_);
+    rates_ = parameters;
+    if (encoder_ && encoder_initialized_) {
+      encoder_->SetRates(parameters);
+    }
+  });
+}
+
 void VideoStreamEncoder::SendKeyFrame() {
   encoder_runner_.PostTask([this]() {
     AVE_DCHECK_RUN_ON(&encoder_runner_);
@@ -78,22 +97,100 @@ void VideoStreamEncoder::ConfigureEncoder(VideoEncoderConfig config,
 }
 
 void VideoStreamEncoder::OnFrame(const std::shared_ptr<VideoFrame>& frame) {
-  encoder_runner_.PostTask([this, frame]() {
-    // AVE_LOG(LS_INFO) << "VideoStreamEncoder::OnFrame";
+  // a slow encoder must not pile up frames, memory and latency, only the
+  // newest max_queue_depth_ frames wait for it
+  lock_guard l(&queue_lock_);
+  stats_.frames_received++;
+  frame_queue_.push_back(frame);
+  while (frame_queue_.size() > max_queue_depth_) {
+    frame_queue_.pop_front();
+    stats_.frames_dropped++;
+    unreported_drops_++;
+  }
+  stats_.max_queue_depth =
+      std::max(stats_.max_queue_depth, frame_queue_.size());
+  if (!encode_posted_) {
+    encode_posted_ = true;
+    encoder_runner_.PostTask([this]() { EncodeNextFrame(); });
+  }
+}
+
+void VideoStreamEncoder::EncodeNextFrame() {
+  AVE_DCHECK_RUN_ON(&encoder_runner_);
+  std::shared_ptr<VideoFrame> frame;
+  size_t drops = 0;
+  {
+    lock_guard l(&queue_lock_);
+    // the newest frame is encoded, the older ones waiting are stale
+    if (!frame_queue_.empty()) {
+      frame = std::move(frame_queue_.back());
+      const size_t stale = frame_queue_.size() - 1;
+      frame_queue_.clear();
+      stats_.frames_dropped += stale;
+      unreported_drops_ += stale;
+    }
+    std::swap(drops, unreported_drops_);
+  }
+
+  for (size_t i = 0; i < drops; i++) {
+    sink_->OnDroppedFrame(
+        EncodedImageCallback::DropReason::kDroppedByMediaOptimizations);
+  }
+
+  if (frame) {
+    const int64_t start_us = Looper::getNowUs();
     MaybeEncodeVideoFrame(frame);
-  });
+    const int64_t encode_time_us = Looper::getNowUs() - start_us;
+
+    lock_guard l(&queue_lock_);
+    stats_.frames_encoded++;
+    stats_.last_encode_time_us = encode_time_us;
+    stats_.max_encode_time_us =
+        std::max(stats_.max_encode_time_us, encode_time_us);
+    total_encode_time_us_ += encode_time_us;
+  }
+
+  // frames which came in meanwhile get a task of their own, so key frame
+  // requests and reconfigurations are not starved
+  lock_guard l(&queue_lock_);
+  if (frame_queue_.empty() && unreported_drops_ == 0) {
+    encode_posted_ = false;
+  } else {
+    encoder_runner_.PostTask([this]() { EncodeNextFrame(); });
+  }
+}
+
+VideoStreamEncoderInterface::Stats VideoStreamEncoder::GetStats() const {
+  lock_guard l(&queue_lock_);
+  Stats stats = stats_;
+  stats.queue_depth = frame_queue_.size();
+  if (stats.frames_encoded > 0) {
+    stats.avg_encode_time_us =
+        total_encode_time_us_ / static_cast<int64_t>(stats.frames_encoded);
+  }
+  return stats;
 }
 
 void VideoStreamEncoder::MaybeEncodeVideoFrame(
     const std::shared_ptr<VideoFrame>& frame) {
   AVE_DCHECK_RUN_ON(&encoder_runner_);
 
+  // the encoder crops in place, so it is configured with the crop size
+  const VideoFrame::Rect rect = frame->aligned_rect();
   // check if encoder need reconfigure
-  if (!last_frame_info_ || last_frame_info_->width != frame->width() ||
-      last_frame_info_->height != frame->height() ||
+  if (!last_frame_info_ || last_frame_info_->width != rect.width ||
+      last_frame_info_->height != rect.height ||
       last_frame_info_->type != frame->video_frame_buffer()->type()) {
     pending_encoder_reconfiguration_ = true;
-    last_frame_info_ = VideoFrameInfo(frame->width(), frame->height(),
+    // the encoder is initialized for one size, a new crop size needs a new
+    // one. The new encoder starts with an idr frame, so every change of the
+    // frame's crop rect size, or of the source resolution, costs a key
+    // frame. Digital ptz doesn't, it scales its crop back to the frame size.
+    if (last_frame_info_ && (last_frame_info_->width != rect.width ||
+                             last_frame_info_->height != rect.height)) {
+      pending_encoder_creation_ = true;
+    }
+    last_frame_info_ = VideoFrameInfo(rect.width, rect.height,
                                       frame->video_frame_buffer()->type());
     AVE_LOG(LS_INFO) << "video frame info changed, "
                      << VideoFrameBuffer::TypeToString(
@@ -149,14 +246,18 @@ void VideoStreamEncoder::ReConfigureEncoder() {
   }
 
   if (encoder_reset_required) {
-    if (encoder_->InitEncoder(
-            codec_property, VideoEncoder::Settings(
-                                VideoEncoder::Capabilities(false), 0, 10000)) !=
-        OK) {
+    VideoEncoder::Settings settings(VideoEncoder::Capabilities(false),
+                                    VideoEncoder::DetectNumberOfCores(),
+                                    10000);
+    settings.rate_control_mode = encoder_config_.rate_control_mode;
+    if (encoder_->InitEncoder(codec_property, settings) != OK) {
       ReleaseEncoder();
     } else {
       encoder_initialized_ = true;
       encoder_->RegisterEncoderCompleteCallback(sink_);
+      if (rates_) {
+        encoder_->SetRates(*rates_);
+      }
     }
   }
 
@@ -8,11 +8,14 @@
 #ifndef VIDEO_STREAM_ENCODER_H
 #define VIDEO_STREAM_ENCODER_H
 
+#include <deque>
+
 #include "api/video/encoded_image.h"
 #include "api/video/video_stream_encoder_interface.h"
 #include "api/video_codecs/video_encoder.h"
 #include "api/video_codecs/video_encoder_factory.h"
 #include "base/constructor_magic.h"
+#include "base/mutex.h"
 #include "base/sequence_checker.h"
 #include "base/task_util/task_runner.h"
 #include "base/task_util/task_runner_factory.h"
@@ -21,9 +24,14 @@
 namespace ave {
 class VideoStreamEncoder : public VideoStreamEncoderInterface {
  public:
+  // frames held while the encoder is busy, the oldest is dropped beyond it.
+  // Only the newest is encoded once it is free.
+  static constexpr size_t kDefaultMaxQueueDepth = 1;
+
   VideoStreamEncoder(base::TaskRunnerFactory* task_runner_factory,
                      VideoEncoderFactory* encoder_factory,
-                     EncodedImageCallback* sink);
+                     EncodedImageCallback* sink,
+                     size_t max_queue_depth = kDefaultMaxQueueDepth);
   ~VideoStreamEncoder() override;
 
   // VideoStreamEncoderInterface implementation.
@@ -34,6 +42,8 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface {
 
   void SetStartBitrate(int start_bitrate_bps) override;
 
+  void SetRates(const VideoEncoder::RateControlParameters& parameters) override;
+
   void SendKeyFrame() override;
 
   void ConfigureEncoder(VideoEncoderConfig config,
@@ -42,6 +52,8 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface {
   // VideoSinkInterface implementation.
   void OnFrame(const std::shared_ptr<VideoFrame>& frame) override;
 
+  Stats GetStats() const override;
+
   void Stop() override;
 
  private:
@@ -55,6 +67,9 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface {
     size_t pixel_count() const { return width * height; }
   };
 
+  // encodes the newest queued frame, drops the older ones, and reposts
+  // itself while frames wait
+  void EncodeNextFrame() AVE_RUN_ON(&encoder_runner_);
   void MaybeEncodeVideoFrame(const std::shared_ptr<VideoFrame>& frame);
   void EncodeVideoFrame(const std::shared_ptr<VideoFrame>& frame);
 
@@ -82,6 +97,21 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface {
 
   size_t max_data_payload_length_ GUARDED_BY(&encoder_runner_);
 
+  const size_t max_queue_depth_;
+  mutable Mutex queue_lock_;
+  // newest last, frames arrive on the capture thread
+  std::deque<std::shared_ptr<VideoFrame>> frame_queue_ GUARDED_BY(queue_lock_);
+  // an EncodeNextFrame() is posted
+  bool encode_posted_ GUARDED_BY(queue_lock_);
+  // drops not reported to sink_ yet
+  size_t unreported_drops_ GUARDED_BY(queue_lock_);
+  int64_t total_encode_time_us_ GUARDED_BY(queue_lock_);
+  Stats stats_ GUARDED_BY(queue_lock_);
+
+  // last SetRates(), reapplied to a new encoder
+  std::optional<VideoEncoder::RateControlParameters> rates_
+      GUARDED_BY(&encoder_runner_);
+
   base::TaskRunner encoder_runner_;
 
   AVE_DISALLOW_COPY_AND_ASSIGN(VideoStreamEncoder);
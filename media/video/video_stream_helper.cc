@@ -7,6 +7,8 @@
 
 #include "video_stream_helper.h"
 
+#include <algorithm>
+
 #include "api/video_codecs/video_encoder.h"
 #include "base/checks.h"
 #include "base/logging.h"
@@ -59,12 +61,19 @@ std::vector<VideoStreamConfig> CreateDefaultVideoStreamConfig(
   stream_config.width = width;
   stream_config.height = height;
 
-  // TODO(youfa) frame rate and qp
-  // stream_config.max_framerate =
+  // TODO(youfa) qp
   // stream_config.qp_max = 56;
+  stream_config.max_framerate = video_encoder_config.max_framerate > 0
+                                    ? video_encoder_config.max_framerate
+                                    : kDefaultVideoMaxFramerate;
 
   stream_config.min_bitrate_kbps = std::min(min_bitrate_kbps, max_bitrate_kbps);
-  stream_config.target_bitrate_kbps = max_bitrate_kbps;
+  stream_config.target_bitrate_kbps =
+      video_encoder_config.target_bitrate_kbps > 0
+          ? std::clamp<int32_t>(video_encoder_config.target_bitrate_kbps,
+                                stream_config.min_bitrate_kbps,
+                                max_bitrate_kbps)
+          : max_bitrate_kbps;
   stream_config.max_bitrate_kbps = max_bitrate_kbps;
 
   video_stream_configs.push_back(stream_config);
@@ -97,7 +106,8 @@ bool SetupVideoCodecProperity(
   codec_properity->bit_rate_range.min =
       std::max(stream_configs[0].min_bitrate_kbps, kEncoderMinBitrateKbps);
 
-  int max_framerate = kDefaultVideoMaxFramerate;
+  int max_framerate = 0;
+  uint32_t target_bitrate = 0;
 
   for (size_t i = 0; i < stream_configs.size(); i++) {
     codec_properity->width =
@@ -108,6 +118,7 @@ bool SetupVideoCodecProperity(
         std::max(codec_properity->bit_rate_range.min,
                  stream_configs[i].min_bitrate_kbps);
     codec_properity->bit_rate_range.max += stream_configs[i].max_bitrate_kbps;
+    target_bitrate += stream_configs[i].target_bitrate_kbps;
     codec_properity->qp_range.max =
         std::max(codec_properity->qp_range.max, stream_configs[i].max_qp);
     max_framerate = std::max(max_framerate, stream_configs[i].max_framerate);
@@ -121,10 +132,16 @@ bool SetupVideoCodecProperity(
   codec_properity->bit_rate_range.max =
       std::max(codec_properity->bit_rate_range.max, kEncoderMinBitrateKbps);
 
-  codec_properity->bit_rate = codec_properity->bit_rate_range.max;
+  codec_properity->bit_rate =
+      target_bitrate > 0
+          ? std::clamp<uint32_t>(target_bitrate,
+                                 codec_properity->bit_rate_range.min,
+                                 codec_properity->bit_rate_range.max)
+          : codec_properity->bit_rate_range.max;
   AVE_LOG(LS_INFO) << "bitrate:" << codec_properity->bit_rate;
 
-  codec_properity->frame_rate = max_framerate;
+  codec_properity->frame_rate =
+      max_framerate > 0 ? max_framerate : kDefaultVideoMaxFramerate;
 
   switch (codec_properity->codec_id) {
     case CodecId::AV_CODEC_ID_H264: {
@@ -8,11 +8,13 @@
 #include "openh264_encoder.h"
 #include <algorithm>
 #include <memory>
+#include "api/video/dmabuf_frame_buffer.h"
 #include "api/video/encoded_image.h"
 #include "api/video/video_frame_type.h"
 #include "base/checks.h"
 #include "base/errors.h"
 #include "base/logging.h"
+#include "common/looper.h"
 #include "common/video_codec_property.h"
 #include "third_party/openh264/src/codec/api/svc/codec_api.h"
 #include "third_party/openh264/src/codec/api/svc/codec_app_def.h"
@@ -22,6 +24,8 @@
 namespace ave {
 
 namespace {
+constexpr int64_t kPoolStatsIntervalUs = 10 * 1000 * 1000;
+
 VideoFrameType ConvertToVideoFrameType(EVideoFrameType type) {
   switch (type) {
     case videoFrameTypeIDR:
@@ -37,6 +41,32 @@ VideoFrameType ConvertToVideoFrameType(EVideoFrameType type) {
   return VideoFrameType::kEmptyFrame;
 }
 
+// Threads for a width x height stream, openh264 encodes one slice per
+// thread. Small frames don't have enough macroblock rows to split well.
+int NumberOfThreads(int width, int height, int number_of_cores) {
+  int max_threads = 1;
+  if (width * height >= 1920 * 1080) {
+    max_threads = 4;
+  } else if (width * height >= 1280 * 720) {
+    max_threads = 3;
+  } else if (width * height >= 640 * 360) {
+    max_threads = 2;
+  }
+  return std::clamp(number_of_cores, 1, max_threads);
+}
+
+RC_MODES ConvertToRCMode(RateControlMode mode) {
+  switch (mode) {
+    case RateControlMode::kBitrate:
+      return RC_BITRATE_MODE;
+    case RateControlMode::kQuality:
+      return RC_QUALITY_MODE;
+    case RateControlMode::kBufferBased:
+      return RC_BUFFERBASED_MODE;
+  }
+  return RC_BITRATE_MODE;
+}
+
 }  // namespace
 
 OpenH264Encoder::OpenH264Encoder()
@@ -46,6 +76,8 @@ OpenH264Encoder::OpenH264Encoder()
       encoder_(nullptr),
       picture_(SSourcePicture()),
       configuration_(LayerConfig()),
+      pool_stats_time_us_(0),
+      pool_stats_allocations_(0),
       encoded_image_callback_(nullptr) {}
 
 OpenH264Encoder::~OpenH264Encoder() {
@@ -89,8 +121,11 @@ status_t OpenH264Encoder::InitEncoder(const VideoCodecProperty& codec_property,
   configuration_.height = codec_property.height;
   configuration_.sending = false;
   configuration_.max_frame_rate = static_cast<float>(codec_property.frame_rate);
-  configuration_.max_bps = codec_property.bit_rate_range.max;
-  configuration_.target_bps = codec_property.bit_rate;
+  // the codec property is in kbps
+  configuration_.min_bps = codec_property.bit_rate_range.min * 1000;
+  configuration_.max_bps = codec_property.bit_rate_range.max * 1000;
+  configuration_.target_bps = codec_property.bit_rate * 1000;
+  configuration_.rate_control_mode = encoder_settings.rate_control_mode;
   configuration_.frame_dropping_on = codec_property.H264().frame_dropping_on;
   configuration_.key_frame_interval = codec_property.H264().key_frame_interval;
   configuration_.num_temporal_layers =
@@ -105,12 +140,8 @@ status_t OpenH264Encoder::InitEncoder(const VideoCodecProperty& codec_property,
     return UNKNOWN_ERROR;
   }
 
-  // TODO(youfa): Base init params on these values before submitting.
-  int video_format = EVideoFormatType::videoFormatI420;
-  encoder->SetOption(ENCODER_OPTION_DATAFORMAT, &video_format);
-
-  // TODO(youfa) remove shared ptr of EncodedImage
-  encoded_image_.SetEncodedData(EncodedImageBuffer::Create());
+  // the buffer comes from buffer_pool_ per frame
+  encoded_image_.ClearEncodedData();
   encoded_image_.encoded_width_ = codec_property.width;
   encoded_image_.encoded_height_ = codec_property.height;
   encoded_image_.SetSize(0);
@@ -121,6 +152,14 @@ status_t OpenH264Encoder::InitEncoder(const VideoCodecProperty& codec_property,
 }
 
 status_t OpenH264Encoder::Release() {
+  if (encoder_ != nullptr) {
+    // stops and joins the encoder threads
+    encoder_->Uninitialize();
+    WelsDestroySVCEncoder(encoder_);
+    encoder_ = nullptr;
+  }
+  encoded_image_.ClearEncodedData();
+  configuration_.sending = false;
   return OK;
 }
 
@@ -137,15 +176,31 @@ status_t OpenH264Encoder::Encode(const std::shared_ptr<VideoFrame>& frame) {
   if (encoded_image_callback_ == nullptr) {
     return NO_INIT;
   }
-  auto frame_buffer = frame->video_frame_buffer()->ToI420();
+  // paused by a zero bitrate
+  if (!configuration_.sending) {
+    return OK;
+  }
+  const std::shared_ptr<FrameMetadata>& metadata = frame->metadata();
+  metadata->SetStageTime(FrameMetadata::Stage::kEncodeStart,
+                         Looper::getNowUs());
 
-  if (!frame_buffer) {
+  std::shared_ptr<VideoFrameBuffer> buffer = frame->video_frame_buffer();
+  if (buffer->type() == VideoFrameBuffer::Type::kDmaBuf) {
+    buffer = static_cast<DmaBufFrameBuffer*>(buffer.get())->mapped_buffer();
+  }
+
+  // EncodeFrame() of stock openh264 rejects every iColorFormat but I420,
+  // although SetOption(ENCODER_OPTION_DATAFORMAT) takes any format. NV12
+  // and the other formats go through the memoized ToI420(), so a frame
+  // shared by several streams is converted once.
+  std::shared_ptr<I420BufferInterface> i420_buffer = buffer->ToI420();
+  if (!i420_buffer) {
     AVE_LOG(LS_ERROR) << "Failed to convert frame buffer to I420";
     return BAD_VALUE;
   }
   AVE_CHECK(
-      frame_buffer->pixel_format() == VideoFrameBuffer::PixelFormat::kI420 ||
-      frame_buffer->pixel_format() == VideoFrameBuffer::PixelFormat::kI420A);
+      i420_buffer->pixel_format() == VideoFrameBuffer::PixelFormat::kI420 ||
+      i420_buffer->pixel_format() == VideoFrameBuffer::PixelFormat::kI420A);
 
   bool send_key_frame = false;
   if (configuration_.key_frame_request && configuration_.sending) {
@@ -157,19 +212,36 @@ status_t OpenH264Encoder::Encode(const std::shared_ptr<VideoFrame>& frame) {
     configuration_.key_frame_request = false;
   }
 
+  // the crop rect is applied in place, by pointing the picture planes into
+  // the buffer, so cropping costs no copy
+  const VideoFrame::Rect rect = frame->aligned_rect();
+  if (static_cast<int>(rect.width) != configuration_.width ||
+      static_cast<int>(rect.height) != configuration_.height) {
+    AVE_LOG(LS_ERROR) << "frame crop [" << rect.width << ", " << rect.height
+                      << "] mismatch encoder [" << configuration_.width
+                      << ", " << configuration_.height << "]";
+    return BAD_VALUE;
+  }
+  const size_t chroma_x = rect.offset_x / 2;
+  const size_t chroma_y = rect.offset_y / 2;
+
   picture_ = {0};
   picture_.iPicWidth = configuration_.width;
   picture_.iPicHeight = configuration_.height;
   picture_.iColorFormat = videoFormatI420;
   picture_.uiTimeStamp = frame->timestamp_us() / 1000;
 
-  picture_.iStride[0] = frame_buffer->StrideY();
-  picture_.iStride[1] = frame_buffer->StrideU();
-  picture_.iStride[2] = frame_buffer->StrideV();
+  picture_.iStride[0] = i420_buffer->StrideY();
+  picture_.iStride[1] = i420_buffer->StrideU();
+  picture_.iStride[2] = i420_buffer->StrideV();
 
-  picture_.pData[0] = const_cast<uint8_t*>(frame_buffer->DataY());
-  picture_.pData[1] = const_cast<uint8_t*>(frame_buffer->DataU());
-  picture_.pData[2] = const_cast<uint8_t*>(frame_buffer->DataV());
+  picture_.pData[0] = const_cast<uint8_t*>(
+      i420_buffer->DataY() + rect.offset_y * i420_buffer->StrideY() +
+      rect.offset_x);
+  picture_.pData[1] = const_cast<uint8_t*>(
+      i420_buffer->DataU() + chroma_y * i420_buffer->StrideU() + chroma_x);
+  picture_.pData[2] = const_cast<uint8_t*>(
+      i420_buffer->DataV() + chroma_y * i420_buffer->StrideV() + chroma_x);
 
   // EncodeFrame output.
   SFrameBSInfo info;
@@ -182,6 +254,8 @@ status_t OpenH264Encoder::Encode(const std::shared_ptr<VideoFrame>& frame) {
                       << enc_ret << ".";
     return UNKNOWN_ERROR;
   }
+  metadata->SetStageTime(FrameMetadata::Stage::kEncodeFinish,
+                         Looper::getNowUs());
 
   // AVE_LOG(LS_VERBOSE) << "encode, pts:" << picture_.uiTimeStamp
   //                 << ", size:" << info.iFrameSizeInBytes
@@ -190,6 +264,7 @@ status_t OpenH264Encoder::Encode(const std::shared_ptr<VideoFrame>& frame) {
   encoded_image_.encoded_width_ = configuration_.width;
   encoded_image_.encoded_height_ = configuration_.height;
   encoded_image_.SetTimestamp(frame->timestamp_us());
+  encoded_image_.SetMetadata(metadata);
   encoded_image_.frame_type_ = ConvertToVideoFrameType(info.eFrameType);
 
   PacketizeEncodedImage(&encoded_image_, &info);
@@ -215,7 +290,9 @@ void OpenH264Encoder::PacketizeEncodedImage(EncodedImage* image,
     }
   }
 
-  auto buffer = EncodedImageBuffer::Create(required_capacity);
+  // let go of the last frame first, the pool may hand its buffer back
+  image->ClearEncodedData();
+  auto buffer = buffer_pool_.Acquire(required_capacity);
   image->SetEncodedData(buffer);
 
   const uint8_t start_code[4] = {0, 0, 0, 1};
@@ -242,6 +319,68 @@ void OpenH264Encoder::PacketizeEncodedImage(EncodedImage* image,
   // AVE_LOG(LS_VERBOSE) << "PacketEncodedImage, pts:" <<
   // encoded_image_.timestamp_us_
   //                 << ", size:" << encoded_image_.Size();
+  MaybeLogBufferPoolStats();
+}
+
+void OpenH264Encoder::MaybeLogBufferPoolStats() {
+  const int64_t now_us = Looper::getNowUs();
+  if (pool_stats_time_us_ == 0) {
+    pool_stats_time_us_ = now_us;
+    return;
+  }
+  if (now_us - pool_stats_time_us_ < kPoolStatsIntervalUs) {
+    return;
+  }
+  const EncodedImageBufferPool::Stats stats = buffer_pool_.stats();
+  AVE_LOG(LS_INFO) << "encoded buffer pool, allocations/s:"
+                   << (stats.allocations - pool_stats_allocations_) * 1e6 /
+                          (now_us - pool_stats_time_us_)
+                   << ", hits:" << stats.hits
+                   << ", allocations:" << stats.allocations
+                   << ", buffers:" << stats.buffers
+                   << ", high water mark:" << stats.high_water_mark;
+  pool_stats_time_us_ = now_us;
+  pool_stats_allocations_ = stats.allocations;
+}
+
+void OpenH264Encoder::SetRates(const RateControlParameters& parameters) {
+  if (encoder_ == nullptr) {
+    return;
+  }
+  if (parameters.bitrate_bps == 0) {
+    configuration_.SetStreamState(false);
+    return;
+  }
+
+  uint32_t target_bps = parameters.bitrate_bps;
+  if (configuration_.max_bps > 0) {
+    target_bps = std::clamp(target_bps, configuration_.min_bps,
+                            configuration_.max_bps);
+  }
+  if (target_bps != configuration_.target_bps) {
+    SBitrateInfo bitrate_info;
+    bitrate_info.iLayer = SPATIAL_LAYER_ALL;
+    bitrate_info.iBitrate = static_cast<int>(target_bps);
+    if (encoder_->SetOption(ENCODER_OPTION_BITRATE, &bitrate_info) != 0) {
+      AVE_LOG(LS_ERROR) << "Failed to set openh264 bitrate " << target_bps;
+    } else {
+      configuration_.target_bps = target_bps;
+    }
+  }
+
+  const float frame_rate = static_cast<float>(parameters.framerate_fps);
+  if (frame_rate > 0 && frame_rate != configuration_.max_frame_rate) {
+    float max_frame_rate = frame_rate;
+    if (encoder_->SetOption(ENCODER_OPTION_FRAME_RATE, &max_frame_rate) != 0) {
+      AVE_LOG(LS_ERROR) << "Failed to set openh264 frame rate " << frame_rate;
+    } else {
+      configuration_.max_frame_rate = frame_rate;
+    }
+  }
+
+  configuration_.SetStreamState(true);
+  AVE_LOG(LS_VERBOSE) << "SetRates, bitrate:" << configuration_.target_bps
+                      << ", frame rate:" << configuration_.max_frame_rate;
 }
 
 void OpenH264Encoder::RequestKeyFrame() {
@@ -261,19 +400,21 @@ SEncParamExt OpenH264Encoder::CreateEncoderParams() const {
 
   encoder_params.iPicWidth = configuration_.width;
   encoder_params.iPicHeight = configuration_.height;
-  encoder_params.iTargetBitrate = configuration_.target_bps * 1000;
+  encoder_params.iTargetBitrate = configuration_.target_bps;
+  encoder_params.iMaxBitrate = configuration_.max_bps > 0
+                                   ? configuration_.max_bps
+                                   : UNSPECIFIED_BIT_RATE;
 
-  // encoder_params.iMaxBitrate = configuration_.max_bps;
-  encoder_params.iMaxBitrate = UNSPECIFIED_BIT_RATE;
-
-  encoder_params.iRCMode = RC_BITRATE_MODE;
-  // encoder_params.fMaxFrameRate = configuration_.max_frame_rate;
-  encoder_params.fMaxFrameRate = 20;
+  encoder_params.iRCMode = ConvertToRCMode(configuration_.rate_control_mode);
+  encoder_params.fMaxFrameRate = configuration_.max_frame_rate;
 
   encoder_params.bEnableFrameSkip = configuration_.frame_dropping_on;
   encoder_params.uiIntraPeriod = configuration_.key_frame_interval;
 
-  encoder_params.iMultipleThreadIdc = number_of_cores_;
+  const int threads =
+      NumberOfThreads(configuration_.width, configuration_.height,
+                      number_of_cores_);
+  encoder_params.iMultipleThreadIdc = threads;
 
   encoder_params.eSpsPpsIdStrategy = SPS_LISTING;
   encoder_params.uiMaxNalSize = 0;
@@ -317,11 +458,21 @@ SEncParamExt OpenH264Encoder::CreateEncoderParams() const {
   }
   AVE_LOG(LS_INFO) << "OpenH264 version is " << OPENH264_MAJOR << "."
                    << OPENH264_MINOR;
-  encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceNum = 1;
-  encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceMode =
-      SM_SIZELIMITED_SLICE;
-  encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceSizeConstraint =
-      static_cast<unsigned int>(max_payload_size_);
+  SSliceArgument& slice_argument =
+      encoder_params.sSpatialLayers[0].sSliceArgument;
+  if (threads > 1) {
+    // one slice per thread, rtsp fragments the large nal units
+    slice_argument.uiSliceNum = threads;
+    slice_argument.uiSliceMode = SM_FIXEDSLCNUM_SLICE;
+  } else {
+    slice_argument.uiSliceNum = 1;
+    slice_argument.uiSliceMode = SM_SIZELIMITED_SLICE;
+    slice_argument.uiSliceSizeConstraint =
+        static_cast<unsigned int>(max_payload_size_);
+  }
+  AVE_LOG(LS_INFO) << "openh264 threads:" << threads << " of "
+                   << number_of_cores_ << " cores, slices:"
+                   << slice_argument.uiSliceNum;
 
   return encoder_params;
 }
@@ -8,6 +8,7 @@
 #ifndef AVE_VIDEO_CODECS_OPENH264_ENCODER_H
 #define AVE_VIDEO_CODECS_OPENH264_ENCODER_H
 
+#include "api/video/encoded_image_buffer_pool.h"
 #include "common/video_codec_property.h"
 #include "modules/video_coding/codecs/h264/h264.h"
 #include "third_party/openh264/src/codec/api/svc/codec_api.h"
@@ -29,6 +30,8 @@ class OpenH264Encoder : public H264Encoder {
 
   status_t Encode(const std::shared_ptr<VideoFrame>& frame) override;
 
+  void SetRates(const RateControlParameters& parameters) override;
+
   void RequestKeyFrame() override;
 
  private:
@@ -40,7 +43,9 @@ class OpenH264Encoder : public H264Encoder {
     bool key_frame_request = false;
     float max_frame_rate = 0;
     uint32_t target_bps = 0;
+    uint32_t min_bps = 0;
     uint32_t max_bps = 0;
+    RateControlMode rate_control_mode = RateControlMode::kBitrate;
     bool frame_dropping_on = false;
     int key_frame_interval = 0;
     int num_temporal_layers = 1;
@@ -50,6 +55,8 @@ class OpenH264Encoder : public H264Encoder {
 
   SEncParamExt CreateEncoderParams() const;
   void PacketizeEncodedImage(EncodedImage* encoded_image, SFrameBSInfo* info);
+  // logs the output buffer allocations per second now and then
+  void MaybeLogBufferPoolStats();
 
   size_t max_payload_size_;
   int32_t number_of_cores_;
@@ -60,6 +67,10 @@ class OpenH264Encoder : public H264Encoder {
   // rtc::scoped_refptr<I420Buffer>> downscaled_buffers_;
   LayerConfig configuration_;
   EncodedImage encoded_image_;
+  // output buffers, the rtsp queue holds them after Encode() returned
+  EncodedImageBufferPool buffer_pool_;
+  int64_t pool_stats_time_us_;
+  uint64_t pool_stats_allocations_;
 
   EncodedImageCallback* encoded_image_callback_;
 };
@@ -0,0 +1,161 @@
+/*
+ * openh264_encoder_benchmark.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+// Encode throughput of OpenH264Encoder for each core count it may use, at
+// the size of the bundled data/h264.bin clip and the 720p/1080p streams.
+//
+//   openh264_encoder_benchmark [frames]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "api/video/encoded_image.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "base/logging.h"
+#include "common/video_codec_property.h"
+#include "modules/video_coding/codecs/h264/openh264_encoder.h"
+
+using namespace ave;
+
+namespace {
+
+constexpr int kDefaultFrames = 150;
+constexpr int kFrameRate = 30;
+// distinct source frames, cycled so generating them is not measured
+constexpr int kSourceFrames = 16;
+
+struct Resolution {
+  const char* name;
+  size_t width;
+  size_t height;
+  uint32_t bitrate_kbps;
+};
+constexpr Resolution kResolutions[] = {
+    {"h264.bin", 960, 408, 1500},
+    {"720p", 1280, 720, 2500},
+    {"1080p", 1920, 1080, 4000},
+};
+
+class CountingCallback : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& image) override {
+    frames++;
+    bytes += image.Size();
+    return Result(Result::ENCODED_OK);
+  }
+
+  int frames = 0;
+  size_t bytes = 0;
+};
+
+// a gradient with a moving block, so each frame has motion to search
+std::vector<std::shared_ptr<I420Buffer>> CreateSourceFrames(size_t width,
+                                                            size_t height) {
+  std::vector<std::shared_ptr<I420Buffer>> buffers;
+  for (int i = 0; i < kSourceFrames; i++) {
+    auto buffer = I420Buffer::Create(width, height);
+    for (size_t y = 0; y < height; y++) {
+      uint8_t* row = buffer->MutableDataY() + y * buffer->StrideY();
+      for (size_t x = 0; x < width; x++) {
+        const bool block = (x + i * 16) % 256 < 64 && (y + i * 8) % 192 < 64;
+        row[x] = block ? 235 : static_cast<uint8_t>((x + y + i * 4) & 0xff);
+      }
+    }
+    for (size_t y = 0; y < buffer->ChromaHeight(); y++) {
+      memset(buffer->MutableDataU() + y * buffer->StrideU(), 128 + i,
+             buffer->ChromaWidth());
+      memset(buffer->MutableDataV() + y * buffer->StrideV(), 128 - i,
+             buffer->ChromaWidth());
+    }
+    buffers.push_back(buffer);
+  }
+  return buffers;
+}
+
+// encoded frames per second, 0 if the encoder failed
+double MeasureFps(const Resolution& resolution,
+                  const std::vector<std::shared_ptr<I420Buffer>>& sources,
+                  int number_of_cores,
+                  int frames) {
+  VideoCodecProperty property;
+  property.codec_id = CodecId::AV_CODEC_ID_H264;
+  property.mode = VideoCodecMode::kRealtimeVideo;
+  property.width = resolution.width;
+  property.height = resolution.height;
+  property.bit_rate = resolution.bitrate_kbps;
+  property.bit_rate_range.min = resolution.bitrate_kbps / 4;
+  property.bit_rate_range.max = resolution.bitrate_kbps * 2;
+  property.frame_rate = kFrameRate;
+  *property.H264() = VideoEncoder::GetDefaultH264Specific();
+
+  OpenH264Encoder encoder;
+  CountingCallback callback;
+  if (encoder.InitEncoder(property, VideoEncoder::Settings(
+                                        VideoEncoder::Capabilities(false),
+                                        number_of_cores, 10000)) != OK) {
+    return 0;
+  }
+  encoder.RegisterEncoderCompleteCallback(&callback);
+
+  const int64_t frame_interval_us = 1000 * 1000 / kFrameRate;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; i++) {
+    auto frame = std::make_shared<VideoFrame>(
+        i, sources[i % sources.size()], i * frame_interval_us, std::nullopt);
+    encoder.Encode(frame);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  encoder.Release();
+
+  const double seconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() /
+      1e6;
+  AVE_LOG(LS_INFO) << "    " << callback.frames << " frames, "
+                   << callback.bytes * 8 / 1000 * kFrameRate /
+                          std::max(callback.frames, 1)
+                   << " kbps";
+  return seconds > 0 ? callback.frames / seconds : 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  ave::base::LogMessage::LogToDebug(LS_INFO);
+
+  const int frames = argc > 1 ? std::max(1, atoi(argv[1])) : kDefaultFrames;
+  const int detected_cores = VideoEncoder::DetectNumberOfCores();
+  std::vector<int> core_counts;
+  for (int cores = 1; cores < detected_cores; cores *= 2) {
+    core_counts.push_back(cores);
+  }
+  core_counts.push_back(detected_cores);
+
+  AVE_LOG(LS_INFO) << detected_cores << " usable cores, " << frames
+                   << " frames";
+  for (const auto& resolution : kResolutions) {
+    const auto sources =
+        CreateSourceFrames(resolution.width, resolution.height);
+    AVE_LOG(LS_INFO) << resolution.name << " " << resolution.width << "x"
+                     << resolution.height;
+    double single_core_fps = 0;
+    for (int cores : core_counts) {
+      const double fps = MeasureFps(resolution, sources, cores, frames);
+      if (cores == 1) {
+        single_core_fps = fps;
+      }
+      AVE_LOG(LS_INFO) << "  " << cores << " cores: " << fps << " fps, x"
+                       << (single_core_fps > 0 ? fps / single_core_fps : 0);
+    }
+  }
+
+  return 0;
+}
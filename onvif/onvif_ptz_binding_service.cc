@@ -9,7 +9,9 @@
 
 #include "ServiceContext.h"
 #include "base/logging.h"
+#include "media/video/digital_ptz.h"
 #include "onvif_server.h"
+#include "ptz_backend.h"
 #include "smacros.h"
 #include "stools.h"
 
@@ -20,6 +22,50 @@ OnvifPTZBindingService::OnvifPTZBindingService(struct soap* soap)
 
 OnvifPTZBindingService::~OnvifPTZBindingService() {}
 
+DigitalPTZ* OnvifPTZBindingService::digital_ptz() {
+  OnvifServer* server = (OnvifServer*)this->soap->user;
+  return server->digital_ptz_.get();
+}
+
+PTZBackend* OnvifPTZBindingService::ptz_backend() {
+  OnvifServer* server = (OnvifServer*)this->soap->user;
+  return server->ptz_backend_.get();
+}
+
+namespace {
+// how long a RelativeMove step runs the motors
+constexpr int64_t kRelativeMoveUs = 300 * 1000;
+
+// the pan and tilt moves `direction` asks for
+void ExecuteMoves(PTZBackend* backend,
+                  const tt__Vector2D* direction,
+                  int64_t stop_after_us) {
+  if (direction->x > 0) {
+    backend->Execute({PTZBackend::Command::kRight, "", stop_after_us});
+  } else if (direction->x < 0) {
+    backend->Execute({PTZBackend::Command::kLeft, "", stop_after_us});
+  }
+  if (direction->y > 0) {
+    backend->Execute({PTZBackend::Command::kUp, "", stop_after_us});
+  } else if (direction->y < 0) {
+    backend->Execute({PTZBackend::Command::kDown, "", stop_after_us});
+  }
+}
+
+// the given components of `vector` over `position`
+DigitalPTZ::Position MergePosition(DigitalPTZ::Position position,
+                                   const tt__PTZVector* vector) {
+  if (vector != NULL && vector->PanTilt != NULL) {
+    position.pan = vector->PanTilt->x;
+    position.tilt = vector->PanTilt->y;
+  }
+  if (vector != NULL && vector->Zoom != NULL) {
+    position.zoom = vector->Zoom->x;
+  }
+  return position;
+}
+}  // namespace
+
 int OnvifPTZBindingService::GetServiceCapabilities(
     _tptz__GetServiceCapabilities* tptz__GetServiceCapabilities,
     _tptz__GetServiceCapabilitiesResponse&
@@ -62,6 +108,21 @@ int OnvifPTZBindingService::GetPresets(
 
   soap_default_std__vectorTemplateOfPointerTott__PTZPreset(
       soap, &tptz__GetPresetsResponse._tptz__GetPresetsResponse::Preset);
+  if (digital_ptz() != NULL) {
+    for (const auto& [token, position] : digital_ptz()->presets()) {
+      tt__PTZPreset* ptzp = soap_new_tt__PTZPreset(soap);
+      ptzp->token = soap_new_std__string(soap);
+      *ptzp->token = token;
+      ptzp->Name = soap_new_std__string(soap);
+      *ptzp->Name = token;
+      ptzp->PTZPosition = soap_new_tt__PTZVector(soap);
+      ptzp->PTZPosition->PanTilt =
+          soap_new_req_tt__Vector2D(soap, position.pan, position.tilt);
+      ptzp->PTZPosition->Zoom = soap_new_req_tt__Vector1D(soap, position.zoom);
+      tptz__GetPresetsResponse.Preset.push_back(ptzp);
+    }
+    return SOAP_OK;
+  }
   for (int i = 0; i < 8; i++) {
     tt__PTZPreset* ptzp;
     ptzp = soap_new_tt__PTZPreset(soap);
@@ -75,13 +136,32 @@ int OnvifPTZBindingService::GetPresets(
 int OnvifPTZBindingService::SetPreset(
     _tptz__SetPreset* tptz__SetPreset,
     _tptz__SetPresetResponse& tptz__SetPresetResponse) {
-  SOAP_EMPTY_HANDLER(tptz__SetPreset, "PTZ");
+  if (digital_ptz() == NULL || tptz__SetPreset == NULL) {
+    SOAP_EMPTY_HANDLER(tptz__SetPreset, "PTZ");
+  }
+  AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
+
+  std::string token;
+  if (tptz__SetPreset->PresetToken != NULL) {
+    token = *tptz__SetPreset->PresetToken;
+  }
+  tptz__SetPresetResponse.PresetToken = digital_ptz()->SetPreset(token);
+  if (tptz__SetPresetResponse.PresetToken.empty()) {
+    return soap_receiver_fault(soap, "too many presets", NULL);
+  }
+  return SOAP_OK;
 }
 
 int OnvifPTZBindingService::RemovePreset(
     _tptz__RemovePreset* tptz__RemovePreset,
     _tptz__RemovePresetResponse& tptz__RemovePresetResponse) {
-  SOAP_EMPTY_HANDLER(tptz__RemovePreset, "PTZ");
+  if (digital_ptz() == NULL || tptz__RemovePreset == NULL) {
+    SOAP_EMPTY_HANDLER(tptz__RemovePreset, "PTZ");
+  }
+  AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
+
+  digital_ptz()->RemovePreset(tptz__RemovePreset->PresetToken);
+  return SOAP_OK;
 }
 
 int OnvifPTZBindingService::GotoPreset(
@@ -90,11 +170,6 @@ int OnvifPTZBindingService::GotoPreset(
   UNUSED(tptz__GotoPresetResponse);
   AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
 
-  std::string preset_cmd;
-
-  OnvifServer* server = (OnvifServer*)this->soap->user;
-  ServiceContext* ctx = (ServiceContext*)server->service_info_.get();
-
   if (tptz__GotoPreset == NULL) {
     return SOAP_OK;
   }
@@ -105,30 +180,46 @@ int OnvifPTZBindingService::GotoPreset(
     return SOAP_OK;
   }
 
-  if (!ctx->get_ptz_node()->get_move_preset().empty()) {
-    preset_cmd = ctx->get_ptz_node()->get_move_preset().c_str();
-  } else {
+  if (digital_ptz() != NULL) {
+    if (!digital_ptz()->GotoPreset(tptz__GotoPreset->PresetToken)) {
+      AVE_LOG(LS_WARNING) << "unknown ptz preset "
+                          << tptz__GotoPreset->PresetToken;
+    }
     return SOAP_OK;
   }
 
-  std::string template_str_t("%t");
-
-  auto it_t = preset_cmd.find(template_str_t, 0);
-
-  if (it_t != std::string::npos) {
-    preset_cmd.replace(it_t, template_str_t.size(),
-                       tptz__GotoPreset->PresetToken.c_str());
+  if (ptz_backend() != NULL) {
+    ptz_backend()->Execute(
+        {PTZBackend::Command::kPreset, tptz__GotoPreset->PresetToken});
   }
 
-  system(preset_cmd.c_str());
-
   return SOAP_OK;
 }
 
 int OnvifPTZBindingService::GetStatus(
     _tptz__GetStatus* tptz__GetStatus,
     _tptz__GetStatusResponse& tptz__GetStatusResponse) {
-  SOAP_EMPTY_HANDLER(tptz__GetStatus, "PTZ");
+  if (digital_ptz() == NULL) {
+    SOAP_EMPTY_HANDLER(tptz__GetStatus, "PTZ");
+  }
+  UNUSED(tptz__GetStatus);
+
+  const DigitalPTZ::Position position = digital_ptz()->position();
+  tt__PTZStatus* status = soap_new_tt__PTZStatus(soap);
+  status->Position = soap_new_tt__PTZVector(soap);
+  status->Position->PanTilt =
+      soap_new_req_tt__Vector2D(soap, position.pan, position.tilt);
+  status->Position->Zoom = soap_new_req_tt__Vector1D(soap, position.zoom);
+  status->MoveStatus = soap_new_tt__PTZMoveStatus(soap);
+  status->MoveStatus->PanTilt =
+      (enum tt__MoveStatus*)soap_malloc(soap, sizeof(enum tt__MoveStatus));
+  *status->MoveStatus->PanTilt = digital_ptz()->moving()
+                                     ? tt__MoveStatus__MOVING
+                                     : tt__MoveStatus__IDLE;
+  status->MoveStatus->Zoom = status->MoveStatus->PanTilt;
+  status->UtcTime = time(NULL);
+  tptz__GetStatusResponse.PTZStatus = status;
+  return SOAP_OK;
 }
 
 int OnvifPTZBindingService::GetConfiguration(
@@ -275,11 +366,6 @@ int OnvifPTZBindingService::GotoHomePosition(
   UNUSED(tptz__GotoHomePositionResponse);
   AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
 
-  std::string preset_cmd;
-
-  OnvifServer* server = (OnvifServer*)this->soap->user;
-  ServiceContext* ctx = (ServiceContext*)server->service_info_.get();
-
   if (tptz__GotoHomePosition == NULL) {
     return SOAP_OK;
   }
@@ -287,29 +373,30 @@ int OnvifPTZBindingService::GotoHomePosition(
     return SOAP_OK;
   }
 
-  if (!ctx->get_ptz_node()->get_move_preset().empty()) {
-    preset_cmd = ctx->get_ptz_node()->get_move_preset().c_str();
-  } else {
+  if (digital_ptz() != NULL) {
+    digital_ptz()->GotoHomePosition();
     return SOAP_OK;
   }
 
-  std::string template_str_t("%t");
-
-  auto it_t = preset_cmd.find(template_str_t, 0);
-
-  if (it_t != std::string::npos) {
-    preset_cmd.replace(it_t, template_str_t.size(), "1");
+  // preset 1 is home
+  if (ptz_backend() != NULL) {
+    ptz_backend()->Execute({PTZBackend::Command::kPreset, "1"});
   }
 
-  system(preset_cmd.c_str());
-
   return SOAP_OK;
 }
 
 int OnvifPTZBindingService::SetHomePosition(
     _tptz__SetHomePosition* tptz__SetHomePosition,
     _tptz__SetHomePositionResponse& tptz__SetHomePositionResponse) {
-  SOAP_EMPTY_HANDLER(tptz__SetHomePosition, "PTZ");
+  if (digital_ptz() == NULL) {
+    SOAP_EMPTY_HANDLER(tptz__SetHomePosition, "PTZ");
+  }
+  UNUSED(tptz__SetHomePosition);
+  AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
+
+  digital_ptz()->SetHomePosition();
+  return SOAP_OK;
 }
 
 int OnvifPTZBindingService::ContinuousMove(
@@ -318,30 +405,29 @@ int OnvifPTZBindingService::ContinuousMove(
   UNUSED(tptz__ContinuousMoveResponse);
   AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
 
-  OnvifServer* server = (OnvifServer*)this->soap->user;
-  ServiceContext* ctx = (ServiceContext*)server->service_info_.get();
-
   if (tptz__ContinuousMove == NULL) {
     return SOAP_OK;
   }
   if (tptz__ContinuousMove->Velocity == NULL) {
     return SOAP_OK;
   }
-  if (tptz__ContinuousMove->Velocity->PanTilt == NULL) {
+
+  if (digital_ptz() != NULL) {
+    const tt__PTZSpeed* velocity = tptz__ContinuousMove->Velocity;
+    digital_ptz()->ContinuousMove(
+        velocity->PanTilt ? velocity->PanTilt->x : 0,
+        velocity->PanTilt ? velocity->PanTilt->y : 0,
+        velocity->Zoom ? velocity->Zoom->x : 0);
     return SOAP_OK;
   }
 
-  if (tptz__ContinuousMove->Velocity->PanTilt->x > 0) {
-    system(ctx->get_ptz_node()->get_move_right().c_str());
-  } else if (tptz__ContinuousMove->Velocity->PanTilt->x < 0) {
-    system(ctx->get_ptz_node()->get_move_left().c_str());
-  }
-  if (tptz__ContinuousMove->Velocity->PanTilt->y > 0) {
-    system(ctx->get_ptz_node()->get_move_up().c_str());
-  } else if (tptz__ContinuousMove->Velocity->PanTilt->y < 0) {
-    system(ctx->get_ptz_node()->get_move_down().c_str());
+  if (tptz__ContinuousMove->Velocity->PanTilt == NULL ||
+      ptz_backend() == NULL) {
+    return SOAP_OK;
   }
 
+  ExecuteMoves(ptz_backend(), tptz__ContinuousMove->Velocity->PanTilt, 0);
+
   return SOAP_OK;
 }
 
@@ -351,38 +437,27 @@ int OnvifPTZBindingService::RelativeMove(
   UNUSED(tptz__RelativeMoveResponse);
   AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
 
-  OnvifServer* server = (OnvifServer*)this->soap->user;
-  ServiceContext* ctx = (ServiceContext*)server->service_info_.get();
-
   if (tptz__RelativeMove == NULL) {
     return SOAP_OK;
   }
   if (tptz__RelativeMove->Translation == NULL) {
     return SOAP_OK;
   }
-  if (tptz__RelativeMove->Translation->PanTilt == NULL) {
-    return SOAP_OK;
-  }
 
-  if (tptz__RelativeMove->Translation->PanTilt->x > 0) {
-    system(ctx->get_ptz_node()->get_move_right().c_str());
-    usleep(300000);
-    system(ctx->get_ptz_node()->get_move_stop().c_str());
-  } else if (tptz__RelativeMove->Translation->PanTilt->x < 0) {
-    system(ctx->get_ptz_node()->get_move_left().c_str());
-    usleep(300000);
-    system(ctx->get_ptz_node()->get_move_stop().c_str());
+  if (digital_ptz() != NULL) {
+    digital_ptz()->RelativeMove(
+        MergePosition(DigitalPTZ::Position(), tptz__RelativeMove->Translation));
+    return SOAP_OK;
   }
-  if (tptz__RelativeMove->Translation->PanTilt->y > 0) {
-    system(ctx->get_ptz_node()->get_move_up().c_str());
-    usleep(300000);
-    system(ctx->get_ptz_node()->get_move_stop().c_str());
-  } else if (tptz__RelativeMove->Translation->PanTilt->y < 0) {
-    system(ctx->get_ptz_node()->get_move_down().c_str());
-    usleep(300000);
-    system(ctx->get_ptz_node()->get_move_stop().c_str());
+  if (tptz__RelativeMove->Translation->PanTilt == NULL ||
+      ptz_backend() == NULL) {
+    return SOAP_OK;
   }
 
+  // a step is a short move, the backend stops it
+  ExecuteMoves(ptz_backend(), tptz__RelativeMove->Translation->PanTilt,
+               kRelativeMoveUs);
+
   return SOAP_OK;
 }
 
@@ -395,7 +470,14 @@ int OnvifPTZBindingService::SendAuxiliaryCommand(
 int OnvifPTZBindingService::AbsoluteMove(
     _tptz__AbsoluteMove* tptz__AbsoluteMove,
     _tptz__AbsoluteMoveResponse& tptz__AbsoluteMoveResponse) {
-  SOAP_EMPTY_HANDLER(tptz__AbsoluteMove, "PTZ");
+  if (digital_ptz() == NULL || tptz__AbsoluteMove == NULL) {
+    SOAP_EMPTY_HANDLER(tptz__AbsoluteMove, "PTZ");
+  }
+  AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
+
+  digital_ptz()->AbsoluteMove(MergePosition(digital_ptz()->position(),
+                                            tptz__AbsoluteMove->Position));
+  return SOAP_OK;
 }
 
 int OnvifPTZBindingService::Stop(_tptz__Stop* tptz__Stop,
@@ -404,10 +486,14 @@ int OnvifPTZBindingService::Stop(_tptz__Stop* tptz__Stop,
   UNUSED(tptz__StopResponse);
   AVE_LOG(LS_INFO) << "PTZ: " << __FUNCTION__;
 
-  OnvifServer* server = (OnvifServer*)this->soap->user;
-  ServiceContext* ctx = (ServiceContext*)server->service_info_.get();
+  if (digital_ptz() != NULL) {
+    digital_ptz()->Stop();
+    return SOAP_OK;
+  }
 
-  system(ctx->get_ptz_node()->get_move_stop().c_str());
+  if (ptz_backend() != NULL) {
+    ptz_backend()->Execute({PTZBackend::Command::kStop});
+  }
 
   return SOAP_OK;
 }
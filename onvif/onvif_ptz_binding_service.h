@@ -11,6 +11,9 @@
 #include "third_party/onvif_srvd/src/generated/soapPTZBindingService.h"
 
 namespace ave {
+class DigitalPTZ;
+class PTZBackend;
+
 class OnvifPTZBindingService : public PTZBindingService {
  public:
   OnvifPTZBindingService(struct soap* soap);
@@ -200,7 +203,10 @@ class OnvifPTZBindingService : public PTZBindingService {
       override;
 
  private:
-  /* data */
+  // the engine of the digital ptz mode, nullptr in command mode
+  DigitalPTZ* digital_ptz();
+  // runs the moves of the command mode, nullptr if it failed to open
+  PTZBackend* ptz_backend();
 };
 }  // namespace ave
 #endif /* !ONVIF_PTZ_BINDING_SERVICE_H */
@@ -15,6 +15,7 @@
 #include "onvif_device_binding_service.h"
 #include "onvif_media_binding_service.h"
 #include "onvif_ptz_binding_service.h"
+#include "ptz_backend.h"
 #include "third_party/onvif_srvd/src/generated/DeviceBinding.nsmap"
 #include "third_party/onvif_srvd/src/generated/soapH.h"
 #include "third_party/onvif_srvd/src/src/ServiceContext.h"
@@ -38,14 +39,17 @@ status_t convertConfig(ServiceContext* serviceContext, AppConfig* appConfig) {
     return UNKNOWN_ERROR;
   }
 
-  StreamProfile streamProfile;
-  noerr |= streamProfile.set_name(appConfig->name.c_str());
-  noerr |= streamProfile.set_width(std::to_string(appConfig->width).c_str());
-  noerr |= streamProfile.set_height(std::to_string(appConfig->height).c_str());
-  noerr |= streamProfile.set_url(appConfig->stream_url.c_str());
-  noerr |= streamProfile.set_snapurl(appConfig->snapurl.c_str());
-  noerr |= streamProfile.set_type(appConfig->stream_type.c_str());
-  noerr |= serviceContext->add_profile(streamProfile);
+  // one profile per stream tier, GetProfiles lists main and substreams
+  for (const auto& tier : appConfig->stream_tiers) {
+    StreamProfile streamProfile;
+    noerr |= streamProfile.set_name(tier.name.c_str());
+    noerr |= streamProfile.set_width(std::to_string(tier.width).c_str());
+    noerr |= streamProfile.set_height(std::to_string(tier.height).c_str());
+    noerr |= streamProfile.set_url(tier.stream_url.c_str());
+    noerr |= streamProfile.set_snapurl(appConfig->snapurl.c_str());
+    noerr |= streamProfile.set_type(appConfig->stream_type.c_str());
+    noerr |= serviceContext->add_profile(streamProfile);
+  }
 
   serviceContext->get_ptz_node()->enable = appConfig->ptz_enable;
   noerr |= serviceContext->get_ptz_node()->set_move_left(
@@ -88,6 +92,10 @@ OnvifServer::~OnvifServer() {
   looper_->stop();
 }
 
+void OnvifServer::SetDigitalPTZ(std::shared_ptr<DigitalPTZ> digital_ptz) {
+  digital_ptz_ = std::move(digital_ptz);
+}
+
 status_t OnvifServer::Init() {
   looper_->start();
   looper_->registerHandler(shared_from_this());
@@ -98,6 +106,13 @@ status_t OnvifServer::Init() {
     return err;
   }
 
+  if (app_config_.ptz_enable && digital_ptz_ == nullptr) {
+    ptz_backend_ = PTZBackend::Create(app_config_);
+    if (ptz_backend_ == nullptr) {
+      AVE_LOG(LS_WARNING) << "ptz backend unavailable, ptz moves ignored";
+    }
+  }
+
   if (!soap_valid_socket(
           soap_bind(soap_.get(), NULL, service_info_->port, 10))) {
     std::stringstream ss;
@@ -20,6 +20,8 @@ struct soap;
 class ServiceContext;
 namespace ave {
 
+class DigitalPTZ;
+class PTZBackend;
 class OnvifDeviceBindingService;
 class OnvifMediaBindingService;
 class OnvifPTZBindingService;
@@ -29,6 +31,10 @@ class OnvifServer : public Handler {
   OnvifServer(AppConfig appConfig, std::shared_ptr<Message> notify);
   virtual ~OnvifServer();
 
+  // serve the ptz service with `digital_ptz` instead of the move commands,
+  // set before Init()
+  void SetDigitalPTZ(std::shared_ptr<DigitalPTZ> digital_ptz);
+
   status_t Init();
   status_t Start();
   status_t Stop();
@@ -53,6 +59,9 @@ class OnvifServer : public Handler {
   std::unique_ptr<OnvifDeviceBindingService> device_service_;
   std::unique_ptr<OnvifMediaBindingService> media_service_;
   std::unique_ptr<OnvifPTZBindingService> ptz_service_;
+  std::shared_ptr<DigitalPTZ> digital_ptz_;
+  // moves the motors unless the ptz is digital
+  std::unique_ptr<PTZBackend> ptz_backend_;
 
   std::thread soap_thread_;
 
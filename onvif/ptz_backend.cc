@@ -0,0 +1,302 @@
+/*
+ * ptz_backend.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include "ptz_backend.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "app/app_config.h"
+#include "base/checks.h"
+#include "base/logging.h"
+#include "base/task_util/default_task_runner_factory.h"
+
+extern char** environ;
+
+namespace ave {
+
+namespace {
+
+bool IsPanMove(PTZBackend::Command command) {
+  return command == PTZBackend::Command::kLeft ||
+         command == PTZBackend::Command::kRight;
+}
+
+bool IsTiltMove(PTZBackend::Command command) {
+  return command == PTZBackend::Command::kUp ||
+         command == PTZBackend::Command::kDown;
+}
+
+// whether a queued request is pointless once `request` is queued after it
+bool Supersedes(const PTZBackend::Request& request,
+                const PTZBackend::Request& queued) {
+  switch (request.command) {
+    case PTZBackend::Command::kStop:
+      return true;
+    case PTZBackend::Command::kLeft:
+    case PTZBackend::Command::kRight:
+      return IsPanMove(queued.command);
+    case PTZBackend::Command::kUp:
+    case PTZBackend::Command::kDown:
+      return IsTiltMove(queued.command);
+    case PTZBackend::Command::kPreset:
+      return queued.command == PTZBackend::Command::kPreset;
+  }
+  return false;
+}
+
+speed_t BaudrateToSpeed(int baudrate) {
+  switch (baudrate) {
+    case 2400:
+      return B2400;
+    case 4800:
+      return B4800;
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+  }
+  AVE_LOG(LS_WARNING) << "unsupported ptz baudrate " << baudrate
+                      << ", use 9600";
+  return B9600;
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<PTZBackend> PTZBackend::Create(const AppConfig& config) {
+  if (config.ptz_backend == "device") {
+    auto backend = std::make_unique<DevicePTZBackend>(config);
+    if (!backend->Open(config.ptz_device, config.ptz_device_baudrate)) {
+      return nullptr;
+    }
+    return backend;
+  }
+  return std::make_unique<ScriptPTZBackend>(config);
+}
+
+PTZCommands::PTZCommands(const AppConfig& config)
+    : left(config.move_left),
+      right(config.move_right),
+      up(config.move_up),
+      down(config.move_down),
+      stop(config.move_stop),
+      preset(config.move_preset) {}
+
+std::string PTZCommands::Expand(PTZBackend::Command command,
+                                const std::string& preset_token) const {
+  switch (command) {
+    case PTZBackend::Command::kLeft:
+      return left;
+    case PTZBackend::Command::kRight:
+      return right;
+    case PTZBackend::Command::kUp:
+      return up;
+    case PTZBackend::Command::kDown:
+      return down;
+    case PTZBackend::Command::kStop:
+      return stop;
+    case PTZBackend::Command::kPreset: {
+      std::string expanded = preset;
+      const std::string token_template("%t");
+      auto pos = expanded.find(token_template);
+      if (pos != std::string::npos) {
+        expanded.replace(pos, token_template.size(), preset_token);
+      }
+      return expanded;
+    }
+  }
+  return std::string();
+}
+
+QueuedPTZBackend::QueuedPTZBackend()
+    : draining_(false),
+      stopped_(false),
+      task_runner_factory_(base::CreateDefaultTaskRunnerFactory()),
+      task_runner_(std::make_unique<base::TaskRunner>(
+          task_runner_factory_->CreateTaskRunner(
+              "PTZBackend",
+              base::TaskRunnerFactory::Priority::NORMAL))) {}
+
+QueuedPTZBackend::~QueuedPTZBackend() {
+  Shutdown();
+}
+
+void QueuedPTZBackend::Execute(Request request) {
+  lock_guard l(&lock_);
+  if (stopped_) {
+    return;
+  }
+  CoalesceLocked(request);
+  pending_.push_back(std::move(request));
+  if (!draining_) {
+    draining_ = true;
+    task_runner_->PostTask([this]() { Drain(); });
+  }
+}
+
+QueuedPTZBackend::Stats QueuedPTZBackend::stats() const {
+  lock_guard l(&lock_);
+  return stats_;
+}
+
+void QueuedPTZBackend::Shutdown() {
+  {
+    lock_guard l(&lock_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+    pending_.clear();
+  }
+  // waits for the running Drain()
+  task_runner_.reset();
+}
+
+void QueuedPTZBackend::Drain() {
+  while (true) {
+    Request request;
+    {
+      lock_guard l(&lock_);
+      if (pending_.empty()) {
+        draining_ = false;
+        return;
+      }
+      request = std::move(pending_.front());
+      pending_.pop_front();
+      stats_.executed++;
+    }
+
+    Run(request.command, request.preset);
+    if (request.stop_after_us > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(request.stop_after_us));
+      Run(Command::kStop, std::string());
+    }
+  }
+}
+
+void QueuedPTZBackend::CoalesceLocked(const Request& request) {
+  const size_t queued = pending_.size();
+  pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                [&request](const Request& queued_request) {
+                                  return Supersedes(request, queued_request);
+                                }),
+                 pending_.end());
+  stats_.coalesced += queued - pending_.size();
+}
+
+ScriptPTZBackend::ScriptPTZBackend(const AppConfig& config)
+    : commands_(config) {}
+
+ScriptPTZBackend::~ScriptPTZBackend() {
+  Shutdown();
+}
+
+void ScriptPTZBackend::Run(Command command, const std::string& preset) {
+  const std::string script = commands_.Expand(command, preset);
+  if (script.empty()) {
+    return;
+  }
+
+  const char* argv[] = {"sh", "-c", script.c_str(), nullptr};
+  pid_t pid;
+  int err = posix_spawn(&pid, "/bin/sh", nullptr, nullptr,
+                        const_cast<char* const*>(argv), environ);
+  if (err != 0) {
+    AVE_LOG(LS_ERROR) << "failed to spawn ptz command \"" << script
+                      << "\", errno:" << err;
+    return;
+  }
+
+  // one at a time, so the commands reach the motors in order
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      AVE_LOG(LS_ERROR) << "failed to wait ptz command, errno:" << errno;
+      return;
+    }
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    AVE_LOG(LS_WARNING) << "ptz command \"" << script
+                        << "\" failed, status:" << status;
+  }
+}
+
+DevicePTZBackend::DevicePTZBackend(const AppConfig& config)
+    : commands_(config), fd_(-1), is_tty_(false) {}
+
+DevicePTZBackend::~DevicePTZBackend() {
+  Shutdown();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool DevicePTZBackend::Open(const std::string& path, int baudrate) {
+  AVE_DCHECK_LT(fd_, 0);
+  fd_ = ::open(path.c_str(), O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) {
+    AVE_LOG(LS_ERROR) << "failed to open ptz device " << path
+                      << ", errno:" << errno;
+    return false;
+  }
+
+  is_tty_ = ::isatty(fd_);
+  if (is_tty_) {
+    termios tio;
+    if (::tcgetattr(fd_, &tio) < 0) {
+      AVE_LOG(LS_ERROR) << "failed to get ptz line settings, errno:" << errno;
+      return false;
+    }
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    const speed_t speed = BaudrateToSpeed(baudrate);
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+    if (::tcsetattr(fd_, TCSANOW, &tio) < 0) {
+      AVE_LOG(LS_ERROR) << "failed to set ptz line settings, errno:" << errno;
+      return false;
+    }
+  }
+  AVE_LOG(LS_INFO) << "ptz device " << path << (is_tty_ ? " (tty)" : "");
+  return true;
+}
+
+void DevicePTZBackend::Run(Command command, const std::string& preset) {
+  std::string line = commands_.Expand(command, preset);
+  if (line.empty()) {
+    return;
+  }
+  line += '\n';
+
+  // a sysfs attribute takes each value from its start
+  const ssize_t written =
+      is_tty_ ? ::write(fd_, line.data(), line.size())
+              : ::pwrite(fd_, line.data(), line.size(), 0);
+  if (written != static_cast<ssize_t>(line.size())) {
+    AVE_LOG(LS_ERROR) << "failed to write ptz command \"" << line
+                      << "\", errno:" << errno;
+  }
+}
+
+}  // namespace ave
@@ -0,0 +1,153 @@
+/*
+ * ptz_backend.h
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#ifndef PTZ_BACKEND_H
+#define PTZ_BACKEND_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "base/mutex.h"
+#include "base/task_util/task_runner.h"
+#include "base/task_util/task_runner_factory.h"
+#include "base/thread_annotation.h"
+
+namespace ave {
+
+struct AppConfig;
+
+// Drives the motors of a mechanical ptz for the onvif ptz service.
+class PTZBackend {
+ public:
+  enum class Command {
+    kLeft,
+    kRight,
+    kUp,
+    kDown,
+    kStop,
+    kPreset,
+  };
+
+  struct Request {
+    Command command = Command::kStop;
+    // preset token of kPreset
+    std::string preset;
+    // moves stop on their own after this long, 0 keeps moving
+    int64_t stop_after_us = 0;
+  };
+
+  // The backend `config` asks for, nullptr if it can't be set up.
+  static std::unique_ptr<PTZBackend> Create(const AppConfig& config);
+
+  virtual ~PTZBackend() = default;
+
+  // never blocks, the gSOAP thread serves every onvif client
+  virtual void Execute(Request request) = 0;
+};
+
+// The move_* strings of the config, "%t" in move_preset stands for the preset
+// token.
+struct PTZCommands {
+  explicit PTZCommands(const AppConfig& config);
+
+  // empty if nothing is configured for `command`
+  std::string Expand(PTZBackend::Command command,
+                     const std::string& preset) const;
+
+  std::string left;
+  std::string right;
+  std::string up;
+  std::string down;
+  std::string stop;
+  std::string preset;
+};
+
+// Runs requests in order on its own thread. Requests queued behind a running
+// one are coalesced: a stop drops the moves before it, a move replaces a
+// queued move of the same axis and a preset replaces a queued preset, so a
+// burst of ContinuousMove and Stop ends in one or two commands. This holds
+// for timed moves too, two RelativeMove steps on one axis queued in quick
+// succession collapse into one step, not two.
+class QueuedPTZBackend : public PTZBackend {
+ public:
+  struct Stats {
+    uint64_t executed = 0;
+    // requests dropped in favour of a later one
+    uint64_t coalesced = 0;
+  };
+
+  QueuedPTZBackend();
+  ~QueuedPTZBackend() override;
+
+  void Execute(Request request) override;
+
+  Stats stats() const;
+
+ protected:
+  // runs one command on the backend thread
+  virtual void Run(Command command, const std::string& preset) = 0;
+  // waits for the running command and drops the queued ones, subclasses
+  // call it first thing in their destructor so Run() is not called on a
+  // half destroyed object
+  void Shutdown();
+
+ private:
+  void Drain();
+  void CoalesceLocked(const Request& request) REQUIRES(lock_);
+
+  mutable Mutex lock_;
+  std::deque<Request> pending_ GUARDED_BY(lock_);
+  // a Drain() is posted or running
+  bool draining_ GUARDED_BY(lock_);
+  bool stopped_ GUARDED_BY(lock_);
+  Stats stats_ GUARDED_BY(lock_);
+
+  std::unique_ptr<base::TaskRunnerFactory> task_runner_factory_;
+  // last, so it stops before the queue goes away
+  std::unique_ptr<base::TaskRunner> task_runner_;
+};
+
+// Legacy mode, runs the configured move_* shell commands. They are started
+// with posix_spawn, which neither copies the page tables of the capture
+// buffers like fork() nor holds the gSOAP thread like system().
+class ScriptPTZBackend : public QueuedPTZBackend {
+ public:
+  explicit ScriptPTZBackend(const AppConfig& config);
+  ~ScriptPTZBackend() override;
+
+ protected:
+  void Run(Command command, const std::string& preset) override;
+
+ private:
+  const PTZCommands commands_;
+};
+
+// Writes the configured move_* strings as lines to a serial port, UART or
+// sysfs attribute, e.g. a pelco bridge or a gpio motor driver.
+class DevicePTZBackend : public QueuedPTZBackend {
+ public:
+  explicit DevicePTZBackend(const AppConfig& config);
+  ~DevicePTZBackend() override;
+
+  // opens the device, and sets up the line if it is a tty
+  bool Open(const std::string& path, int baudrate);
+
+ protected:
+  void Run(Command command, const std::string& preset) override;
+
+ private:
+  const PTZCommands commands_;
+  // only touched on the backend thread after Open()
+  int fd_;
+  bool is_tty_;
+};
+
+}  // namespace ave
+
+#endif /* !PTZ_BACKEND_H */
@@ -0,0 +1,172 @@
+/*
+ * ptz_backend_unittest.cc
+ * Copyright (C) 2023 youfa <vsyfar@gmail.com>
+ *
+ * Distributed under terms of the GPLv2 license.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "onvif/ptz_backend.h"
+#include "test/gtest.h"
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+namespace ave {
+using namespace std::chrono_literals;
+namespace {
+
+using Command = PTZBackend::Command;
+
+PTZBackend::Request CreateRequest(Command command,
+                                  int64_t stop_after_us = 0,
+                                  const std::string& preset = std::string()) {
+  PTZBackend::Request request;
+  request.command = command;
+  request.stop_after_us = stop_after_us;
+  request.preset = preset;
+  return request;
+}
+
+// Records the commands run. While the gate is closed Run() blocks, so the
+// requests executed meanwhile queue up behind the running one.
+class RecordingPTZBackend : public QueuedPTZBackend {
+ public:
+  RecordingPTZBackend() : open_(true) {}
+  ~RecordingPTZBackend() override {
+    OpenGate();
+    Shutdown();
+  }
+
+  void CloseGate() {
+    std::lock_guard<std::mutex> l(mutex_);
+    open_ = false;
+  }
+
+  void OpenGate() {
+    std::lock_guard<std::mutex> l(mutex_);
+    open_ = true;
+    cond_.notify_all();
+  }
+
+  // waits until `count` commands were run
+  bool WaitForRuns(size_t count) {
+    std::unique_lock<std::mutex> l(mutex_);
+    return cond_.wait_for(l, 1s, [&] { return commands_.size() >= count; });
+  }
+
+  std::vector<Command> commands() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return commands_;
+  }
+
+  std::vector<std::string> presets() {
+    std::lock_guard<std::mutex> l(mutex_);
+    return presets_;
+  }
+
+ protected:
+  void Run(Command command, const std::string& preset) override {
+    std::unique_lock<std::mutex> l(mutex_);
+    commands_.push_back(command);
+    if (command == Command::kPreset) {
+      presets_.push_back(preset);
+    }
+    cond_.notify_all();
+    cond_.wait(l, [this] { return open_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool open_;
+  std::vector<Command> commands_;
+  std::vector<std::string> presets_;
+};
+
+}  // namespace
+
+TEST(PTZBackendTest, StopDropsQueuedMoves) {
+  RecordingPTZBackend backend;
+  backend.CloseGate();
+
+  backend.Execute(CreateRequest(Command::kLeft));
+  ASSERT_TRUE(backend.WaitForRuns(1));
+  backend.Execute(CreateRequest(Command::kUp));
+  backend.Execute(CreateRequest(Command::kRight));
+  backend.Execute(CreateRequest(Command::kStop));
+  backend.OpenGate();
+
+  ASSERT_TRUE(backend.WaitForRuns(2));
+  EXPECT_EQ(backend.commands(),
+            (std::vector<Command>{Command::kLeft, Command::kStop}));
+  EXPECT_EQ(backend.stats().coalesced, 2u);
+}
+
+TEST(PTZBackendTest, MoveReplacesQueuedMoveOfSameAxis) {
+  RecordingPTZBackend backend;
+  backend.CloseGate();
+
+  backend.Execute(CreateRequest(Command::kLeft));
+  ASSERT_TRUE(backend.WaitForRuns(1));
+  // the pan moves replace each other, the tilt move stays
+  backend.Execute(CreateRequest(Command::kRight));
+  backend.Execute(CreateRequest(Command::kDown));
+  backend.Execute(CreateRequest(Command::kLeft));
+  backend.OpenGate();
+
+  ASSERT_TRUE(backend.WaitForRuns(3));
+  EXPECT_EQ(backend.commands(),
+            (std::vector<Command>{Command::kLeft, Command::kDown,
+                                  Command::kLeft}));
+  EXPECT_EQ(backend.stats().coalesced, 1u);
+}
+
+TEST(PTZBackendTest, PresetReplacesQueuedPreset) {
+  RecordingPTZBackend backend;
+  backend.CloseGate();
+
+  backend.Execute(CreateRequest(Command::kPreset, 0, "1"));
+  ASSERT_TRUE(backend.WaitForRuns(1));
+  backend.Execute(CreateRequest(Command::kPreset, 0, "2"));
+  backend.Execute(CreateRequest(Command::kPreset, 0, "3"));
+  backend.OpenGate();
+
+  ASSERT_TRUE(backend.WaitForRuns(2));
+  EXPECT_EQ(backend.presets(), (std::vector<std::string>{"1", "3"}));
+  EXPECT_EQ(backend.stats().coalesced, 1u);
+}
+
+TEST(PTZBackendTest, StopAfterUsStopsTheMove) {
+  RecordingPTZBackend backend;
+
+  backend.Execute(CreateRequest(Command::kUp, 1000));
+
+  ASSERT_TRUE(backend.WaitForRuns(2));
+  EXPECT_EQ(backend.commands(),
+            (std::vector<Command>{Command::kUp, Command::kStop}));
+}
+
+TEST(PTZBackendTest, QueuedRelativeStepsOfOneAxisCollapse) {
+  RecordingPTZBackend backend;
+  backend.CloseGate();
+
+  backend.Execute(CreateRequest(Command::kLeft, 1000));
+  ASSERT_TRUE(backend.WaitForRuns(1));
+  // two steps queued behind the running one run as one
+  backend.Execute(CreateRequest(Command::kRight, 1000));
+  backend.Execute(CreateRequest(Command::kRight, 1000));
+  backend.OpenGate();
+
+  ASSERT_TRUE(backend.WaitForRuns(4));
+  EXPECT_EQ(backend.commands(),
+            (std::vector<Command>{Command::kLeft, Command::kStop,
+                                  Command::kRight, Command::kStop}));
+  EXPECT_EQ(backend.stats().executed, 2u);
+  EXPECT_EQ(backend.stats().coalesced, 1u);
+}
+
+}  // namespace ave
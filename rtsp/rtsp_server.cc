@@ -26,7 +26,6 @@ RtspServer::RtspServer(std::shared_ptr<Message> notify)
       server_(xop::RtspServer::Create(event_loop_.get())),
       session_id_(-1),
       audio_queue_(std::make_shared<AudioQueue>()),
-      video_queue_(std::make_shared<VideoQueue>()),
       has_audio_(false),
       has_video_(false),
       started_(false) {
@@ -43,10 +42,18 @@ status_t RtspServer::Init() {
   looper_->start();
   looper_->registerHandler(shared_from_this());
 
-  xop::MediaSession* session = xop::MediaSession::CreateNew("live");
+  xop::MediaSession* session = CreateMediaSession("live");
   // session->AddSource(xop::channel_0, xop::H264Source::CreateNew());
   // session->AddSource(xop::channel_1, xop::AACSource::CreateNew(44100, 2));
 
+  media_session_ = session;
+  session_id_ = server_->AddSession(session);
+  return OK;
+}
+
+xop::MediaSession* RtspServer::CreateMediaSession(const std::string& name) {
+  xop::MediaSession* session = xop::MediaSession::CreateNew(name);
+
   session->AddNotifyConnectedCallback(
       [shared_this = shared_from_this()](xop::MediaSessionId sessionId,
                                          std::string peerIp,
@@ -69,9 +76,7 @@ status_t RtspServer::Init() {
     msg->post();
   });
 
-  media_session_ = session;
-  session_id_ = server_->AddSession(session);
-  return OK;
+  return session;
 }
 
 status_t RtspServer::Start() {
@@ -100,12 +105,15 @@ void RtspServer::RequestAudioSink(int32_t stream_id,
   msg->post();
 }
 
-void RtspServer::RequestVideoSink(int32_t stream_id, CodecId codec_id) {
+void RtspServer::RequestVideoSink(int32_t stream_id,
+                                  CodecId codec_id,
+                                  const std::string& session_name) {
   auto msg =
       std::make_shared<Message>(kWhatRequestVideoSink, shared_from_this());
 
   msg->setInt32("stream_id", stream_id);
   msg->setInt32("codec_format", static_cast<int32_t>(codec_id));
+  msg->setString("session_name", session_name);
   msg->post();
 }
 
@@ -193,18 +201,36 @@ void RtspServer::OnRequestVideoSink(const std::shared_ptr<Message>& msg) {
   AVE_CHECK(msg->findInt32("stream_id", &stream_id));
   int32_t codec_id;
   AVE_CHECK(msg->findInt32("codec_format", &codec_id));
+  std::string session_name;
+  AVE_CHECK(msg->findString("session_name", session_name));
 
   if (media_session_ == nullptr) {
     return;
   }
+  if (video_sessions_.find(stream_id) != video_sessions_.end()) {
+    AVE_LOG(LS_WARNING) << "video sink already exist, stream_id: "
+                        << stream_id;
+    return;
+  }
+
+  VideoSession video_session{session_id_, media_session_,
+                             std::make_shared<VideoQueue>()};
+  if (!session_name.empty() && session_name != "live") {
+    video_session.media_session = CreateMediaSession(session_name);
+    video_session.session_id =
+        server_->AddSession(video_session.media_session);
+  }
+
   CodecId codec = static_cast<CodecId>(codec_id);
   switch (codec) {
     case CodecId::AV_CODEC_ID_H264: {
-      media_session_->AddSource(xop::channel_0, xop::H264Source::CreateNew());
+      video_session.media_session->AddSource(xop::channel_0,
+                                             xop::H264Source::CreateNew());
       break;
     }
     case CodecId::AV_CODEC_ID_VP8: {
-      media_session_->AddSource(xop::channel_0, xop::VP8Source::CreateNew());
+      video_session.media_session->AddSource(xop::channel_0,
+                                             xop::VP8Source::CreateNew());
       break;
     }
 
@@ -214,16 +240,24 @@ void RtspServer::OnRequestVideoSink(const std::shared_ptr<Message>& msg) {
   }
 
   AVE_LOG(LS_INFO) << "add video sink, stream_id: " << stream_id
-                   << ", codec_id: " << codec_id;
+                   << ", codec_id: " << codec_id
+                   << ", session: " << session_name;
+
+  auto video_queue = video_session.video_queue;
+  video_sessions_.emplace(stream_id, std::move(video_session));
 
   auto notify = notify_->dup();
   notify->setInt32("what", kWhatVideoSinkAdded);
   notify->setInt32("stream_id", stream_id);
-  notify->setObject("encoded_video_sink", video_queue_);
+  notify->setObject("encoded_video_sink", video_queue);
   notify->post();
 
-  auto m = std::make_shared<Message>(kWhatPullVideo, shared_from_this());
-  m->post();
+  // one pull loop serves every video session
+  if (!has_video_) {
+    has_video_ = true;
+    auto m = std::make_shared<Message>(kWhatPullVideo, shared_from_this());
+    m->post();
+  }
 }
 
 void RtspServer::OnPullAudioSource() {
@@ -254,10 +288,14 @@ void RtspServer::OnPullAudioSource() {
 }
 
 void RtspServer::OnPullVideoSource() {
-  // get one from VideoQueue.queue
-  if (!video_queue_->queue().empty()) {
-    EncodedImage image = video_queue_->queue().front();
-    video_queue_->queue().pop();
+  // get one from each VideoQueue.queue
+  for (auto& [stream_id, video_session] : video_sessions_) {
+    auto& queue = video_session.video_queue->queue();
+    if (queue.empty()) {
+      continue;
+    }
+    EncodedImage image = queue.front();
+    queue.pop();
     xop::AVFrame frame = {0};
     frame.type = 0;
     frame.size = image.Size();
@@ -265,18 +303,33 @@ void RtspServer::OnPullVideoSource() {
     // AVE_CHECK(buffer->meta()->findInt64("timeUs", &pts));
     frame.timestamp = image.Timestamp() / 1000 * 90;
 
+    // capture to push, -1 if the image carries no capture time
+    int64_t latency_us = -1;
+    if (image.Metadata()) {
+      image.Metadata()->SetStageTime(FrameMetadata::Stage::kSend,
+                                     Looper::getNowUs());
+      latency_us = image.Metadata()
+                       ->StageDelta(FrameMetadata::Stage::kCapture,
+                                    FrameMetadata::Stage::kSend)
+                       .value_or(-1);
+    }
+
     if (image.frame_type_ == VideoFrameType::kVideoFrameKey) {
-      AVE_LOG(LS_INFO) << "OnPullVideoSource, queue.size:"
-                       << video_queue_->queue().size()
+      AVE_LOG(LS_INFO) << "OnPullVideoSource, stream_id:" << stream_id
+                       << ", queue.size:" << queue.size()
                        << ", image size: " << image.Size()
                        << ", timestamp_us: " << image.Timestamp()
-                       << ", frame_type:" << image.frame_type_;
+                       << ", frame_type:" << image.frame_type_
+                       << ", latency_us: " << latency_us;
+    } else {
+      AVE_LOG(LS_VERBOSE) << "OnPullVideoSource, stream_id:" << stream_id
+                          << ", latency_us: " << latency_us;
     }
 
     frame.buffer.reset(new uint8_t[frame.size]);
     memcpy(frame.buffer.get(), image.Data(), frame.size);
 
-    server_->PushFrame(session_id_, xop::channel_0, frame);
+    server_->PushFrame(video_session.session_id, xop::channel_0, frame);
   }
 
   std::lock_guard<std::mutex> l(mutex_);
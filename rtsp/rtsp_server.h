@@ -8,7 +8,9 @@
 #ifndef RTSPSERVER_H
 #define RTSPSERVER_H
 
+#include <map>
 #include <memory>
+#include <string>
 
 #include "api/audio/audio_sink_interface.h"
 #include "api/video/encoded_image.h"
@@ -57,7 +59,11 @@ class RtspServer : public Handler {
   status_t Start();
   status_t Stop();
 
-  void RequestVideoSink(int32_t stream_id, CodecId codec_id);
+  // each video stream gets its own session, `session_name` is the url suffix,
+  // empty for the default "live" session which also carries audio
+  void RequestVideoSink(int32_t stream_id,
+                        CodecId codec_id,
+                        const std::string& session_name = "");
   void RequestAudioSink(int32_t stream_id,
                         CodecId codec_id,
                         int sample_rate,
@@ -85,6 +91,14 @@ class RtspServer : public Handler {
   };
 
  private:
+  struct VideoSession {
+    xop::MediaSessionId session_id;
+    xop::MediaSession* media_session;
+    std::shared_ptr<VideoQueue> video_queue;
+  };
+
+  xop::MediaSession* CreateMediaSession(const std::string& name);
+
   void OnClientConnected(const std::shared_ptr<Message>& msg);
   void OnClientDisconnected(const std::shared_ptr<Message>& msg);
   void OnAddMediaSource(const std::shared_ptr<Message>& msg);
@@ -108,7 +122,8 @@ class RtspServer : public Handler {
   xop::MediaSession* media_session_;
 
   std::shared_ptr<AudioQueue> audio_queue_;
-  std::shared_ptr<VideoQueue> video_queue_;
+  // by stream id
+  std::map<int32_t, VideoSession> video_sessions_;
 
   bool has_audio_;
   bool has_video_;
@@ -7,6 +7,8 @@
 
 #include "frame_utils.h"
 
+#include "api/video/pixel_ops.h"
+
 namespace ave {
 namespace test {
 
@@ -16,14 +18,7 @@ bool EqualPlane(const uint8_t* data1,
                 int stride2,
                 int width,
                 int height) {
-  for (int i = 0; i < height; ++i) {
-    if (memcmp(data1, data2, width) != 0) {
-      return false;
-    }
-    data1 += stride1;
-    data2 += stride2;
-  }
-  return true;
+  return pixel_ops::PlaneEqual(data1, stride1, data2, stride2, width, height);
 }
 
 bool FramesEqual(const VideoFrame& f1, const VideoFrame& f2) {